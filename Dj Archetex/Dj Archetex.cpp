@@ -3,7 +3,7 @@ DJ Set Architect (ITCS 2530 Starter Project)
 Author: Yousif Triki
 
 Purpose (Original / Weeks 1-4):
-- Store DJ tracks in a small library (array of structs)
+- Store DJ tracks in a small library (array of structs; now the shared TrackManager)
 - View a formatted table summary
 - Recommend next tracks based on BPM + energy rules
 - Save a report to a text file
@@ -53,6 +53,69 @@ Week 09 Upgrade (Ch. 16 focus: Searching, Sorting, and the Vector Type):
   * Returns index or -1; no std::binary_search used
 - Doctests updated for all new functions including edge cases (empty vector, not found)
 
+Library Engine Upgrades (scaling past classroom-size libraries):
+- DynamicArray manages raw storage: placement construction, moves on growth/removal,
+  reserve() / shrinkToFit() / emplaceBack(), memcpy relocation for trivially copyable T
+- countingSortOrder(): O(n) stable BPM sort returning the permutation;
+  TrackManager::sortByBpm() applies it to items and bpmList together
+- Benchmarks: build with -DDJ_BENCHMARK (instead of _DEBUG) for timing runs
+- Sorted view (argsort) over TrackManager: findTrackByBpm() / findIndexesInBpmRange()
+  return real tracks in O(log n); the view is rebuilt lazily after changes
+- BpmBucketIndex: one bucket of track ids per BPM (60-200), kept current on add/remove;
+  TrackManager::recommendNext() visits only the 2N+1 buckets of a +/-N window
+- ColumnScanner: scalar / SSE4.1 / AVX2 kernels (picked at runtime) over packed 16-bit
+  BPM and energy columns; findAllBpm() returns every match, plus equality/range counts
+- TrackStore: structure-of-arrays storage (bpm, energy, type tag, key/genre/title ids)
+  replaces the bpmList mirror; hot scans never dereference TrackBase objects
+  (add/updateBpm throw DJException for a BPM outside 0..65535 instead of clamping it)
+- SlabPool<T>: TrackManager::emplaceLocal()/emplaceStream() build tracks in slab arenas
+  (one allocation per slab, free-list reuse, bulk release); counters via get*PoolStats()
+- SymbolTable / Symbol: genre, artist, key and platform are interned 32-bit ids;
+  countGenreMatches() and genre counts are integer compares
+- TrackId generational handles over a slot map: O(1) add/remove/lookup, stale-handle
+  detection; removal moves the last track into the gap (operator[] = dense order)
+- TableWriter: report tables (printAll, saveReport, printLibrary, saveReportToFile)
+  are laid out in a reused buffer and written in blocks instead of setw per cell;
+  output is byte-for-byte the same
+- OperationLog: write-ahead log of every TrackManager add/remove/edit (CRC32-checked
+  records, group-commit fsync); recoverLibrary() replays it over the snapshot and
+  LogCompactor folds it into a new snapshot on a background thread
+- XmlLibraryImporter: streaming pull parser (fixed buffer, no DOM) for Rekordbox
+  COLLECTION/TRACK and Traktor NML ENTRY exports; energy from star rating or colour
+  (menu option 13 picks it for .xml/.nml files)
+- TrackImporter: CSV/TSV bulk import (menu option 13; Quit moved to 14); the mapped
+  file is cut into line-aligned chunks parsed on the WorkStealingPool as string_views,
+  rows are checked with the prompt rules and rejected rows are reported by line
+- Binary snapshot: versioned file (header with LSN, fixed-width columns, string heap)
+  opened with mmap/MapViewOfFile; SnapshotView reads columns in place and decodes
+  strings lazily; TrackManager::saveSnapshot()/loadSnapshot(); the menu loads
+  DJ_Library.djsnap at startup and saves it on quit (startup still copies
+  every row into a track object; only SnapshotView readers skip that)
+- ScoredRecommender: top-K next tracks by one score (BPM distance, energy delta, key,
+  genre) in a bounded heap; buckets are visited nearest BPM first and the scan stops
+  once no farther bucket can beat the K-th score (TrackManager::topRecommendations())
+- TempoTolerance: +/-BPM or +/-% windows, 0.5x/2x half/double-time matching and a
+  pitch-fader limit; each ratio becomes one BPM bucket range (findTempoMatches())
+- NeighborIndex: per-track top-K "can follow" lists, updated incrementally on
+  add/remove/edit (only lists that contained a removed track are rebuilt)
+- EnergyArcPlanner: DP over (BPM, key) cells follows an exact energy curve with a BPM
+  step limit and no repeats; memory O(L x cells), independent of library size;
+  EnergyPlan::status tells an infeasible curve from a spent repair budget
+- WorkStealingPool + ParallelSetOptimizer: seeded beam searches on every core share a
+  top-k pruning bound and return the k best distinct setlists
+- SetBuilder: beam search over transition scores (BPM jump, KEY_COMPAT, energy arc)
+  builds a whole setlist from a start track (menu option 12; Quit moved to 13)
+- Harmonic keys: parseHarmonicKey() reads standard/Camelot/Open Key spellings into
+  ids 0..23; constexpr 24x24 KEY_COMPAT table filters recommendations by key
+- LibraryAggregates: BPM sum/min/max, per-genre/per-key/energy counts kept on every
+  add/remove/edit (average BPM and genre counts are O(1)); snapshot in saved reports
+- Energy histogram: one-pass SIMD LOW/MEDIUM/HIGH counts, O(1) countEnergy() from
+  incrementally kept totals; countHighEnergyRecursive splits in halves (log depth)
+- Inline variant tracks: LocalTrack/StreamTrack are final; TrackVariant + InlineTrackList
+  store tracks by value and dispatch with std::visit; printAll uses a type-tag switch
+- One library engine: MAX_TRACKS / Track library[] removed; menu options 1-4 and 5-11
+  share the TrackManager, which stores the full Track record (artist, genre, key, notes)
+
 Concepts used (rubric):
 - Constants (no magic numbers), enum, struct, array, classes
 - Input validation (cin fail states, clear/ignore)
@@ -89,13 +152,59 @@ Concepts used (rubric):
 #include <stdexcept>   // runtime_error, out_of_range
 #include <exception>
 #include <vector>      // Week 09: std::vector used in TrackManager for BPM search/sort
+#include <algorithm>   // stable_sort (counting sort fallback for out-of-range BPMs)
+#include <cstring>     // memcpy / memmove (DynamicArray relocation)
+#include <new>         // placement new
+#include <type_traits> // is_trivially_copyable
+#include <utility>     // move, forward
+#include <chrono>      // benchmark timing
+#include <cstdint>     // uint16_t packed columns
+#include <unordered_map> // SymbolTable (string -> id)
+#include <deque>         // SymbolTable names (stable references)
+#include <variant>       // TrackVariant (inline LocalTrack/StreamTrack)
+#include <map>           // LibraryAggregates outlier BPM counts
+#include <cctype>        // tolower / isdigit (key parsing)
+#include <thread>        // WorkStealingPool workers
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <cmath>         // ceil / floor (tempo tolerance ranges)
+#include <cstdio>        // FILE* snapshot writes, rename, remove
+#include <string_view>   // SnapshotView lazy strings
+#include <cstddef>       // offsetof (snapshot header checks)
+#include <charconv>      // to_chars (TableWriter numbers)
+
+// Library engine: memory-mapped snapshots (MapViewOfFile on Windows, mmap elsewhere)
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#include <io.h>        // _commit, _fileno
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>    // close, fsync
+#endif
+
+// Library engine: SIMD column scans (x86 only; other CPUs use the scalar kernel)
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define DJ_X86 1
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>    // __cpuid, _xgetbv
+#endif
+#endif
 
 using namespace std;
 
 // -------------------- Constants (avoid magic numbers) --------------------
-// Original (Weeks 1-4) library limits
-const int MAX_TRACKS = 7;        // Maximum number of tracks stored
-
 // Original table widths
 const int TITLE_W = 22;         // Column widths for table formatting
 const int ARTIST_W = 18;
@@ -113,20 +222,106 @@ const int BPM_MAX = 200;
 
 // Menu range (merged menu: original + week5 + week9)
 const int MENU_MIN = 1;
-const int MENU_MAX = 12; // Week 09: expanded to 12 (added BPM search/sort options)
+const int MENU_MAX = 14; // Week 09: expanded to 12 (added BPM search/sort options); 13 with setlist builder; 14 with import
 
 // -------------------- Enum --------------------
 // EnergyLevel models how intense a track feels in a set (meaningful for DJ planning).
 enum EnergyLevel { LOW = 1, MEDIUM = 2, HIGH = 3 };
 
+// -------------------- Library Engine: String Interning --------------------
+// SymbolTable gives every distinct string a dense 32-bit id (id 0 is always "").
+// A real library has only a few hundred genres / keys / platforms, so fields
+// like Track::genre store a 4-byte Symbol instead of a full string copy, and
+// equality (genre counts, filters) is one integer compare.
+// SymbolTable::global() is shared by every track and is NOT thread-safe:
+// intern() can rehash the map (racing with find()) and grow the deque
+// (racing with name()), so every intern AND every lookup must stay on one
+// thread. The pool users keep to that: the CSV importer parses on workers
+// but builds tracks on the calling thread, set searches and log compaction
+// only read the store's id columns / their own copies.
+class SymbolTable
+{
+private:
+    unordered_map<string, uint32_t> ids;
+    deque<string> names; // deque: name() references stay valid while it grows
+
+public:
+    SymbolTable()
+    {
+        names.push_back("");
+        ids[""] = 0;
+    }
+
+    static SymbolTable& global()
+    {
+        static SymbolTable table;
+        return table;
+    }
+
+    uint32_t intern(const string& text)
+    {
+        unordered_map<string, uint32_t>::const_iterator it = ids.find(text);
+        if (it != ids.end())
+            return it->second;
+
+        uint32_t id = static_cast<uint32_t>(names.size());
+        names.push_back(text);
+        ids[text] = id;
+        return id;
+    }
+
+    // Id of an already interned string, or -1 if it was never seen.
+    long long find(const string& text) const
+    {
+        unordered_map<string, uint32_t>::const_iterator it = ids.find(text);
+        return (it == ids.end()) ? -1 : static_cast<long long>(it->second);
+    }
+
+    const string& name(uint32_t id) const { return names.at(id); }
+    int size() const { return static_cast<int>(names.size()); }
+};
+
+// Value type for an interned string in SymbolTable::global().
+// Assigning a string interns it; comparing two Symbols compares ids.
+class Symbol
+{
+private:
+    uint32_t id;
+
+public:
+    Symbol() : id(0) {}
+    Symbol(const string& text) : id(SymbolTable::global().intern(text)) {}
+    Symbol(const char* text) : id(SymbolTable::global().intern(text)) {}
+
+    static Symbol fromId(uint32_t symbolId)
+    {
+        Symbol s;
+        s.id = symbolId;
+        return s;
+    }
+
+    uint32_t getId() const { return id; }
+    const string& str() const { return SymbolTable::global().name(id); }
+    bool empty() const { return id == 0; }
+
+    bool operator==(const Symbol& other) const { return id == other.id; }
+    bool operator!=(const Symbol& other) const { return id != other.id; }
+};
+
+ostream& operator<<(ostream& out, const Symbol& s)
+{
+    return out << s.str();
+}
+
 // -------------------- Struct (Weeks 1-4) --------------------
 // Track groups all track data together (meaningful model for the hobby).
+// Library engine: artist / genre / key are interned Symbols (4 bytes each).
 struct Track
 {
     string title;
-    string artist;
-    string genre;
-    string key;
+    Symbol artist;
+    Symbol genre;
+    Symbol key;
     int bpm = 0;                 // default
     EnergyLevel energy = MEDIUM; // default
     string notes;
@@ -148,23 +343,32 @@ EnergyLevel getEnergyFromUser();
 string energyToString(EnergyLevel e);
 
 // -------------------- Weeks 1-4 Features --------------------
-void addTrack(Track library[], int& count);
-void printLibrary(const Track library[], int count);
-void recommendNextTracks(const Track library[], int count);
-void saveReportToFile(const Track library[], int count, const string& filename);
+// Library engine: the Weeks 1-4 features run on the same TrackManager as the
+// Week 5+ options (no more Track library[MAX_TRACKS] cap).
+class TrackManager;
+class TableWriter;
+void addTrack(TrackManager& library);
+void printLibrary(const TrackManager& library);
+void recommendNextTracks(const TrackManager& library);
+void saveReportToFile(const TrackManager& library, const string& filename);
+void writeLegacyReport(ostream& out, const TrackManager& library);
 
 // Derived values / calculationsdat
 double computeAverageBPM(const Track library[], int count);
 int countGenreMatches(const Track library[], int count, const string& genre);
+double computeAverageBPM(const TrackManager& library);
+int countGenreMatches(const TrackManager& library, const string& genre);
 
 // Output helpers (Weeks 1-4)
-void printLegacyTableHeader(ostream& out);
-void printTrackRow(ostream& out, const Track& t);
+void printLegacyTableHeader(TableWriter& w);
+void printTrackRow(TableWriter& w, string_view title, string_view artist, string_view genre,
+    string_view key, int bpm, EnergyLevel e, string_view notes);
 
 // -------------------- Week 5/6/7 Helpers --------------------
 int safeIndexFromUser(const string& prompt, int size);
-void printWeek5TableHeader(ostream& out);
+void printWeek5TableHeader(TableWriter& w);
 void printSeparator(ostream& out);
+void printSeparator(TableWriter& w);
 
 // -------------------- Week 06: Function Template --------------------
 // REQUIREMENT: Create one function template and use it in your program.
@@ -212,6 +416,7 @@ public:
 
     void setNotes(const string& n) { notes = n; }
     string getNotes() const { return notes; }
+    string_view view() const { return notes; } // no copy (valid while the notes are unchanged)
 
     bool hasNotes() const
     {
@@ -221,6 +426,10 @@ public:
 
 // -------------------- Week 06: Class Template (replaces Week 05 dynamic array logic) --------------------
 // Week 07 change: now THROWS on invalid access/removal (Chapter 14 requirement).
+// Library engine change: the array manages RAW storage. Only slots [0, size) hold
+// constructed objects, so growing no longer default-constructs every new slot.
+// Elements are moved (not copied) on growth and when removeAt closes a gap, and
+// trivially copyable types (TrackBase*, int) are relocated with one memcpy/memmove.
 template <class T>
 class DynamicArray
 {
@@ -229,14 +438,67 @@ private:
     int size;
     int capacity;
 
+    static T* allocate(int cap)
+    {
+        return static_cast<T*>(::operator new(sizeof(T) * static_cast<size_t>(cap)));
+    }
+
+    static void deallocate(T* p)
+    {
+        ::operator delete(p);
+    }
+
+    // Moves 'count' live objects from src into uninitialized dst and ends their
+    // lifetime in src. If a (copying) constructor throws, dst is rolled back and
+    // src is left untouched.
+    static void relocate(T* dst, T* src, int count)
+    {
+        if constexpr (is_trivially_copyable<T>::value)
+        {
+            if (count > 0)
+                memcpy(static_cast<void*>(dst), static_cast<const void*>(src), sizeof(T) * static_cast<size_t>(count));
+        }
+        else
+        {
+            int built = 0;
+            try
+            {
+                for (; built < count; built++)
+                    ::new (static_cast<void*>(dst + built)) T(move_if_noexcept(src[built]));
+            }
+            catch (...)
+            {
+                destroyRange(dst, built);
+                throw;
+            }
+            destroyRange(src, count);
+        }
+    }
+
+    static void destroyRange(T* p, int count)
+    {
+        if constexpr (!is_trivially_destructible<T>::value)
+        {
+            for (int i = 0; i < count; i++)
+                p[i].~T();
+        }
+    }
+
     void resize(int newCap)
     {
-        T* newItems = new T[newCap];
+        T* newItems = allocate(newCap);
 
-        for (int i = 0; i < size; i++)
-            newItems[i] = items[i];
+        try
+        {
+            relocate(newItems, items, size);
+        }
+        catch (...)
+        {
+            deallocate(newItems);
+            throw;
+        }
 
-        delete[] items;
+        deallocate(items);
         items = newItems;
         capacity = newCap;
     }
@@ -249,19 +511,100 @@ public:
         : items(nullptr), size(0), capacity(cap)
     {
         if (capacity < 2) capacity = 2;
-        items = new T[capacity];
+        items = allocate(capacity);
+    }
+
+    // Moving steals the buffer; the source is left empty with no storage
+    // (it allocates again on the next add).
+    DynamicArray(DynamicArray&& other) noexcept
+        : items(other.items), size(other.size), capacity(other.capacity)
+    {
+        other.items = nullptr;
+        other.size = 0;
+        other.capacity = 0;
+    }
+
+    DynamicArray& operator=(DynamicArray&& other) noexcept
+    {
+        if (this != &other)
+        {
+            swap(items, other.items);
+            swap(size, other.size);
+            swap(capacity, other.capacity);
+        }
+        return *this;
     }
 
     int getSize() const { return size; }
     int getCapacity() const { return capacity; }
 
-    void pushBack(const T& value)
+    // Grows capacity to at least newCap (never shrinks). Bulk loaders call this
+    // once so that adding N items costs a single allocation.
+    void reserve(int newCap)
+    {
+        if (newCap > capacity)
+            resize(newCap);
+    }
+
+    // Releases unused capacity (keeps the minimum capacity of 2).
+    void shrinkToFit()
+    {
+        int target = (size < 2) ? 2 : size;
+        if (target < capacity)
+            resize(target);
+    }
+
+    // Constructs a new element in place at the end of the array.
+    template <class... Args>
+    T& emplaceBack(Args&&... args)
     {
-        if (size >= capacity)
-            resize(capacity * 2);
+        if (size < capacity)
+        {
+            ::new (static_cast<void*>(items + size)) T(forward<Args>(args)...);
+        }
+        else
+        {
+            // Build the new element first: args may refer to an element of this array.
+            int newCap = (capacity < 2) ? 2 : capacity * 2;
+            T* newItems = allocate(newCap);
+            try
+            {
+                ::new (static_cast<void*>(newItems + size)) T(forward<Args>(args)...);
+            }
+            catch (...)
+            {
+                deallocate(newItems);
+                throw;
+            }
+
+            try
+            {
+                relocate(newItems, items, size);
+            }
+            catch (...)
+            {
+                newItems[size].~T();
+                deallocate(newItems);
+                throw;
+            }
+
+            deallocate(items);
+            items = newItems;
+            capacity = newCap;
+        }
 
-        items[size] = value;
         size++;
+        return items[size - 1];
+    }
+
+    void pushBack(const T& value)
+    {
+        emplaceBack(value);
+    }
+
+    void pushBack(T&& value)
+    {
+        emplaceBack(move(value));
     }
 
     // Week 07 requirement: invalid removal -> throw
@@ -270,9 +613,33 @@ public:
         if (index < 0 || index >= size)
             throw out_of_range("DynamicArray::removeAt invalid index");
 
-        for (int i = index; i < size - 1; i++)
-            items[i] = items[i + 1];
+        if constexpr (is_trivially_copyable<T>::value)
+        {
+            memmove(static_cast<void*>(items + index), static_cast<const void*>(items + index + 1),
+                sizeof(T) * static_cast<size_t>(size - index - 1));
+        }
+        else
+        {
+            for (int i = index; i < size - 1; i++)
+                items[i] = move(items[i + 1]);
+            items[size - 1].~T();
+        }
+
+        size--;
+
+        if (size > 0 && size <= capacity / 4 && capacity > 2)
+            resize(capacity / 2);
+    }
+
+    // O(1) removal that does not keep order: the last element moves into 'index'.
+    void swapRemoveAt(int index)
+    {
+        if (index < 0 || index >= size)
+            throw out_of_range("DynamicArray::swapRemoveAt invalid index");
 
+        if (index != size - 1)
+            items[index] = move(items[size - 1]);
+        destroyRange(items + size - 1, 1);
         size--;
 
         if (size > 0 && size <= capacity / 4 && capacity > 2)
@@ -293,10 +660,114 @@ public:
 
     ~DynamicArray()
     {
-        delete[] items;
+        destroyRange(items, size);
+        deallocate(items);
+    }
+};
+
+// -------------------- Library Engine: Fixed-Width Table Writer --------------------
+// The report tables used to go cell by cell through setw/left/right, i.e.
+// through the stream's formatting (and locale) machinery for every cell, plus
+// a substr() copy per cut column. TableWriter lays the same cells out in one
+// reused character buffer and hands the stream whole blocks. The bytes are
+// exactly what the manipulators produce on a stream in its default state
+// (fill ' ', no showpos): a cell is padded to its width and never cut; cut()
+// is the old substr(0, width - 1) without the copy.
+class TableWriter
+{
+private:
+    ostream& out;
+    string buf;
+    size_t blockBytes;
+
+    void pad(size_t used, int width)
+    {
+        if (width > 0 && used < static_cast<size_t>(width))
+            buf.append(static_cast<size_t>(width) - used, ' ');
+    }
+
+    static string_view formatInt(long long v, char (&digits)[24])
+    {
+        to_chars_result r = to_chars(digits, digits + sizeof(digits), v);
+        return string_view(digits, static_cast<size_t>(r.ptr - digits));
+    }
+
+    TableWriter(const TableWriter&) = delete;
+    TableWriter& operator=(const TableWriter&) = delete;
+
+public:
+    explicit TableWriter(ostream& o, size_t block = 64 * 1024) : out(o), blockBytes(block)
+    {
+        buf.reserve(block + 256);
+    }
+
+    ~TableWriter() { flush(); }
+
+    static string_view cut(string_view text, int width) { return text.substr(0, static_cast<size_t>(width - 1)); }
+
+    TableWriter& text(string_view t)
+    {
+        buf.append(t.data(), t.size());
+        return *this;
+    }
+
+    TableWriter& repeat(char c, int n)
+    {
+        buf.append(static_cast<size_t>(n), c);
+        return *this;
+    }
+
+    // out << left << setw(width) << t
+    TableWriter& left(string_view t, int width)
+    {
+        text(t);
+        pad(t.size(), width);
+        return *this;
+    }
+
+    // out << right << setw(width) << t
+    TableWriter& right(string_view t, int width)
+    {
+        pad(t.size(), width);
+        return text(t);
+    }
+
+    TableWriter& left(long long v, int width)
+    {
+        char digits[24];
+        return left(formatInt(v, digits), width);
+    }
+
+    TableWriter& right(long long v, int width)
+    {
+        char digits[24];
+        return right(formatInt(v, digits), width);
+    }
+
+    // Ends the row; a full block goes to the stream in one write.
+    void endLine()
+    {
+        buf.push_back('\n');
+        if (buf.size() >= blockBytes)
+            flush();
+    }
+
+    void flush()
+    {
+        if (buf.empty())
+            return;
+        out.write(buf.data(), static_cast<streamsize>(buf.size()));
+        buf.clear();
     }
 };
 
+inline string_view energyLabel(EnergyLevel e)
+{
+    if (e == LOW) return "Low";
+    if (e == MEDIUM) return "Medium";
+    return "High";
+}
+
 // -------------------- Week 5/6/7: Abstract Base Class --------------------
 // TrackBase is an ABSTRACT base class.
 class TrackBase
@@ -307,6 +778,9 @@ protected:
 private:
     int bpm;
     EnergyLevel energy;
+    Symbol artist; // optional (library engine): "" when unknown
+    Symbol genre;  // optional (library engine): "" when unknown
+    Symbol key;    // optional (library engine): "" when unknown
 
 public:
     TrackBase() : title(""), bpm(0), energy(MEDIUM) {}
@@ -316,20 +790,29 @@ public:
     }
 
     string getTitle() const { return title; }
+    string_view titleView() const { return title; } // no copy (valid while the title is unchanged)
     int getBpm() const { return bpm; }
     EnergyLevel getEnergy() const { return energy; }
+    string getArtist() const { return artist.str(); }
+    string getGenre() const { return genre.str(); }
+    string getKey() const { return key.str(); }
+    Symbol getArtistSymbol() const { return artist; }
+    Symbol getGenreSymbol() const { return genre; }
+    Symbol getKeySymbol() const { return key; }
 
     void setTitle(const string& t) { title = t; }
     void setBpm(int b) { bpm = b; }
     void setEnergy(EnergyLevel e) { energy = e; }
+    void setArtist(const string& a) { artist = Symbol(a); }
+    void setGenre(const string& g) { genre = Symbol(g); }
+    void setKey(const string& k) { key = Symbol(k); }
+    void setArtistSymbol(Symbol a) { artist = a; }
+    void setGenreSymbol(Symbol g) { genre = g; }
+    void setKeySymbol(Symbol k) { key = k; }
 
     virtual void print(ostream& out) const
     {
-        out << left
-            << setw(TITLE_W) << title.substr(0, TITLE_W - 1)
-            << setw(TYPE_W) << getType()
-            << right << setw(6) << bpm << "  "
-            << left << setw(8) << energyToString(energy);
+        printColumns(out, getType());
     }
 
     // Week 06: used by operator<< (polymorphic one-line)
@@ -341,6 +824,27 @@ public:
     virtual string getType() const = 0;
 
     virtual ~TrackBase() {}
+
+protected:
+    // Shared row columns; derived classes pass their type name directly so a
+    // statically dispatched print() makes no virtual calls.
+    void printColumns(ostream& out, const string& typeName) const
+    {
+        out << left
+            << setw(TITLE_W) << title.substr(0, TITLE_W - 1)
+            << setw(TYPE_W) << typeName
+            << right << setw(6) << bpm << "  "
+            << left << setw(8) << energyToString(energy);
+    }
+
+    // Same columns into a TableWriter.
+    void printColumns(TableWriter& w, string_view typeName) const
+    {
+        w.left(TableWriter::cut(title, TITLE_W), TITLE_W)
+            .left(typeName, TYPE_W)
+            .right(bpm, 6).text("  ")
+            .left(energyLabel(energy), 8);
+    }
 };
 
 // -------------------- Week 06: operator<< overload (polymorphic) --------------------
@@ -351,7 +855,9 @@ ostream& operator<<(ostream& out, const TrackBase& t)
 }
 
 // -------------------- Week 5/6/7: Derived Class #1 --------------------
-class LocalTrack : public TrackBase
+// Library engine: both derived classes are final, so calls through a
+// LocalTrack*/StreamTrack* (type-tag switch, std::visit) are not virtual.
+class LocalTrack final : public TrackBase
 {
 private:
     string filePath;
@@ -375,12 +881,22 @@ public:
 
     void print(ostream& out) const override
     {
-        TrackBase::print(out);
+        printColumns(out, LocalTrack::getType());
         out << setw(KEY_W) << ""
             << setw(NOTE_W) << (notes.hasNotes() ? notes.getNotes().substr(0, NOTE_W - 1) : "(none)")
             << "  Path: " << filePath;
     }
 
+    void print(TableWriter& w) const
+    {
+        printColumns(w, "LocalTrack");
+        w.left("", KEY_W)
+            .left(notes.hasNotes() ? TableWriter::cut(notes.view(), NOTE_W) : string_view("(none)"), NOTE_W)
+            .text("  Path: ").text(filePath);
+    }
+
+    const MixNotes& notesRef() const { return notes; }
+
     void toStream(ostream& out) const override
     {
         out << getType()
@@ -399,22 +915,24 @@ public:
 };
 
 // -------------------- Week 5/6/7: Derived Class #2 --------------------
-class StreamTrack : public TrackBase
+class StreamTrack final : public TrackBase
 {
 private:
-    string platform;
+    Symbol platform; // interned: a library has only a handful of platforms
     MixNotes notes; // composition
 
 public:
-    StreamTrack() : TrackBase(), platform(""), notes() {}
+    StreamTrack() : TrackBase(), platform(), notes() {}
 
     StreamTrack(const string& t, int b, EnergyLevel e,
         const string& plat, const MixNotes& n)
         : TrackBase(t, b, e), platform(plat), notes(n) {
     }
 
-    void setPlatform(const string& p) { platform = p; }
-    string getPlatform() const { return platform; }
+    void setPlatform(const string& p) { platform = Symbol(p); }
+    void setPlatformSymbol(Symbol p) { platform = p; }
+    string getPlatform() const { return platform.str(); }
+    Symbol getPlatformSymbol() const { return platform; }
 
     void setNotes(const MixNotes& n) { notes = n; }
     MixNotes getNotes() const { return notes; }
@@ -423,12 +941,22 @@ public:
 
     void print(ostream& out) const override
     {
-        TrackBase::print(out);
+        printColumns(out, StreamTrack::getType());
         out << setw(KEY_W) << ""
             << setw(NOTE_W) << (notes.hasNotes() ? notes.getNotes().substr(0, NOTE_W - 1) : "(none)")
             << "  Platform: " << platform;
     }
 
+    void print(TableWriter& w) const
+    {
+        printColumns(w, "StreamTrack");
+        w.left("", KEY_W)
+            .left(notes.hasNotes() ? TableWriter::cut(notes.view(), NOTE_W) : string_view("(none)"), NOTE_W)
+            .text("  Platform: ").text(platform.str());
+    }
+
+    const MixNotes& notesRef() const { return notes; }
+
     void toStream(ostream& out) const override
     {
         out << getType()
@@ -439,1103 +967,10160 @@ public:
     }
 };
 
-// -------------------- Week 5/6/7/9: Manager Class --------------------
-// TrackManager OWNS TrackBase* objects and uses DynamicArray<TrackBase*> for storage.
-class TrackManager
-{
-private:
-    DynamicArray<TrackBase*> items; // template-based dynamic container
-
-    // -------------------- Week 09: std::vector replaces raw int array --------------------
-    // bpmList stores the BPM of every track in the same order as items[].
-    // It replaces what would have been a plain int array (e.g. int bpms[N]).
-    // All access goes through .push_back(), .size(), and .at() per the rubric.
-    vector<int> bpmList;
+// -------------------- Library Engine: Inline Variant Tracks --------------------
+// The track hierarchy is closed (LocalTrack, StreamTrack), so a track can also be
+// stored BY VALUE as a variant: no heap pointer per track, and hot loops dispatch
+// with std::visit (a jump on the variant index) instead of a vtable lookup.
+using TrackVariant = variant<LocalTrack, StreamTrack>;
 
-    int countHighEnergyRecursiveHelper(int index) const
-    {
-        // Base case: reached end of array
-        if (index >= items.getSize())
-            return 0;
+// Adapter: the existing TrackBase interface over an inline track.
+TrackBase& asTrackBase(TrackVariant& v)
+{
+    return visit([](auto& t) -> TrackBase& { return t; }, v);
+}
 
-        // Recursive case: count current item if HIGH, then move to next
-        int currentIsHigh = 0;
-        if (items.rawAt(index) != nullptr && items.rawAt(index)->getEnergy() == HIGH)
-            currentIsHigh = 1;
+const TrackBase& asTrackBase(const TrackVariant& v)
+{
+    return visit([](const auto& t) -> const TrackBase& { return t; }, v);
+}
 
-        return currentIsHigh + countHighEnergyRecursiveHelper(index + 1);
-    }
+ostream& operator<<(ostream& out, const TrackVariant& v)
+{
+    visit([&out](const auto& t) { t.toStream(out); }, v);
+    return out;
+}
 
-    TrackManager(const TrackManager&) = delete;
-    TrackManager& operator=(const TrackManager&) = delete;
+// Value container of inline tracks (contiguous DynamicArray storage).
+class InlineTrackList
+{
+private:
+    DynamicArray<TrackVariant> tracks;
 
 public:
-    TrackManager(int cap = 2)
-        : items(cap)
-    {
-    }
+    InlineTrackList(int cap = 2) : tracks(cap) {}
 
-    int getSize() const { return items.getSize(); }
-    int getCapacity() const { return items.getCapacity(); }
+    int getSize() const { return tracks.getSize(); }
+    void reserve(int cap) { tracks.reserve(cap); }
 
-    int countHighEnergyRecursive() const
-    {
-        return countHighEnergyRecursiveHelper(0);
-    }
+    void add(const LocalTrack& t) { tracks.emplaceBack(t); }
+    void add(const StreamTrack& t) { tracks.emplaceBack(t); }
+    void add(const TrackVariant& t) { tracks.pushBack(t); }
 
-    // Adds a pointer (manager takes ownership)
-    void add(TrackBase* p)
+    // Throws out_of_range like DynamicArray::at.
+    const TrackVariant& variantAt(int index) const
     {
-        items.pushBack(p);
-        bpmList.push_back(p->getBpm()); // Week 09: mirror BPM into vector for search/sort
+        if (index < 0 || index >= tracks.getSize())
+            throw out_of_range("InlineTrackList index out of range");
+        return tracks.rawAt(index);
     }
 
-    // Removes by index (deletes object, shifts close the gap)
-    // Internal helper. We keep it throwing to match Week 07 behavior.
-    void removeAt(int index)
+    TrackBase& operator[](int index)
     {
-        // If invalid, DynamicArray::at throws out_of_range.
-        TrackBase* doomed = items.at(index);
-        delete doomed;
-        items.removeAt(index);
-        bpmList.erase(bpmList.begin() + index); // Week 09: keep vector in sync with items
+        if (index < 0 || index >= tracks.getSize())
+            throw out_of_range("InlineTrackList index out of range");
+        return asTrackBase(tracks.rawAt(index));
     }
 
-    // Week 07 requirement: operator[] must THROW on invalid index.
-    // Also: we use our CUSTOM exception here (DJException) to satisfy the rubric.
-    TrackBase* operator[](int index) const
+    const TrackBase& operator[](int index) const
     {
-        if (index < 0 || index >= items.getSize())
-            throw DJException("TrackManager::operator[] invalid index");
-
-        // Valid index, safe to access:
-        return items.at(index);  // will not throw here because we checked
+        return asTrackBase(variantAt(index));
     }
 
-    // Week 06: operator+= adds item pointer to container
-    TrackManager& operator+=(TrackBase* p)
+    int countEnergy(EnergyLevel e) const
     {
-        // explicit use of this pointer (Week 06 requirement)
-        this->add(p);
-        return *this;
+        int count = 0;
+        for (int i = 0; i < tracks.getSize(); i++)
+            count += visit([e](const auto& t) { return t.getEnergy() == e ? 1 : 0; }, tracks.rawAt(i));
+        return count;
     }
 
-    // Week 07 requirement: operator-= must THROW on invalid removal.
-    TrackManager& operator-=(int index)
+    long long sumBpm() const
     {
-        if (index < 0 || index >= items.getSize())
-            throw DJException("TrackManager::operator-= invalid removal index");
-
-        this->removeAt(index);
-        return *this;
+        long long sum = 0;
+        for (int i = 0; i < tracks.getSize(); i++)
+            sum += visit([](const auto& t) { return t.getBpm(); }, tracks.rawAt(i));
+        return sum;
     }
 
+    // Same table as TrackManager::printAll.
     void printAll(ostream& out) const
     {
-        if (items.getSize() == 0)
+        if (tracks.getSize() == 0)
         {
             out << "No tracks stored yet.\n";
             return;
         }
 
-        printWeek5TableHeader(out);
+        TableWriter w(out);
+        printWeek5TableHeader(w);
 
-        for (int i = 0; i < items.getSize(); i++)
+        for (int i = 0; i < tracks.getSize(); i++)
         {
-            out << setw(4) << i << " ";
-            TrackBase* p = items.rawAt(i); // valid i, so rawAt is safe (no exception)
-            if (p)
-                p->print(out);
-            out << "\n";
+            w.left(i, 4).text(" ");
+            visit([&w](const auto& t) { t.print(w); }, tracks.rawAt(i));
+            w.endLine();
         }
 
-        printSeparator(out);
+        printSeparator(w);
     }
 
-    void saveReport(const string& filename) const
+    void toStreamAll(ostream& out) const
     {
-        ofstream fout(filename.c_str());
-        if (!fout)
-        {
-            cout << "Could not open file: " << filename << "\n";
-            return;
-        }
+        for (int i = 0; i < tracks.getSize(); i++)
+            out << tracks.rawAt(i) << "\n";
+    }
+};
 
-        fout << "==================== DJ SET ARCHITECT REPORT (Week 7) ====================\n";
-        fout << "Tracks stored: " << items.getSize() << "\n\n";
+// -------------------- Library Engine: Harmonic Keys (Camelot) --------------------
+// Every major/minor key gets a compact id 0..23 laid out on the Camelot wheel:
+//   id = (camelotNumber - 1) * 2 + (major ? 1 : 0)      (1A = 0, 1B = 1, ... 12B = 23)
+// parseHarmonicKey() accepts the common spellings of the same key:
+//   standard  "Am", "F#m", "Bb", "Ebmin", "c min", "C major"
+//   Camelot   "8A", "12b"
+//   Open Key  "1m", "6d"   (1m = A minor = 8A)
+// Unknown / empty strings give NO_KEY.
+const int HARMONIC_KEYS = 24;
+const int NO_KEY = -1;
+const uint8_t NO_KEY_PACKED = 0xFF; // NO_KEY in a uint8_t column
+
+// Compatibility scores (higher = smoother mix)
+const int KEY_SCORE_CLASH = 0;
+const int KEY_SCORE_LOOSE = 1;      // +/-2 on the wheel or diagonal (ex: 8A -> 9B)
+const int KEY_SCORE_COMPATIBLE = 2; // +/-1 on the wheel or relative major/minor
+const int KEY_SCORE_PERFECT = 3;    // same key
+
+constexpr int camelotNumber(int keyId) { return keyId / 2 + 1; }
+constexpr bool isMajorKey(int keyId) { return (keyId % 2) == 1; }
+
+// Steps between two Camelot numbers around the 12-hour wheel (0..6).
+constexpr int wheelDistance(int a, int b)
+{
+    int d = (a > b) ? a - b : b - a;
+    return (d > 6) ? 12 - d : d;
+}
 
-        printAll(fout);
+constexpr int keyCompatScore(int a, int b)
+{
+    int dist = wheelDistance(camelotNumber(a), camelotNumber(b));
+    bool sameMode = isMajorKey(a) == isMajorKey(b);
+    if (a == b) return KEY_SCORE_PERFECT;
+    if (sameMode && dist == 1) return KEY_SCORE_COMPATIBLE;
+    if (!sameMode && dist == 0) return KEY_SCORE_COMPATIBLE;
+    if (sameMode && dist == 2) return KEY_SCORE_LOOSE;
+    if (!sameMode && dist == 1) return KEY_SCORE_LOOSE;
+    return KEY_SCORE_CLASH;
+}
 
-        fout.close();
-        cout << "Report saved to " << filename << "\n";
-    }
+struct KeyCompatTable
+{
+    uint8_t score[HARMONIC_KEYS][HARMONIC_KEYS];
+};
 
-    // -------------------- Week 09: Sequential (Linear) Search --------------------
-    // Scans bpmList element-by-element from the start.
-    // Returns the index of the first match, or -1 if the target BPM is not found.
-    // No std::find or any library search is used — the loop does all the work.
-    int sequentialSearchBpm(int target) const
+constexpr KeyCompatTable makeKeyCompatTable()
+{
+    KeyCompatTable t = {};
+    for (int a = 0; a < HARMONIC_KEYS; a++)
+        for (int b = 0; b < HARMONIC_KEYS; b++)
+            t.score[a][b] = static_cast<uint8_t>(keyCompatScore(a, b));
+    return t;
+}
+
+// Built at compile time: a recommendation's key check is one array lookup.
+constexpr KeyCompatTable KEY_COMPAT = makeKeyCompatTable();
+static_assert(KEY_COMPAT.score[14][14] == KEY_SCORE_PERFECT, "8A -> 8A");
+static_assert(KEY_COMPAT.score[14][16] == KEY_SCORE_COMPATIBLE, "8A -> 9A");
+static_assert(KEY_COMPAT.score[0][22] == KEY_SCORE_COMPATIBLE, "1A -> 12A wraps");
+static_assert(KEY_COMPAT.score[14][15] == KEY_SCORE_COMPATIBLE, "8A -> 8B (relative)");
+static_assert(KEY_COMPAT.score[14][0] == KEY_SCORE_CLASH, "8A -> 1A");
+
+// NO_KEY on either side scores as a clash.
+inline int harmonicScore(int a, int b)
+{
+    if (a < 0 || a >= HARMONIC_KEYS || b < 0 || b >= HARMONIC_KEYS)
+        return KEY_SCORE_CLASH;
+    return KEY_COMPAT.score[a][b];
+}
+
+// Pitch class (C = 0 ... B = 11) + mode -> key id.
+inline int keyIdFromPitch(int pitchClass, bool major)
+{
+    int majorPitch = major ? pitchClass : (pitchClass + 3) % 12; // relative major
+    int number = (majorPitch * 7 + 7) % 12 + 1;                  // C major = 8B
+    return (number - 1) * 2 + (major ? 1 : 0);
+}
+
+int parseHarmonicKey(const string& text)
+{
+    string k;
+    for (char c : text)
+        if (c != ' ' && c != '\t' && c != '-' && c != '_')
+            k += static_cast<char>(tolower(static_cast<unsigned char>(c)));
+    if (k.empty())
+        return NO_KEY;
+
+    // Camelot "8a" / Open Key "1m": leading number 1..12 + one letter
+    if (isdigit(static_cast<unsigned char>(k[0])))
     {
-        for (int i = 0; i < static_cast<int>(bpmList.size()); i++)
+        size_t pos = 0;
+        int number = 0;
+        while (pos < k.size() && isdigit(static_cast<unsigned char>(k[pos])) && number <= 12)
+            number = number * 10 + (k[pos++] - '0');
+        if (number < 1 || number > 12 || pos + 1 != k.size())
+            return NO_KEY;
+
+        char mode = k[pos];
+        if (mode == 'a' || mode == 'b')
+            return (number - 1) * 2 + (mode == 'b' ? 1 : 0);
+        if (mode == 'm' || mode == 'd')
         {
-            if (bpmList.at(i) == target)
-                return i; // found at this index
+            int camelot = (number + 6) % 12 + 1; // Open Key 1 = Camelot 8
+            return (camelot - 1) * 2 + (mode == 'd' ? 1 : 0);
         }
-        return -1; // not found
+        return NO_KEY;
     }
 
-    // -------------------- Week 09: Bubble Sort --------------------
-    // Sorts bpmList in ascending order using the Bubble Sort algorithm.
-    // Each outer pass "bubbles" the largest unsorted value to its final position.
-    // No std::sort — every swap is done manually.
-    void sortBpmsBubble()
+    // Standard: letter, optional accidental, optional mode word
+    static const int LETTER_PITCH[7] = { 9, 11, 0, 2, 4, 5, 7 }; // a b c d e f g
+    if (k[0] < 'a' || k[0] > 'g')
+        return NO_KEY;
+    int pitch = LETTER_PITCH[k[0] - 'a'];
+    size_t pos = 1;
+    if (pos < k.size() && (k[pos] == '#' || k[pos] == 'b'))
     {
-        int n = static_cast<int>(bpmList.size());
-        for (int i = 0; i < n - 1; i++)
+        pitch = (k[pos] == '#') ? pitch + 1 : pitch + 11;
+        pos++;
+    }
+    pitch %= 12;
+
+    string mode = k.substr(pos);
+    if (mode.empty() || mode == "maj" || mode == "major")
+        return keyIdFromPitch(pitch, true);
+    if (mode == "m" || mode == "min" || mode == "minor")
+        return keyIdFromPitch(pitch, false);
+    return NO_KEY;
+}
+
+string keyToCamelot(int keyId)
+{
+    if (keyId < 0 || keyId >= HARMONIC_KEYS)
+        return "";
+    return to_string(camelotNumber(keyId)) + (isMajorKey(keyId) ? "B" : "A");
+}
+
+string keyToStandard(int keyId)
+{
+    static const char* const NAMES[12] = { "C", "C#", "D", "Eb", "E", "F", "F#", "G", "Ab", "A", "Bb", "B" };
+    if (keyId < 0 || keyId >= HARMONIC_KEYS)
+        return "";
+    int majorPitch = ((camelotNumber(keyId) - 8 + 12) * 7) % 12; // inverse of keyIdFromPitch
+    if (isMajorKey(keyId))
+        return NAMES[majorPitch];
+    return string(NAMES[(majorPitch + 9) % 12]) + "m";
+}
+
+// -------------------- Library Engine: Counting Sort (BPM) --------------------
+// Validated BPMs only take BPM_MAX - BPM_MIN + 1 = 141 distinct values, so a counting
+// sort orders any number of tracks in O(n + 141) instead of bubble sort's O(n^2).
+const int BPM_BUCKETS = BPM_MAX - BPM_MIN + 1;
+
+// Counting sort is only used while the key range stays small; a library with
+// unvalidated outliers (ex: setBpm(999)) widens the range.
+const int COUNTING_SORT_MAX_RANGE = 1 << 16;
+
+// Returns the STABLE sorting permutation of values:
+//   values[order[0]] <= values[order[1]] <= ...   (order[k] = original index)
+// Equal BPMs keep their library order. Applying the same permutation to any
+// parallel array (items, bpmList) keeps the arrays aligned.
+template <class V>
+vector<int> countingSortOrder(const vector<V>& values)
+{
+    int n = static_cast<int>(values.size());
+    vector<int> order(n);
+    if (n == 0)
+        return order;
+
+    int lo = static_cast<int>(values[0]);
+    int hi = static_cast<int>(values[0]);
+    for (int i = 1; i < n; i++)
+    {
+        if (values[i] < lo) lo = values[i];
+        if (values[i] > hi) hi = values[i];
+    }
+
+    long long range = static_cast<long long>(hi) - lo + 1;
+    if (range > COUNTING_SORT_MAX_RANGE)
+    {
+        // Out-of-range data: fall back to a comparison sort (still stable).
+        for (int i = 0; i < n; i++)
+            order[i] = i;
+        stable_sort(order.begin(), order.end(),
+            [&values](int a, int b) { return values[a] < values[b]; });
+        return order;
+    }
+
+    // Histogram -> exclusive prefix sums -> stable scatter.
+    vector<int> start(static_cast<size_t>(range) + 1, 0);
+    for (int i = 0; i < n; i++)
+        start[values[i] - lo + 1]++;
+    for (size_t b = 1; b < start.size(); b++)
+        start[b] += start[b - 1];
+    for (int i = 0; i < n; i++)
+        order[start[values[i] - lo]++] = i;
+
+    return order;
+}
+
+// -------------------- Library Engine: SIMD Column Scans --------------------
+// Kernels over packed 16-bit columns (BPM, energy). Each kernel exists three
+// times: scalar, SSE4.1 (8 values per step) and AVX2 (16 values per step).
+// The best level the CPU supports is picked once at runtime, so one binary
+// runs everywhere. Equality is the range [v, v].
+enum SimdLevel { SIMD_SCALAR = 0, SIMD_SSE41 = 1, SIMD_AVX2 = 2 };
+
+#if defined(DJ_X86) && (defined(__GNUC__) || defined(__clang__))
+#define DJ_TARGET(isa) __attribute__((target(isa)))
+#else
+#define DJ_TARGET(isa)
+#endif
+
+string simdLevelToString(SimdLevel level)
+{
+    if (level == SIMD_AVX2) return "AVX2";
+    if (level == SIMD_SSE41) return "SSE4.1";
+    return "Scalar";
+}
+
+SimdLevel detectSimdLevel()
+{
+#if defined(DJ_X86) && (defined(__GNUC__) || defined(__clang__))
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) return SIMD_AVX2;
+    if (__builtin_cpu_supports("sse4.1")) return SIMD_SSE41;
+    return SIMD_SCALAR;
+#elif defined(DJ_X86) && defined(_MSC_VER)
+    int info[4] = { 0, 0, 0, 0 };
+    __cpuid(info, 0);
+    int maxLeaf = info[0];
+
+    __cpuid(info, 1);
+    bool sse41 = (info[2] & (1 << 19)) != 0;
+    bool osAvx = (info[2] & (1 << 27)) != 0 && (info[2] & (1 << 28)) != 0 &&
+        (_xgetbv(0) & 6) == 6; // OS saves YMM registers
+    bool avx2 = false;
+    if (osAvx && maxLeaf >= 7)
+    {
+        __cpuidex(info, 7, 0);
+        avx2 = (info[1] & (1 << 5)) != 0;
+    }
+
+    if (avx2) return SIMD_AVX2;
+    if (sse41) return SIMD_SSE41;
+    return SIMD_SCALAR;
+#else
+    return SIMD_SCALAR;
+#endif
+}
+
+// Index of the lowest set bit (mask must be non-zero).
+inline int lowestBitIndex(unsigned mask)
+{
+#ifdef _MSC_VER
+    unsigned long idx;
+    _BitScanForward(&idx, mask);
+    return static_cast<int>(idx);
+#else
+    return __builtin_ctz(mask);
+#endif
+}
+
+void findInRangeScalar(const uint16_t* col, int n, uint16_t lo, uint16_t hi, vector<int>& out)
+{
+    for (int i = 0; i < n; i++)
+        if (col[i] >= lo && col[i] <= hi)
+            out.push_back(i);
+}
+
+int countInRangeScalar(const uint16_t* col, int n, uint16_t lo, uint16_t hi)
+{
+    int matches = 0;
+    for (int i = 0; i < n; i++)
+        matches += (col[i] >= lo && col[i] <= hi) ? 1 : 0;
+    return matches;
+}
+
+// Energy histogram: LOW / MEDIUM / HIGH counts of an energy column in ONE pass.
+// Values outside 1..3 are not counted.
+struct EnergyCounts
+{
+    int low = 0;
+    int medium = 0;
+    int high = 0;
+
+    int of(int e) const
+    {
+        if (e == LOW) return low;
+        if (e == MEDIUM) return medium;
+        if (e == HIGH) return high;
+        return 0;
+    }
+
+    int total() const { return low + medium + high; }
+
+    void adjust(int e, int delta)
+    {
+        if (e == LOW) low += delta;
+        else if (e == MEDIUM) medium += delta;
+        else if (e == HIGH) high += delta;
+    }
+};
+
+void energyHistogramScalar(const uint16_t* col, int n, EnergyCounts& out)
+{
+    int low = 0, medium = 0, high = 0;
+    for (int i = 0; i < n; i++)
+    {
+        low += (col[i] == LOW) ? 1 : 0;
+        medium += (col[i] == MEDIUM) ? 1 : 0;
+        high += (col[i] == HIGH) ? 1 : 0;
+    }
+    out.low += low;
+    out.medium += medium;
+    out.high += high;
+}
+
+#ifdef DJ_X86
+// x is in [lo, hi]  <=>  max(x, lo) == x  and  min(x, hi) == x  (unsigned 16-bit)
+DJ_TARGET("sse4.1")
+void findInRangeSse41(const uint16_t* col, int n, uint16_t lo, uint16_t hi, vector<int>& out)
+{
+    const __m128i vlo = _mm_set1_epi16(static_cast<short>(lo));
+    const __m128i vhi = _mm_set1_epi16(static_cast<short>(hi));
+    int i = 0;
+    for (; i + 8 <= n; i += 8)
+    {
+        __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(col + i));
+        __m128i hit = _mm_and_si128(_mm_cmpeq_epi16(_mm_max_epu16(x, vlo), x),
+                                    _mm_cmpeq_epi16(_mm_min_epu16(x, vhi), x));
+        unsigned mask = static_cast<unsigned>(_mm_movemask_epi8(hit)) & 0x5555u; // 1 bit per lane
+        while (mask != 0)
         {
-            for (int j = 0; j < n - i - 1; j++)
-            {
-                if (bpmList.at(j) > bpmList.at(j + 1))
-                {
-                    // swap adjacent elements
-                    int temp = bpmList.at(j);
-                    bpmList.at(j) = bpmList.at(j + 1);
-                    bpmList.at(j + 1) = temp;
-                }
-            }
+            out.push_back(i + lowestBitIndex(mask) / 2);
+            mask &= mask - 1;
         }
     }
+    size_t tailStart = out.size();
+    findInRangeScalar(col + i, n - i, lo, hi, out);
+    for (size_t k = tailStart; k < out.size(); k++)
+        out[k] += i; // tail hits are relative to col + i
+}
 
-    // -------------------- Week 09: Binary Search --------------------
-    // IMPORTANT: sortBpmsBubble() must be called before this function.
-    // Binary search requires the data to be in sorted order; without it the
-    // mid-point comparison sends the search in the wrong direction.
-    // Uses the classic low / mid / high index approach.
-    // Returns the index of the found element, or -1 if not found.
-    int binarySearchBpm(int target) const
+DJ_TARGET("sse4.1")
+int countInRangeSse41(const uint16_t* col, int n, uint16_t lo, uint16_t hi)
+{
+    const __m128i vlo = _mm_set1_epi16(static_cast<short>(lo));
+    const __m128i vhi = _mm_set1_epi16(static_cast<short>(hi));
+    const __m128i ones = _mm_set1_epi16(1);
+    const int BLOCK = 32767; // 16-bit lane counters must not overflow
+
+    __m128i total = _mm_setzero_si128(); // 4 x int32
+    int i = 0;
+    while (i + 8 <= n)
     {
-        int low  = 0;
-        int high = static_cast<int>(bpmList.size()) - 1;
+        __m128i acc = _mm_setzero_si128(); // 8 x int16
+        for (int steps = 0; steps < BLOCK && i + 8 <= n; steps++, i += 8)
+        {
+            __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(col + i));
+            __m128i hit = _mm_and_si128(_mm_cmpeq_epi16(_mm_max_epu16(x, vlo), x),
+                                        _mm_cmpeq_epi16(_mm_min_epu16(x, vhi), x));
+            acc = _mm_sub_epi16(acc, hit); // hit lanes are -1
+        }
+        total = _mm_add_epi32(total, _mm_madd_epi16(acc, ones));
+    }
 
-        while (low <= high)
+    int lanes[4];
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(lanes), total);
+    return lanes[0] + lanes[1] + lanes[2] + lanes[3] + countInRangeScalar(col + i, n - i, lo, hi);
+}
+
+DJ_TARGET("avx2")
+void findInRangeAvx2(const uint16_t* col, int n, uint16_t lo, uint16_t hi, vector<int>& out)
+{
+    const __m256i vlo = _mm256_set1_epi16(static_cast<short>(lo));
+    const __m256i vhi = _mm256_set1_epi16(static_cast<short>(hi));
+    int i = 0;
+    for (; i + 16 <= n; i += 16)
+    {
+        __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(col + i));
+        __m256i hit = _mm256_and_si256(_mm256_cmpeq_epi16(_mm256_max_epu16(x, vlo), x),
+                                       _mm256_cmpeq_epi16(_mm256_min_epu16(x, vhi), x));
+        unsigned mask = static_cast<unsigned>(_mm256_movemask_epi8(hit)) & 0x55555555u;
+        while (mask != 0)
         {
-            int mid = low + (high - low) / 2; // avoids integer overflow vs (low+high)/2
+            out.push_back(i + lowestBitIndex(mask) / 2);
+            mask &= mask - 1;
+        }
+    }
+    size_t tailStart = out.size();
+    findInRangeScalar(col + i, n - i, lo, hi, out);
+    for (size_t k = tailStart; k < out.size(); k++)
+        out[k] += i;
+}
 
-            if (bpmList.at(mid) == target)
-                return mid;                   // exact match found
-            else if (bpmList.at(mid) < target)
-                low = mid + 1;                // target is in right half
-            else
-                high = mid - 1;              // target is in left half
+DJ_TARGET("avx2")
+int countInRangeAvx2(const uint16_t* col, int n, uint16_t lo, uint16_t hi)
+{
+    const __m256i vlo = _mm256_set1_epi16(static_cast<short>(lo));
+    const __m256i vhi = _mm256_set1_epi16(static_cast<short>(hi));
+    const __m256i ones = _mm256_set1_epi16(1);
+    const int BLOCK = 32767;
+
+    __m256i total = _mm256_setzero_si256();
+    int i = 0;
+    while (i + 16 <= n)
+    {
+        __m256i acc = _mm256_setzero_si256();
+        for (int steps = 0; steps < BLOCK && i + 16 <= n; steps++, i += 16)
+        {
+            __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(col + i));
+            __m256i hit = _mm256_and_si256(_mm256_cmpeq_epi16(_mm256_max_epu16(x, vlo), x),
+                                           _mm256_cmpeq_epi16(_mm256_min_epu16(x, vhi), x));
+            acc = _mm256_sub_epi16(acc, hit);
         }
-        return -1; // not found
+        total = _mm256_add_epi32(total, _mm256_madd_epi16(acc, ones));
     }
 
-    // Week 09 helper: returns how many BPMs are stored in the vector
-    int getBpmCount() const { return static_cast<int>(bpmList.size()); }
+    int lanes[8];
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(lanes), total);
+    int sum = 0;
+    for (int k = 0; k < 8; k++)
+        sum += lanes[k];
+    return sum + countInRangeScalar(col + i, n - i, lo, hi);
+}
 
-    // Week 09 helper: returns BPM value at position i (uses .at() for bounds check)
-    int getBpmAt(int i) const { return bpmList.at(i); }
+// Three compare+subtract accumulators per load; same 16-bit block trick as countInRange.
+DJ_TARGET("sse4.1")
+void energyHistogramSse41(const uint16_t* col, int n, EnergyCounts& out)
+{
+    const __m128i vLow = _mm_set1_epi16(LOW);
+    const __m128i vMed = _mm_set1_epi16(MEDIUM);
+    const __m128i vHigh = _mm_set1_epi16(HIGH);
+    const __m128i ones = _mm_set1_epi16(1);
+    const int BLOCK = 32767;
+
+    __m128i totLow = _mm_setzero_si128(), totMed = _mm_setzero_si128(), totHigh = _mm_setzero_si128();
+    int i = 0;
+    while (i + 8 <= n)
+    {
+        __m128i aLow = _mm_setzero_si128(), aMed = _mm_setzero_si128(), aHigh = _mm_setzero_si128();
+        for (int steps = 0; steps < BLOCK && i + 8 <= n; steps++, i += 8)
+        {
+            __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(col + i));
+            aLow = _mm_sub_epi16(aLow, _mm_cmpeq_epi16(x, vLow));
+            aMed = _mm_sub_epi16(aMed, _mm_cmpeq_epi16(x, vMed));
+            aHigh = _mm_sub_epi16(aHigh, _mm_cmpeq_epi16(x, vHigh));
+        }
+        totLow = _mm_add_epi32(totLow, _mm_madd_epi16(aLow, ones));
+        totMed = _mm_add_epi32(totMed, _mm_madd_epi16(aMed, ones));
+        totHigh = _mm_add_epi32(totHigh, _mm_madd_epi16(aHigh, ones));
+    }
 
-    ~TrackManager()
+    int lanes[3][4];
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(lanes[0]), totLow);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(lanes[1]), totMed);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(lanes[2]), totHigh);
+    for (int k = 0; k < 4; k++)
+    {
+        out.low += lanes[0][k];
+        out.medium += lanes[1][k];
+        out.high += lanes[2][k];
+    }
+    energyHistogramScalar(col + i, n - i, out);
+}
+
+DJ_TARGET("avx2")
+void energyHistogramAvx2(const uint16_t* col, int n, EnergyCounts& out)
+{
+    const __m256i vLow = _mm256_set1_epi16(LOW);
+    const __m256i vMed = _mm256_set1_epi16(MEDIUM);
+    const __m256i vHigh = _mm256_set1_epi16(HIGH);
+    const __m256i ones = _mm256_set1_epi16(1);
+    const int BLOCK = 32767;
+
+    __m256i totLow = _mm256_setzero_si256(), totMed = _mm256_setzero_si256(), totHigh = _mm256_setzero_si256();
+    int i = 0;
+    while (i + 16 <= n)
     {
-        // delete all owned objects
-        for (int i = 0; i < items.getSize(); i++)
+        __m256i aLow = _mm256_setzero_si256(), aMed = _mm256_setzero_si256(), aHigh = _mm256_setzero_si256();
+        for (int steps = 0; steps < BLOCK && i + 16 <= n; steps++, i += 16)
         {
-            TrackBase* p = items.rawAt(i);
-            delete p;
+            __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(col + i));
+            aLow = _mm256_sub_epi16(aLow, _mm256_cmpeq_epi16(x, vLow));
+            aMed = _mm256_sub_epi16(aMed, _mm256_cmpeq_epi16(x, vMed));
+            aHigh = _mm256_sub_epi16(aHigh, _mm256_cmpeq_epi16(x, vHigh));
         }
-        // DynamicArray destructor cleans up its internal array
+        totLow = _mm256_add_epi32(totLow, _mm256_madd_epi16(aLow, ones));
+        totMed = _mm256_add_epi32(totMed, _mm256_madd_epi16(aMed, ones));
+        totHigh = _mm256_add_epi32(totHigh, _mm256_madd_epi16(aHigh, ones));
     }
-};
 
-// -------------------- Main --------------------
-#ifndef _DEBUG
-int main()
+    int lanes[3][8];
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(lanes[0]), totLow);
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(lanes[1]), totMed);
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(lanes[2]), totHigh);
+    for (int k = 0; k < 8; k++)
+    {
+        out.low += lanes[0][k];
+        out.medium += lanes[1][k];
+        out.high += lanes[2][k];
+    }
+    energyHistogramScalar(col + i, n - i, out);
+}
+#endif
+
+// Kernel table for one SIMD level. forLevel() never hands out a level the CPU
+// lacks; best() is resolved once (thread-safe static init) and reused.
+struct ColumnScanner
 {
-#ifdef _MSC_VER
-    // Ensure leak-check is enabled (also enabled via CrtLeakGuard above).
-    _CrtSetDbgFlag(_CRTDBG_ALLOC_MEM_DF | _CRTDBG_LEAK_CHECK_DF);
+    SimdLevel level;
+    void (*findInRange)(const uint16_t*, int, uint16_t, uint16_t, vector<int>&);
+    int (*countInRange)(const uint16_t*, int, uint16_t, uint16_t);
+    void (*energyHistogram)(const uint16_t*, int, EnergyCounts&);
+
+    static ColumnScanner forLevel(SimdLevel requested)
+    {
+        static const SimdLevel supported = detectSimdLevel();
+        SimdLevel level = (requested > supported) ? supported : requested;
+
+        ColumnScanner s = { SIMD_SCALAR, findInRangeScalar, countInRangeScalar, energyHistogramScalar };
+#ifdef DJ_X86
+        if (level == SIMD_AVX2)
+            s = { SIMD_AVX2, findInRangeAvx2, countInRangeAvx2, energyHistogramAvx2 };
+        else if (level == SIMD_SSE41)
+            s = { SIMD_SSE41, findInRangeSse41, countInRangeSse41, energyHistogramSse41 };
 #endif
+        return s;
+    }
 
-    // Weeks 1-4 storage
-    Track library[MAX_TRACKS];
-    int trackCount = 0;
+    static const ColumnScanner& best()
+    {
+        static const ColumnScanner scanner = forLevel(SIMD_AVX2);
+        return scanner;
+    }
 
-    // Week 5/6/7 storage
-    TrackManager manager(2);
+    // Convenience wrappers (int bounds are clipped to the 16-bit column domain).
+    void findAll(const vector<uint16_t>& col, int lo, int hi, vector<int>& out) const
+    {
+        if (lo < 0) lo = 0;
+        if (hi > 0xFFFF) hi = 0xFFFF;
+        if (lo > hi || col.empty()) return;
+        findInRange(col.data(), static_cast<int>(col.size()), static_cast<uint16_t>(lo), static_cast<uint16_t>(hi), out);
+    }
 
-    showBanner();
+    int count(const vector<uint16_t>& col, int lo, int hi) const
+    {
+        if (lo < 0) lo = 0;
+        if (hi > 0xFFFF) hi = 0xFFFF;
+        if (lo > hi || col.empty()) return 0;
+        return countInRange(col.data(), static_cast<int>(col.size()), static_cast<uint16_t>(lo), static_cast<uint16_t>(hi));
+    }
 
-    // 3+ mixed inputs: string (spaces), int, double (legacy)
-    string djName = getNonEmptyLine("Enter your DJ name: ");
-    int targetBPM = getValidatedInt("Enter target BPM for your set (60-200): ", BPM_MIN, BPM_MAX);
-    double prepHours = getValidatedDouble("How many hours can you prep today (0.0 - 12.0)? ", 0.0, 12.0);
+    EnergyCounts histogram(const uint16_t* col, int n) const
+    {
+        EnergyCounts counts;
+        if (n > 0)
+            energyHistogram(col, n, counts);
+        return counts;
+    }
 
-    // Compound if/else block #1 (rubric requirement)
-    if (prepHours >= 4.0 && prepHours <= 8.0)
-        cout << "\nNice. With " << prepHours << " hours, you can build a solid set.\n";
-    else if (prepHours < 4.0 && targetBPM >= 125)
-        cout << "\nShort prep time + high BPM target. Keep transitions simple.\n";
-    else
-        cout << "\nPlan smart: focus on clean BPM ranges and energy flow.\n";
+    EnergyCounts histogram(const vector<uint16_t>& col) const
+    {
+        return histogram(col.data(), static_cast<int>(col.size()));
+    }
+};
 
-    // Compound if/else block #2 (rubric requirement)
-    if (targetBPM >= 128 && prepHours >= 5.0)
-        cout << "Recommendation: build an energy climb into a peak-hour section.\n";
-    else
-        cout << "Recommendation: keep a steady groove and avoid risky key jumps.\n";
+// True when v is stored exactly in a 16-bit column. TrackManager rejects
+// BPMs outside this range, so its BPM column always matches the objects.
+inline bool fitsColumn(int v) { return v >= 0 && v <= 0xFFFF; }
 
-    // Fixed-count for loop (rubric requirement)
-    cout << "\nQuick Set-Prep Tips:\n";
-    const int TIP_COUNT = 3;
-    for (int i = 1; i <= TIP_COUNT; i++)
+// Packs an int into the 16-bit column domain (values that do not fit are
+// clamped; only raw scanner columns built outside the manager can hit this).
+inline uint16_t packColumnValue(int v)
+{
+    if (v < 0) return 0;
+    if (v > 0xFFFF) return 0xFFFF;
+    return static_cast<uint16_t>(v);
+}
+
+// -------------------- Library Engine: BPM Bucket Index --------------------
+// One bucket of track ids per valid BPM value (60..200). A +/-N BPM window
+// query visits only the 2N+1 buckets in range instead of the whole library.
+// Tracks whose BPM was never validated (outside 60..200) go to a small
+// 'outliers' list that queries check directly, so results stay exact.
+// Ids are stable TrackId slot numbers, so insert and erase are both O(1):
+// posOf[id] remembers where the id sits and erase swaps the bucket's last
+// entry into the hole (order inside one bucket is therefore not kept).
+class BpmBucketIndex
+{
+private:
+    vector<int> buckets[BPM_BUCKETS];
+    vector<int> outliers;
+    vector<int> outlierBpms;
+    vector<int> posOf;
+    int count = 0;
+
+    static bool inRange(int bpm) { return bpm >= BPM_MIN && bpm <= BPM_MAX; }
+
+public:
+    int getCount() const { return count; }
+
+    // Number of tracks stored at exactly this BPM.
+    int bucketSize(int bpm) const
     {
-        if (i == 1) cout << "  1) Group tracks by BPM buckets.\n";
-        if (i == 2) cout << "  2) Keep keys compatible when possible.\n";
-        if (i == 3) cout << "  3) Increase energy gradually.\n";
+        if (inRange(bpm))
+            return static_cast<int>(buckets[bpm - BPM_MIN].size());
+
+        int matches = 0;
+        for (int b : outlierBpms)
+            if (b == bpm) matches++;
+        return matches;
     }
 
-    int choice = 0;
-    do
+    // Ids stored at exactly this BPM. Only BPM_MIN..BPM_MAX have a bucket;
+    // any other BPM throws out_of_range (use collectOutliers() for those).
+    const vector<int>& bucket(int bpm) const
     {
-        showMenu();
-        choice = getMenuChoice(MENU_MIN, MENU_MAX);
+        if (!inRange(bpm))
+            throw out_of_range("BpmBucketIndex::bucket BPM outside " + to_string(BPM_MIN) + ".." + to_string(BPM_MAX));
+        return buckets[bpm - BPM_MIN];
+    }
 
-        switch (choice)
-        {
-        case 1:
-            addTrack(library, trackCount);
-            break;
-        case 2:
-            printLibrary(library, trackCount);
-            break;
-        case 3:
-            recommendNextTracks(library, trackCount);
-            break;
-        case 4:
-            saveReportToFile(library, trackCount, "DJ_Set_Report.txt");
-            break;
+    void insert(int id, int bpm)
+    {
+        if (id >= static_cast<int>(posOf.size()))
+            posOf.resize(static_cast<size_t>(id) + 1, -1);
 
-        case 5:
+        if (inRange(bpm))
         {
-            cout << "\n--- Add Local Track (Week 7) ---\n";
-            string t = getNonEmptyLine("Title: ");
-            int bpm = getValidatedInt("BPM (60-200): ", BPM_MIN, BPM_MAX);
-            EnergyLevel e = getEnergyFromUser();
-            string path = getNonEmptyLine("File path (ex: track.wav): ");
-            string noteText = getNonEmptyLine("Notes (mix notes): ");
+            vector<int>& b = buckets[bpm - BPM_MIN];
+            posOf[id] = static_cast<int>(b.size());
+            b.push_back(id);
+        }
+        else
+        {
+            posOf[id] = static_cast<int>(outliers.size());
+            outliers.push_back(id);
+            outlierBpms.push_back(bpm);
+        }
+        count++;
+    }
 
-            manager += new LocalTrack(t, bpm, e, path, MixNotes(noteText));
-            cout << "Local track added (Week 7).\n";
-            break;
+    // bpm must be the value the id was inserted with.
+    void erase(int id, int bpm)
+    {
+        int pos = posOf[id];
+        if (inRange(bpm))
+        {
+            vector<int>& b = buckets[bpm - BPM_MIN];
+            int moved = b.back();
+            b[pos] = moved;
+            posOf[moved] = pos;
+            b.pop_back();
         }
-        case 6:
+        else
         {
-            cout << "\n--- Add Stream Track (Week 7) ---\n";
-            string t = getNonEmptyLine("Title: ");
-            int bpm = getValidatedInt("BPM (60-200): ", BPM_MIN, BPM_MAX);
-            EnergyLevel e = getEnergyFromUser();
-            string platform = getNonEmptyLine("Platform (ex: Spotify): ");
-            string noteText = getNonEmptyLine("Notes (mix notes): ");
+            int moved = outliers.back();
+            outliers[pos] = moved;
+            outlierBpms[pos] = outlierBpms.back();
+            posOf[moved] = pos;
+            outliers.pop_back();
+            outlierBpms.pop_back();
+        }
+        posOf[id] = -1;
+        count--;
+    }
 
-            manager += new StreamTrack(t, bpm, e, platform, MixNotes(noteText));
-            cout << "Stream track added (Week 7).\n";
-            break;
+    // Appends every id with |bpm - center| <= radius to out (slowest bucket first).
+    void collectWindow(int center, int radius, vector<int>& out) const
+    {
+        collectRange(center - radius, center + radius, out);
+    }
+
+    // Appends every id with lo <= bpm <= hi to out (slowest bucket first).
+    void collectRange(int lo, int hi, vector<int>& out) const
+    {
+        if (lo > hi) return;
+        int first = (lo < BPM_MIN) ? BPM_MIN : lo;
+        int last = (hi > BPM_MAX) ? BPM_MAX : hi;
+
+        for (int bpm = first; bpm <= last; bpm++)
+        {
+            const vector<int>& b = buckets[bpm - BPM_MIN];
+            out.insert(out.end(), b.begin(), b.end());
         }
-        case 7:
-            cout << "\n==================== WEEK 7 LIBRARY ====================\n";
-            manager.printAll(cout);
-            // NEW Week 08 recursive feature
-            cout << "High-energy tracks (recursive): "
-                << manager.countHighEnergyRecursive() << "\n";
 
-            // operator[] now throws if invalid, so we only do it if size > 0
-            if (manager.getSize() > 0)
-            {
-                try
-                {
-                    cout << "One-line summary (operator<<): " << *manager[0] << "\n";
-                }
-                catch (const exception& ex)
-                {
-                    cout << "Unexpected error: " << ex.what() << "\n";
-                }
-            }
-            break;
+        collectOutliers(lo, hi, out);
+    }
 
-        case 8:
+    // Only the out-of-range (never validated) BPMs within lo..hi.
+    void collectOutliers(int lo, int hi, vector<int>& out) const
+    {
+        for (size_t i = 0; i < outliers.size(); i++)
+            if (outlierBpms[i] >= lo && outlierBpms[i] <= hi)
+                out.push_back(outliers[i]);
+    }
+
+    void clear()
+    {
+        for (int b = 0; b < BPM_BUCKETS; b++)
+            buckets[b].clear();
+        outliers.clear();
+        outlierBpms.clear();
+        posOf.clear();
+        count = 0;
+    }
+};
+
+// -------------------- Library Engine: Slab Pool Allocator --------------------
+// Typed arena for track objects. Memory is requested one SLAB (slabSize
+// objects) at a time; objects are placement-constructed into free slots.
+// destroy() runs the destructor and pushes the slot onto a free list that the
+// next create() reuses. All slabs are released in bulk when the pool dies; the
+// owner must destroy its live objects first (TrackManager's destructor does).
+struct PoolStats
+{
+    int slabAllocations = 0; // one heap allocation per slab, never per object
+    int liveObjects = 0;
+    int capacity = 0;        // slots across all slabs
+    int reusedSlots = 0;     // create() calls served from the free list
+};
+
+template <class T>
+class SlabPool
+{
+private:
+    union Slot
+    {
+        Slot* next;
+        alignas(T) unsigned char storage[sizeof(T)];
+    };
+
+    vector<Slot*> slabs;
+    Slot* freeList = nullptr;
+    int slabSize;
+    int usedInLastSlab; // bump pointer inside the newest slab
+    PoolStats stats;
+
+    SlabPool(const SlabPool&) = delete;
+    SlabPool& operator=(const SlabPool&) = delete;
+
+    Slot* takeSlot()
+    {
+        if (freeList != nullptr)
         {
-            cout << "\n--- Remove Week 7 Track ---\n";
-            if (manager.getSize() == 0)
+            Slot* s = freeList;
+            freeList = s->next;
+            stats.reusedSlots++;
+            return s;
+        }
+
+        if (slabs.empty() || usedInLastSlab == slabSize)
+        {
+            slabs.push_back(static_cast<Slot*>(::operator new(sizeof(Slot) * static_cast<size_t>(slabSize))));
+            usedInLastSlab = 0;
+            stats.slabAllocations++;
+            stats.capacity += slabSize;
+        }
+        return slabs.back() + usedInLastSlab++;
+    }
+
+public:
+    SlabPool(int objectsPerSlab = 1024)
+        : slabSize(objectsPerSlab < 1 ? 1 : objectsPerSlab), usedInLastSlab(0)
+    {
+    }
+
+    template <class... Args>
+    T* create(Args&&... args)
+    {
+        Slot* s = takeSlot();
+        try
+        {
+            T* p = ::new (static_cast<void*>(s->storage)) T(forward<Args>(args)...);
+            stats.liveObjects++;
+            return p;
+        }
+        catch (...)
+        {
+            s->next = freeList; // slot goes back, unused
+            freeList = s;
+            throw;
+        }
+    }
+
+    void destroy(T* p)
+    {
+        p->~T();
+        Slot* s = reinterpret_cast<Slot*>(p);
+        s->next = freeList;
+        freeList = s;
+        stats.liveObjects--;
+    }
+
+    const PoolStats& getStats() const { return stats; }
+
+    ~SlabPool()
+    {
+        for (Slot* slab : slabs)
+            ::operator delete(slab);
+    }
+};
+
+// -------------------- Library Engine: Stable Track Handles --------------------
+// A TrackId names one track for as long as it lives, no matter how the
+// library is reordered or what else is removed. It is a slot number plus the
+// slot's generation; removing a track bumps the generation, so any TrackId
+// still held for it is detected as stale instead of silently naming whatever
+// track moved into its old position.
+struct TrackId
+{
+    uint32_t slot = 0xFFFFFFFFu;
+    uint32_t generation = 0;
+
+    bool isValid() const { return slot != 0xFFFFFFFFu; }
+    bool operator==(const TrackId& other) const { return slot == other.slot && generation == other.generation; }
+    bool operator!=(const TrackId& other) const { return !(*this == other); }
+};
+
+// Slot map: slot -> dense row (O(1) insert / erase / lookup).
+// Freed slots are recycled LIFO with their generation already bumped.
+class TrackSlotMap
+{
+private:
+    struct Slot
+    {
+        int row;              // dense row, or -1 when the slot is free
+        uint32_t generation;
+    };
+
+    vector<Slot> slots;
+    vector<uint32_t> freeSlots;
+
+public:
+    TrackId insert(int row)
+    {
+        TrackId id;
+        if (!freeSlots.empty())
+        {
+            id.slot = freeSlots.back();
+            freeSlots.pop_back();
+        }
+        else
+        {
+            id.slot = static_cast<uint32_t>(slots.size());
+            slots.push_back({ -1, 0 });
+        }
+        slots[id.slot].row = row;
+        id.generation = slots[id.slot].generation;
+        return id;
+    }
+
+    void erase(uint32_t slot)
+    {
+        slots[slot].row = -1;
+        slots[slot].generation++;
+        freeSlots.push_back(slot);
+    }
+
+    void setRow(uint32_t slot, int row) { slots[slot].row = row; }
+
+    // Dense row for a live id, -1 for a stale or invalid one.
+    int rowOf(TrackId id) const
+    {
+        if (id.slot >= slots.size())
+            return -1;
+        const Slot& s = slots[id.slot];
+        return (s.generation == id.generation) ? s.row : -1;
+    }
+
+    uint32_t generationOf(uint32_t slot) const { return slots[slot].generation; }
+    int slotCount() const { return static_cast<int>(slots.size()); }
+
+    void reserve(int cap) { slots.reserve(cap); }
+};
+
+// -------------------- Library Engine: Columnar Track Store --------------------
+// Structure-of-arrays storage. Row i of every column describes the same track:
+//   handles[i]  -> TrackBase* (cold data: strings, notes, path/platform)
+//   bpm, energy -> packed 16-bit columns (ColumnScanner SIMD kernels)
+//   type        -> TrackTypeTag (LocalTrack / StreamTrack)
+//   origin      -> TrackOrigin (plain new vs. TrackManager's SlabPool)
+//   keyId, genreId, artistId -> global Symbol ids; titleId -> the store's own SymbolTable
+//   harmonic    -> parsed Camelot key id 0..23 (NO_KEY_PACKED if unknown)
+//   slotOf      -> TrackId slot of the row (TrackSlotMap maps it back)
+// Rows are dense: removal moves the LAST row into the hole (O(1)), so row
+// numbers are positions, while TrackIds stay valid until their track is removed.
+// Hot scans (searches, energy/genre counts, recommendations) read only the
+// dense columns, never the heap objects. The store does not own the objects;
+// TrackManager deletes them.
+enum TrackTypeTag { TAG_LOCAL = 0, TAG_STREAM = 1 };
+enum TrackOrigin { ORIGIN_HEAP = 0, ORIGIN_POOL = 1 };
+
+class TrackStore
+{
+private:
+    DynamicArray<TrackBase*> handles;
+    vector<uint16_t> bpm;
+    vector<uint16_t> energy;
+    vector<uint8_t> type;
+    vector<uint8_t> origin;
+    vector<uint32_t> keyId;
+    vector<uint8_t> harmonic;
+    vector<uint32_t> genreId;
+    vector<uint32_t> artistId;
+    vector<uint32_t> titleId;
+    vector<uint32_t> slotOf;
+
+    TrackSlotMap slotMap;
+    SymbolTable titleNames; // titles are mostly unique: kept out of the global table
+    vector<int16_t> harmonicOfSymbol; // key symbol id -> key id, -2 = not parsed yet
+
+    // Key id of an interned key string, parsed once per distinct symbol. The
+    // cache belongs to this store, so it is only touched by store mutations
+    // (one thread at a time, like the symbol table the symbol came from).
+    uint8_t harmonicKeyOf(Symbol key)
+    {
+        uint32_t id = key.getId();
+        if (id >= harmonicOfSymbol.size())
+            harmonicOfSymbol.resize(id + 1, -2);
+        if (harmonicOfSymbol[id] == -2)
+            harmonicOfSymbol[id] = static_cast<int16_t>(parseHarmonicKey(key.str()));
+        return (harmonicOfSymbol[id] < 0) ? NO_KEY_PACKED : static_cast<uint8_t>(harmonicOfSymbol[id]);
+    }
+
+    template <class V>
+    static void gather(vector<V>& column, const vector<int>& order)
+    {
+        vector<V> sorted(column.size());
+        for (size_t k = 0; k < order.size(); k++)
+            sorted[k] = column[order[k]];
+        column.swap(sorted);
+    }
+
+    template <class V>
+    static void swapPop(vector<V>& column, int i)
+    {
+        column[i] = column.back();
+        column.pop_back();
+    }
+
+    template <class V>
+    static void swapValues(vector<V>& column, int i, int j)
+    {
+        V temp = column[i];
+        column[i] = column[j];
+        column[j] = temp;
+    }
+
+    TrackStore(const TrackStore&) = delete;
+    TrackStore& operator=(const TrackStore&) = delete;
+
+public:
+    TrackStore(int cap = 2)
+        : handles(cap)
+    {
+    }
+
+    int getSize() const { return handles.getSize(); }
+    int getCapacity() const { return handles.getCapacity(); }
+
+    void reserve(int cap)
+    {
+        handles.reserve(cap);
+        bpm.reserve(cap);
+        energy.reserve(cap);
+        type.reserve(cap);
+        origin.reserve(cap);
+        keyId.reserve(cap);
+        harmonic.reserve(cap);
+        genreId.reserve(cap);
+        artistId.reserve(cap);
+        titleId.reserve(cap);
+        slotOf.reserve(cap);
+        slotMap.reserve(cap);
+    }
+
+    TrackId pushBack(TrackBase* p, TrackOrigin from = ORIGIN_HEAP)
+    {
+        handles.pushBack(p);
+        bpm.push_back(packColumnValue(p->getBpm()));
+        energy.push_back(static_cast<uint16_t>(p->getEnergy()));
+        type.push_back(static_cast<uint8_t>(dynamic_cast<StreamTrack*>(p) ? TAG_STREAM : TAG_LOCAL));
+        origin.push_back(static_cast<uint8_t>(from));
+        keyId.push_back(p->getKeySymbol().getId());
+        harmonic.push_back(harmonicKeyOf(p->getKeySymbol()));
+        genreId.push_back(p->getGenreSymbol().getId());
+        artistId.push_back(p->getArtistSymbol().getId());
+        titleId.push_back(titleNames.intern(p->getTitle()));
+
+        TrackId id = slotMap.insert(getSize() - 1);
+        slotOf.push_back(id.slot);
+        return id;
+    }
+
+    // Erases row i in O(1): the last row moves into i. Its TrackId is retired.
+    // Throws out_of_range for an invalid row.
+    void swapRemove(int i)
+    {
+        handles.swapRemoveAt(i);
+        swapPop(bpm, i);
+        swapPop(energy, i);
+        swapPop(type, i);
+        swapPop(origin, i);
+        swapPop(keyId, i);
+        swapPop(harmonic, i);
+        swapPop(genreId, i);
+        swapPop(artistId, i);
+        swapPop(titleId, i);
+
+        slotMap.erase(slotOf[i]);
+        swapPop(slotOf, i);
+        if (i < getSize())
+            slotMap.setRow(slotOf[i], i); // the moved row's handle follows it
+    }
+
+    // Re-reads the hot columns of row i from its object (after an edit).
+    void refreshRow(int i)
+    {
+        TrackBase* p = handles.rawAt(i);
+        bpm[i] = packColumnValue(p->getBpm());
+        energy[i] = static_cast<uint16_t>(p->getEnergy());
+        keyId[i] = p->getKeySymbol().getId();
+        harmonic[i] = harmonicKeyOf(p->getKeySymbol());
+        genreId[i] = p->getGenreSymbol().getId();
+        artistId[i] = p->getArtistSymbol().getId();
+        titleId[i] = titleNames.intern(p->getTitle());
+    }
+
+    void swapRows(int i, int j)
+    {
+        TrackBase* temp = handles.rawAt(i);
+        handles.rawAt(i) = handles.rawAt(j);
+        handles.rawAt(j) = temp;
+        swapValues(bpm, i, j);
+        swapValues(energy, i, j);
+        swapValues(type, i, j);
+        swapValues(origin, i, j);
+        swapValues(keyId, i, j);
+        swapValues(harmonic, i, j);
+        swapValues(genreId, i, j);
+        swapValues(artistId, i, j);
+        swapValues(titleId, i, j);
+        swapValues(slotOf, i, j);
+        slotMap.setRow(slotOf[i], i);
+        slotMap.setRow(slotOf[j], j);
+    }
+
+    // Reorders every column: new row k = old row order[k].
+    void permute(const vector<int>& order)
+    {
+        DynamicArray<TrackBase*> sorted(handles.getCapacity());
+        for (size_t k = 0; k < order.size(); k++)
+            sorted.pushBack(handles.rawAt(order[k]));
+        handles = move(sorted);
+
+        gather(bpm, order);
+        gather(energy, order);
+        gather(type, order);
+        gather(origin, order);
+        gather(keyId, order);
+        gather(harmonic, order);
+        gather(genreId, order);
+        gather(artistId, order);
+        gather(titleId, order);
+        gather(slotOf, order);
+        for (int row = 0; row < getSize(); row++)
+            slotMap.setRow(slotOf[row], row);
+    }
+
+    // Row access (caller guarantees 0 <= i < size unless noted)
+    TrackBase* handleAt(int i) const { return handles.at(i); } // throws out_of_range
+    TrackBase* handle(int i) const { return handles.rawAt(i); }
+    int bpmAt(int i) const { return bpm.at(i); }               // Week 09 .at() bounds check
+    EnergyLevel energyAt(int i) const { return static_cast<EnergyLevel>(energy[i]); }
+    TrackTypeTag typeAt(int i) const { return static_cast<TrackTypeTag>(type[i]); }
+    TrackOrigin originAt(int i) const { return static_cast<TrackOrigin>(origin[i]); }
+
+    // Handles
+    TrackId idAt(int i) const
+    {
+        TrackId id;
+        id.slot = slotOf[i];
+        id.generation = slotMap.generationOf(id.slot);
+        return id;
+    }
+    int rowOf(TrackId id) const { return slotMap.rowOf(id); } // -1 if stale
+    int slotCount() const { return slotMap.slotCount(); }     // slots ever handed out
+    int rowOfSlot(uint32_t slot) const
+    {
+        TrackId id;
+        id.slot = slot;
+        id.generation = slotMap.generationOf(slot);
+        return slotMap.rowOf(id);
+    }
+
+    // Dense columns
+    const vector<uint16_t>& bpmColumn() const { return bpm; }
+    const vector<uint16_t>& energyColumn() const { return energy; }
+    const vector<uint8_t>& typeColumn() const { return type; }
+    const vector<uint32_t>& keyColumn() const { return keyId; }
+    const vector<uint8_t>& harmonicKeyColumn() const { return harmonic; }
+    const vector<uint32_t>& genreColumn() const { return genreId; }
+    const vector<uint32_t>& artistColumn() const { return artistId; }
+    const vector<uint32_t>& titleColumn() const { return titleId; }
+
+    const SymbolTable& titles() const { return titleNames; }
+};
+
+// -------------------- Library Engine: Aggregates --------------------
+// Running totals of a TrackStore, updated per row on every add/remove/edit so
+// average BPM, min/max BPM, genre/key counts and energy counts need no scan.
+// Min/max come from a per-BPM count histogram (141 buckets; unvalidated BPMs
+// go to a small ordered map), so removing the current minimum stays cheap.
+
+// Point-in-time copy of the aggregates (written into saved reports).
+struct AggregateSnapshot
+{
+    int count = 0;
+    long long bpmSum = 0;
+    int minBpm = 0;
+    int maxBpm = 0;
+    double averageBpm = 0.0;
+    EnergyCounts energy;
+    vector<pair<string, int>> genres; // most common first, then by name
+    vector<pair<string, int>> keys;
+
+    void writeTo(ostream& out) const
+    {
+        out << "Library stats: " << count << " tracks";
+        if (count > 0)
+            out << ", BPM min/avg/max " << minBpm << " / " << fixed << setprecision(1)
+                << averageBpm << " / " << maxBpm;
+        out << "\n";
+        out << "Energy: Low " << energy.low << ", Medium " << energy.medium
+            << ", High " << energy.high << "\n";
+        writeCounts(out, "Genres: ", genres);
+        writeCounts(out, "Keys: ", keys);
+    }
+
+private:
+    static void writeCounts(ostream& out, const string& label, const vector<pair<string, int>>& counts)
+    {
+        out << label;
+        if (counts.empty())
+            out << "(none)";
+        for (size_t i = 0; i < counts.size(); i++)
+            out << (i == 0 ? "" : ", ") << counts[i].first << " x" << counts[i].second;
+        out << "\n";
+    }
+};
+
+class LibraryAggregates
+{
+private:
+    int count = 0;
+    long long bpmSum = 0;
+    int bpmCounts[BPM_BUCKETS] = {};
+    map<int, int> outlierBpmCounts;
+    int minBpm = 0; // valid only while count > 0
+    int maxBpm = 0;
+    EnergyCounts energy;
+    vector<int> genreCounts; // indexed by global Symbol id
+    vector<int> keyCounts;
+    int harmonicCounts[HARMONIC_KEYS] = {}; // by parsed key id ("Am" and "8A" together)
+
+    static void bump(vector<int>& counts, uint32_t id, int delta)
+    {
+        if (id >= counts.size())
+            counts.resize(id + 1, 0);
+        counts[id] += delta;
+    }
+
+    int countAtBpm(int bpm) const
+    {
+        if (bpm >= BPM_MIN && bpm <= BPM_MAX)
+            return bpmCounts[bpm - BPM_MIN];
+        map<int, int>::const_iterator it = outlierBpmCounts.find(bpm);
+        return (it == outlierBpmCounts.end()) ? 0 : it->second;
+    }
+
+    // Smallest (dir = +1) or largest (dir = -1) stored BPM, starting the walk at 'from'.
+    int scanBpm(int from, int dir) const
+    {
+        if (dir > 0)
+        {
+            if (!outlierBpmCounts.empty() && outlierBpmCounts.begin()->first < BPM_MIN)
+                return outlierBpmCounts.begin()->first;
+            for (int b = (from < BPM_MIN ? BPM_MIN : from); b <= BPM_MAX; b++)
+                if (bpmCounts[b - BPM_MIN] > 0)
+                    return b;
+            return outlierBpmCounts.begin()->first; // only high outliers left
+        }
+
+        if (!outlierBpmCounts.empty() && outlierBpmCounts.rbegin()->first > BPM_MAX)
+            return outlierBpmCounts.rbegin()->first;
+        for (int b = (from > BPM_MAX ? BPM_MAX : from); b >= BPM_MIN; b--)
+            if (bpmCounts[b - BPM_MIN] > 0)
+                return b;
+        return outlierBpmCounts.rbegin()->first; // only low outliers left
+    }
+
+    static vector<pair<string, int>> namedCounts(const vector<int>& counts)
+    {
+        vector<pair<string, int>> named;
+        for (size_t id = 0; id < counts.size(); id++)
+            if (counts[id] > 0)
+                named.push_back(make_pair(Symbol::fromId(static_cast<uint32_t>(id)).str(), counts[id]));
+        sort(named.begin(), named.end(), [](const pair<string, int>& a, const pair<string, int>& b) {
+            return (a.second != b.second) ? a.second > b.second : a.first < b.first;
+        });
+        return named;
+    }
+
+public:
+    void addRow(const TrackStore& store, int row)
+    {
+        int bpm = store.bpmColumn()[row];
+        if (bpm >= BPM_MIN && bpm <= BPM_MAX)
+            bpmCounts[bpm - BPM_MIN]++;
+        else
+            outlierBpmCounts[bpm]++;
+
+        if (count == 0 || bpm < minBpm) minBpm = bpm;
+        if (count == 0 || bpm > maxBpm) maxBpm = bpm;
+        count++;
+        bpmSum += bpm;
+
+        energy.adjust(store.energyColumn()[row], +1);
+        bump(genreCounts, store.genreColumn()[row], +1);
+        bump(keyCounts, store.keyColumn()[row], +1);
+        if (store.harmonicKeyColumn()[row] != NO_KEY_PACKED)
+            harmonicCounts[store.harmonicKeyColumn()[row]]++;
+    }
+
+    void removeRow(const TrackStore& store, int row)
+    {
+        int bpm = store.bpmColumn()[row];
+        if (bpm >= BPM_MIN && bpm <= BPM_MAX)
+            bpmCounts[bpm - BPM_MIN]--;
+        else if (--outlierBpmCounts[bpm] == 0)
+            outlierBpmCounts.erase(bpm);
+
+        count--;
+        bpmSum -= bpm;
+        if (count > 0 && countAtBpm(bpm) == 0)
+        {
+            if (bpm == minBpm) minBpm = scanBpm(bpm + 1, +1);
+            if (bpm == maxBpm) maxBpm = scanBpm(bpm - 1, -1);
+        }
+
+        energy.adjust(store.energyColumn()[row], -1);
+        bump(genreCounts, store.genreColumn()[row], -1);
+        bump(keyCounts, store.keyColumn()[row], -1);
+        if (store.harmonicKeyColumn()[row] != NO_KEY_PACKED)
+            harmonicCounts[store.harmonicKeyColumn()[row]]--;
+    }
+
+    int getCount() const { return count; }
+    long long getBpmSum() const { return bpmSum; }
+    double averageBpm() const { return (count == 0) ? 0.0 : static_cast<double>(bpmSum) / count; }
+    int getMinBpm() const { return (count == 0) ? 0 : minBpm; } // 0 when empty
+    int getMaxBpm() const { return (count == 0) ? 0 : maxBpm; }
+    const EnergyCounts& getEnergy() const { return energy; }
+
+    int genreCount(uint32_t genreId) const { return (genreId < genreCounts.size()) ? genreCounts[genreId] : 0; }
+    int keyCount(uint32_t keyId) const { return (keyId < keyCounts.size()) ? keyCounts[keyId] : 0; }
+    int harmonicKeyCount(int keyId) const { return (keyId >= 0 && keyId < HARMONIC_KEYS) ? harmonicCounts[keyId] : 0; }
+
+    AggregateSnapshot snapshot() const
+    {
+        AggregateSnapshot snap;
+        snap.count = count;
+        snap.bpmSum = bpmSum;
+        snap.minBpm = getMinBpm();
+        snap.maxBpm = getMaxBpm();
+        snap.averageBpm = averageBpm();
+        snap.energy = energy;
+        snap.genres = namedCounts(genreCounts);
+        snap.keys = namedCounts(keyCounts);
+        return snap;
+    }
+};
+
+// -------------------- Library Engine: Tempo Tolerance --------------------
+// How far a track's tempo may sit from the target and still be mixable:
+//   window      +/-windowBpm, or +/-windowPercent of the target when that is set
+//   half/double a 70 BPM track also fits a 140 BPM target (played double time),
+//               and a 280 BPM track fits it at half time
+//   pitch range the pitch fader can only move a track +/-pitchRange percent, so
+//               tracks that would need a bigger change are left out
+// Every ratio turns into one closed BPM interval, so a query is at most three
+// bucket-range lookups in BpmBucketIndex instead of a pass over the library.
+struct TempoTolerance
+{
+    int windowBpm = 5;          // +/- BPM around the target; < 0 = no BPM window
+    double windowPercent = 0.0; // +/- percent of the target (replaces windowBpm when > 0)
+    bool halfDouble = false;    // also match at 0.5x / 2x tempo
+    double pitchRange = 0.0;    // +/- percent the pitch fader can move a track; 0 = no limit
+
+    static TempoTolerance bpm(int window)
+    {
+        TempoTolerance t;
+        t.windowBpm = window;
+        return t;
+    }
+
+    static TempoTolerance percent(double window)
+    {
+        TempoTolerance t;
+        t.windowPercent = window;
+        return t;
+    }
+
+    // Anything the fader can reach (no separate BPM window).
+    static TempoTolerance pitchFader(double range)
+    {
+        TempoTolerance t;
+        t.windowBpm = -1;
+        t.pitchRange = range;
+        return t;
+    }
+};
+
+// BPM interval of the tracks that match at one tempo ratio (track BPM x ratio
+// lands near the target).
+struct TempoRange
+{
+    int lo;
+    int hi;
+    double ratio;
+};
+
+// One match: how the track is played against the target.
+struct TempoMatch
+{
+    TrackId id;
+    int bpm;
+    double ratio;        // 1.0, 2.0 (half-time track played double) or 0.5
+    double pitchPercent; // fader change that lands exactly on the target
+};
+
+// Pitch change (percent) that takes bpm x ratio to targetBpm.
+inline double tempoPitchPercent(int targetBpm, int bpm, double ratio)
+{
+    return (targetBpm / (bpm * ratio) - 1.0) * 100.0;
+}
+
+// Matching BPM intervals for targetBpm, ratio 1 first, then 2 and 0.5.
+// Intervals never overlap (an overlapping edge stays with the earlier ratio),
+// so a track is reported once even with very wide windows.
+inline vector<TempoRange> tempoRanges(int targetBpm, const TempoTolerance& tol)
+{
+    const double EPS = 1e-9;            // keep exact edges (ex: 135 / 2.0) inside
+    const double MAX_PITCH = 0.95;      // a fader cannot stop the track
+    static const double RATIOS[] = { 1.0, 2.0, 0.5 };
+
+    vector<TempoRange> ranges;
+    if (targetBpm <= 0)
+        return ranges;
+
+    // Interval of effective tempos (bpm x ratio) that match.
+    double lo = 0.0;
+    double hi = numeric_limits<double>::max();
+    if (tol.windowPercent > 0.0)
+    {
+        lo = targetBpm * (1.0 - tol.windowPercent / 100.0);
+        hi = targetBpm * (1.0 + tol.windowPercent / 100.0);
+    }
+    else if (tol.windowBpm >= 0)
+    {
+        lo = targetBpm - tol.windowBpm;
+        hi = targetBpm + tol.windowBpm;
+    }
+    if (tol.pitchRange > 0.0)
+    {
+        double pitch = (tol.pitchRange / 100.0 > MAX_PITCH) ? MAX_PITCH : tol.pitchRange / 100.0;
+        lo = max(lo, targetBpm / (1.0 + pitch));
+        hi = min(hi, targetBpm / (1.0 - pitch));
+    }
+    if (hi == numeric_limits<double>::max())
+        hi = static_cast<double>(numeric_limits<int>::max() / 2); // no limit at all
+
+    int ratioCount = tol.halfDouble ? 3 : 1;
+    for (int r = 0; r < ratioCount; r++)
+    {
+        double ratio = RATIOS[r];
+        double first = ceil(lo / ratio - EPS);
+        double last = floor(hi / ratio + EPS);
+        int a = (first < 1.0) ? 1 : static_cast<int>(first);
+        int b = (last > numeric_limits<int>::max() / 2) ? numeric_limits<int>::max() / 2 : static_cast<int>(last);
+
+        for (const TempoRange& prev : ranges)
+        {
+            if (a >= prev.lo && a <= prev.hi) a = prev.hi + 1;
+            if (b >= prev.lo && b <= prev.hi) b = prev.lo - 1;
+        }
+        if (a <= b)
+            ranges.push_back({ a, b, ratio });
+    }
+    return ranges;
+}
+
+// -------------------- Library Engine: Transition Scoring --------------------
+// Shared by the neighbor index, SetBuilder and EnergyArcPlanner.
+struct TransitionWeights
+{
+    double bpm = 1.0;
+    double key = 1.0;
+    double energy = 1.0;
+};
+
+// Scores one transition from row 'from' to row 'to' (higher is better, 0 is a
+// neutral mix). Reads only the dense columns: no strings, no virtual calls.
+class TransitionScorer
+{
+private:
+    TransitionWeights weights;
+    int maxBpmJump;
+
+public:
+    TransitionScorer(const TransitionWeights& w = TransitionWeights(), int maxJump = 6)
+        : weights(w), maxBpmJump(maxJump < 1 ? 1 : maxJump) {
+    }
+
+    int getMaxBpmJump() const { return maxBpmJump; }
+
+    // Key term per KEY_COMPAT score (clash .. perfect); unknown keys count as loose.
+    static double keyValue(int keyScore)
+    {
+        static const double VALUE[4] = { -1.0, -0.25, 0.5, 1.0 };
+        return VALUE[keyScore];
+    }
+
+    double score(const TrackStore& store, int from, int to, double targetEnergy) const
+    {
+        return scoreValues(store.bpmColumn()[from], store.harmonicKeyColumn()[from], store.energyColumn()[from],
+            store.bpmColumn()[to], store.harmonicKeyColumn()[to], store.energyColumn()[to], targetEnergy);
+    }
+
+    // Same score from plain values (keys outside 0..23 are unknown).
+    double scoreValues(int fromBpm, int fromKey, int fromEnergy,
+        int toBpm, int toKey, int toEnergy, double targetEnergy) const
+    {
+        double bpmTerm = -static_cast<double>(absValue(toBpm - fromBpm)) / maxBpmJump;
+
+        bool known = fromKey >= 0 && fromKey < HARMONIC_KEYS && toKey >= 0 && toKey < HARMONIC_KEYS;
+        int keyScore = known ? KEY_COMPAT.score[fromKey][toKey] : KEY_SCORE_LOOSE;
+
+        return weights.bpm * bpmTerm + weights.key * keyValue(keyScore)
+            + weights.energy * energyTerm(fromEnergy, toEnergy, targetEnergy);
+    }
+
+    // bestAtDistance() only falls as the distance grows (so a scan ordered by
+    // BPM distance may stop early) when no weight is negative.
+    bool hasNegativeWeight() const
+    {
+        return weights.bpm < 0.0 || weights.key < 0.0 || weights.energy < 0.0;
+    }
+
+    // Highest score any track bpmDistance away can reach (best key, best
+    // energy). Scans ordered by BPM distance stop once this drops below the
+    // score they need (only valid when !hasNegativeWeight()).
+    double bestAtDistance(int bpmDistance, int fromEnergy, double targetEnergy) const
+    {
+        double bestKey = weights.key * keyValue(KEY_SCORE_CLASH);
+        for (int k = KEY_SCORE_LOOSE; k <= KEY_SCORE_PERFECT; k++)
+            bestKey = max(bestKey, weights.key * keyValue(k));
+
+        double bestEnergy = weights.energy * energyTerm(fromEnergy, LOW, targetEnergy);
+        for (int e = MEDIUM; e <= HIGH; e++)
+            bestEnergy = max(bestEnergy, weights.energy * energyTerm(fromEnergy, e, targetEnergy));
+
+        return -weights.bpm * static_cast<double>(bpmDistance) / maxBpmJump + bestKey + bestEnergy;
+    }
+
+private:
+    static double energyTerm(int fromEnergy, int toEnergy, double targetEnergy)
+    {
+        double e = toEnergy;
+        double term = -(e > targetEnergy ? e - targetEnergy : targetEnergy - e) / 2.0;
+        if (toEnergy + 2 <= fromEnergy)
+            term -= 0.5; // HIGH -> LOW empties the floor
+        return term;
+    }
+};
+
+// -------------------- Library Engine: Neighbor Index --------------------
+// "What can follow track X?" as a lookup: every track keeps its top-K next
+// tracks, ranked by TransitionScorer. A candidate must be within +/-bpmWindow
+// BPM and keep the energy steady or one step higher (the recommendNext rule).
+// Lists are keyed by TrackId slot, so sorting the library does not touch them.
+// Incremental upkeep (no full rebuild):
+//   insert Y: build Y's own list from its BPM window, then offer Y to every
+//             track in that window that may be followed by Y
+//   erase Y:  only the lists that contain Y (tracked in referencedBy[Y]) are
+//             rebuilt from their BPM windows
+struct NeighborOptions
+{
+    int k = 8;          // neighbors kept per track
+    int bpmWindow = 6;  // +/- BPM
+    TransitionWeights weights;
+};
+
+struct Neighbor
+{
+    TrackId id;
+    double score;
+};
+
+class NeighborIndex
+{
+private:
+    NeighborOptions options;
+    TransitionScorer scorer;
+    vector<vector<Neighbor>> lists;         // by slot, best first
+    vector<vector<uint32_t>> referencedBy;  // by slot: slots whose list contains it
+
+    static bool ranksBefore(const Neighbor& a, const Neighbor& b)
+    {
+        return a.score > b.score || (a.score == b.score && a.id.slot < b.id.slot);
+    }
+
+    static void dropRef(vector<uint32_t>& refs, uint32_t slot)
+    {
+        for (size_t i = 0; i < refs.size(); i++)
+            if (refs[i] == slot)
             {
-                cout << "Nothing to remove.\n";
+                refs[i] = refs.back();
+                refs.pop_back();
+                return;
+            }
+    }
+
+    // Sized to every slot the store has handed out, so no reference into
+    // 'lists' is invalidated while one update runs.
+    void ensureSlots(const TrackStore& store)
+    {
+        size_t needed = static_cast<size_t>(store.slotCount());
+        if (needed > lists.size())
+        {
+            lists.resize(needed);
+            referencedBy.resize(needed);
+        }
+    }
+
+    bool canFollow(const TrackStore& store, int from, int to) const
+    {
+        if (from == to)
+            return false;
+        int e = store.energyColumn()[from];
+        int next = store.energyColumn()[to];
+        return (next == e || next == e + 1)
+            && absValue(static_cast<int>(store.bpmColumn()[to]) - static_cast<int>(store.bpmColumn()[from])) <= options.bpmWindow;
+    }
+
+    double scoreOf(const TrackStore& store, int from, int to) const
+    {
+        // steady and +1 energy are both allowed, so neither is preferred
+        return scorer.score(store, from, to, store.energyColumn()[from] + 0.5);
+    }
+
+    // Recomputes the list of 'row' from its BPM window, skipping slot 'exclude'.
+    void rebuild(const TrackStore& store, const BpmBucketIndex& bpmIndex, int row, uint32_t exclude)
+    {
+        uint32_t slot = store.idAt(row).slot;
+        for (const Neighbor& n : lists[slot])
+            dropRef(referencedBy[n.id.slot], slot);
+        lists[slot].clear();
+
+        vector<int> window;
+        bpmIndex.collectWindow(store.bpmColumn()[row], options.bpmWindow, window);
+        vector<Neighbor>& list = lists[slot];
+        for (int candSlot : window)
+        {
+            if (static_cast<uint32_t>(candSlot) == exclude)
+                continue;
+            int cand = store.rowOfSlot(static_cast<uint32_t>(candSlot));
+            if (!canFollow(store, row, cand))
+                continue;
+            Neighbor n = { store.idAt(cand), scoreOf(store, row, cand) };
+            if (static_cast<int>(list.size()) == options.k && !ranksBefore(n, list.front()))
+                continue;
+            list.push_back(n);
+            push_heap(list.begin(), list.end(), ranksBefore); // front = worst kept
+            if (static_cast<int>(list.size()) > options.k)
+            {
+                pop_heap(list.begin(), list.end(), ranksBefore);
+                list.pop_back();
+            }
+        }
+        sort(list.begin(), list.end(), ranksBefore);
+        for (const Neighbor& n : list)
+            referencedBy[n.id.slot].push_back(slot);
+    }
+
+    // Offers 'to' as a neighbor of 'from' (list stays sorted, at most k long).
+    void offer(const TrackStore& store, int from, int to)
+    {
+        uint32_t fromSlot = store.idAt(from).slot;
+        vector<Neighbor>& list = lists[fromSlot];
+        Neighbor n = { store.idAt(to), scoreOf(store, from, to) };
+        if (static_cast<int>(list.size()) == options.k && !ranksBefore(n, list.back()))
+            return;
+
+        list.insert(upper_bound(list.begin(), list.end(), n, ranksBefore), n);
+        referencedBy[n.id.slot].push_back(fromSlot);
+        if (static_cast<int>(list.size()) > options.k)
+        {
+            dropRef(referencedBy[list.back().id.slot], fromSlot);
+            list.pop_back();
+        }
+    }
+
+public:
+    NeighborIndex(const NeighborOptions& opts = NeighborOptions())
+        : options(opts), scorer(opts.weights, opts.bpmWindow)
+    {
+        if (options.k < 1)
+            options.k = 1;
+    }
+
+    const NeighborOptions& getOptions() const { return options; }
+
+    // Full build for a library that is already in the store and bpmIndex.
+    void build(const TrackStore& store, const BpmBucketIndex& bpmIndex)
+    {
+        ensureSlots(store);
+        for (int row = 0; row < store.getSize(); row++)
+            rebuild(store, bpmIndex, row, store.idAt(row).slot);
+    }
+
+    // Call AFTER the row was added to the store and to bpmIndex.
+    void insert(const TrackStore& store, const BpmBucketIndex& bpmIndex, int row)
+    {
+        uint32_t slot = store.idAt(row).slot;
+        ensureSlots(store);
+        rebuild(store, bpmIndex, row, slot);
+
+        vector<int> window;
+        bpmIndex.collectWindow(store.bpmColumn()[row], options.bpmWindow, window);
+        for (int candSlot : window)
+        {
+            int cand = store.rowOfSlot(static_cast<uint32_t>(candSlot));
+            if (canFollow(store, cand, row))
+                offer(store, cand, row);
+        }
+    }
+
+    // Call BEFORE the row leaves the store and bpmIndex (or before an edit).
+    void erase(const TrackStore& store, const BpmBucketIndex& bpmIndex, int row)
+    {
+        uint32_t slot = store.idAt(row).slot;
+        ensureSlots(store);
+        for (const Neighbor& n : lists[slot])
+            dropRef(referencedBy[n.id.slot], slot);
+        lists[slot].clear();
+
+        vector<uint32_t> affected;
+        affected.swap(referencedBy[slot]);
+        for (uint32_t from : affected)
+            rebuild(store, bpmIndex, store.rowOfSlot(from), slot);
+    }
+
+    // Best-first neighbors of the track in 'slot' (empty for unknown slots).
+    const vector<Neighbor>& neighborsOfSlot(uint32_t slot) const
+    {
+        static const vector<Neighbor> none;
+        return (slot < lists.size()) ? lists[slot] : none;
+    }
+};
+
+// -------------------- Library Engine: Scored Recommendations --------------------
+// recommendNext() answers yes/no; this ranks. Every candidate within
+// maxBpmDistance gets one score:
+//   TransitionScorer terms (BPM distance / bpmScale, KEY_COMPAT, energy delta
+//   against "steady or one step up") + weights.genre when the genre matches.
+// The K best are kept in a bounded min-heap (worst kept result on top), so a
+// full pass would be O(n log K). The BPM index does better: buckets are
+// visited nearest BPM first and, once the heap is full, the scan stops as soon
+// as bestAtDistance() says no farther bucket can beat the K-th score (only
+// when every weight is >= 0; otherwise the whole window is scanned).
+struct RecommendWeights
+{
+    double bpm = 1.0;
+    double energy = 1.0;
+    double key = 1.0;
+    double genre = 0.5;  // bonus for the same genre as the playing track
+};
+
+struct RecommendQuery
+{
+    int bpm = 0;
+    EnergyLevel energy = MEDIUM;
+    int key = NO_KEY;          // 0..23 (parseHarmonicKey) or NO_KEY
+    string genre;              // "" = no genre affinity
+    int k = 10;
+    int maxBpmDistance = 20;   // candidates farther away are never returned
+    int bpmScale = 6;          // BPM distance that costs one 'bpm' weight
+    TrackId exclude;           // ex: the track that is playing
+    RecommendWeights weights;
+};
+
+// One ranked result; the parts of the score are kept for display and callers.
+struct ScoredTrack
+{
+    TrackId id;
+    double score = 0.0;   // higher is better
+    int bpm = 0;
+    int bpmDistance = 0;  // |bpm - query bpm|
+    int energyDelta = 0;  // track energy - query energy
+    int keyScore = KEY_SCORE_LOOSE; // KEY_SCORE_* (LOOSE when a key is unknown)
+    bool genreMatch = false;
+};
+
+// Best first: score, then nearer BPM, then lower slot (deterministic ties).
+inline bool scoredBefore(const ScoredTrack& a, const ScoredTrack& b)
+{
+    if (a.score != b.score) return a.score > b.score;
+    if (a.bpmDistance != b.bpmDistance) return a.bpmDistance < b.bpmDistance;
+    return a.id.slot < b.id.slot;
+}
+
+class ScoredRecommender
+{
+private:
+    const TrackStore& store;
+    const BpmBucketIndex& bpmIndex;
+
+public:
+    ScoredRecommender(const TrackStore& s, const BpmBucketIndex& index) : store(s), bpmIndex(index) {}
+
+    // Score for one row (no BPM limit applied).
+    ScoredTrack scoreRow(const RecommendQuery& q, int row) const
+    {
+        TransitionScorer scorer(scorerWeights(q), q.bpmScale);
+        return scoreRow(q, scorer, genreIdOf(q), row);
+    }
+
+    // The (up to) k best candidates, best first.
+    vector<ScoredTrack> top(const RecommendQuery& q) const
+    {
+        vector<ScoredTrack> heap;
+        if (q.k <= 0 || q.maxBpmDistance < 0)
+            return heap;
+        heap.reserve(static_cast<size_t>(q.k) + 1);
+
+        TransitionScorer scorer(scorerWeights(q), q.bpmScale);
+        long long genreId = genreIdOf(q);
+        double genreBonus = (genreId >= 0 && q.weights.genre > 0.0) ? q.weights.genre : 0.0;
+        // a negative weight can make a farther bucket score higher: scan them all
+        bool earlyStop = !scorer.hasNegativeWeight() && q.weights.genre >= 0.0;
+        double target = q.energy + 0.5;
+        size_t k = static_cast<size_t>(q.k);
+
+        // heap.front() is the worst result kept
+        auto offer = [&](int slot) {
+            int row = store.rowOfSlot(static_cast<uint32_t>(slot));
+            if (q.exclude.isValid() && store.idAt(row) == q.exclude)
+                return;
+            ScoredTrack t = scoreRow(q, scorer, genreId, row);
+            if (heap.size() == k && !scoredBefore(t, heap.front()))
+                return;
+            heap.push_back(t);
+            push_heap(heap.begin(), heap.end(), scoredBefore);
+            if (heap.size() > k)
+            {
+                pop_heap(heap.begin(), heap.end(), scoredBefore);
+                heap.pop_back();
+            }
+        };
+
+        // Unvalidated BPMs live outside the buckets (there are few of them);
+        // they are offered in distance order along with the buckets.
+        vector<int> outliers;
+        bpmIndex.collectOutliers(q.bpm - q.maxBpmDistance, q.bpm + q.maxBpmDistance, outliers);
+        vector<pair<int, int>> outlierByDistance;
+        for (int slot : outliers)
+            outlierByDistance.push_back({ absValue(store.bpmAt(store.rowOfSlot(static_cast<uint32_t>(slot))) - q.bpm), slot });
+        sort(outlierByDistance.begin(), outlierByDistance.end());
+        size_t nextOutlier = 0;
+
+        for (int d = 0; d <= q.maxBpmDistance; d++)
+        {
+            if (earlyStop && heap.size() == k && scorer.bestAtDistance(d, q.energy, target) + genreBonus < heap.front().score)
                 break;
+            for (; nextOutlier < outlierByDistance.size() && outlierByDistance[nextOutlier].first == d; nextOutlier++)
+                offer(outlierByDistance[nextOutlier].second);
+            for (int side = 0; side < (d == 0 ? 1 : 2); side++)
+            {
+                int bpm = (side == 0) ? q.bpm + d : q.bpm - d;
+                if (bpm < BPM_MIN || bpm > BPM_MAX)
+                    continue;
+                for (int slot : bpmIndex.bucket(bpm))
+                    offer(slot);
+            }
+        }
+
+        sort_heap(heap.begin(), heap.end(), scoredBefore);
+        return heap;
+    }
+
+private:
+    static TransitionWeights scorerWeights(const RecommendQuery& q)
+    {
+        TransitionWeights w;
+        w.bpm = q.weights.bpm;
+        w.key = q.weights.key;
+        w.energy = q.weights.energy;
+        return w;
+    }
+
+    static long long genreIdOf(const RecommendQuery& q)
+    {
+        return q.genre.empty() ? -1 : SymbolTable::global().find(q.genre);
+    }
+
+    ScoredTrack scoreRow(const RecommendQuery& q, const TransitionScorer& scorer, long long genreId, int row) const
+    {
+        ScoredTrack t;
+        t.id = store.idAt(row);
+        t.bpm = store.bpmAt(row);
+        t.bpmDistance = absValue(t.bpm - q.bpm);
+        int energy = store.energyColumn()[row];
+        t.energyDelta = energy - q.energy;
+        uint8_t key = store.harmonicKeyColumn()[row];
+        bool known = q.key >= 0 && q.key < HARMONIC_KEYS && key != NO_KEY_PACKED;
+        t.keyScore = known ? KEY_COMPAT.score[q.key][key] : KEY_SCORE_LOOSE;
+        t.genreMatch = genreId >= 0 && store.genreColumn()[row] == static_cast<uint32_t>(genreId);
+
+        t.score = scorer.scoreValues(q.bpm, known ? q.key : NO_KEY, q.energy,
+            t.bpm, known ? key : NO_KEY, energy, q.energy + 0.5);
+        if (t.genreMatch)
+            t.score += q.weights.genre;
+        return t;
+    }
+};
+
+// -------------------- Library Engine: Binary Snapshot --------------------
+// The library on disk, laid out so it can be used straight from a memory map:
+//
+//   SnapshotHeader      magic, version, byte-order mark, file size, LSN, counts
+//   bpm       int32[n]
+//   energy    uint8[n]
+//   type      uint8[n]     TrackTypeTag
+//   harmonic  uint8[n]     key id 0..23 or NO_KEY_PACKED
+//   strings   uint32[n] x SNAP_STRING_COLUMNS   ids into the string table
+//   offsets   uint64[stringCount + 1]           string i = heap[offsets[i], offsets[i+1])
+//   heap      char[]                            distinct strings, no terminators
+//
+// Every section starts on an 8-byte boundary, so the column pointers are
+// aligned in the mapping. Opening only checks the header and that every
+// section lies inside the file (O(1)); a string is bounds-checked and decoded
+// only when it is read. The LSN records the last log entry folded into the
+// snapshot (0 when there is none).
+// Only SnapshotView readers get that cost. The app's startup path
+// (recoverLibrary -> TrackManager::loadSnapshot) still builds one pooled
+// track object per row, with its strings copied out of the map, so startup
+// stays O(n) (~0.75 s for 1M tracks in benchSnapshot).
+const char SNAPSHOT_MAGIC[8] = { 'D', 'J', 'A', 'R', 'C', 'H', 'S', 'N' };
+const uint32_t SNAPSHOT_VERSION = 1;
+const uint32_t SNAPSHOT_BYTE_ORDER = 0x01020304u;
+const char* const LIBRARY_SNAPSHOT_FILE = "DJ_Library.djsnap";
+
+enum SnapshotString
+{
+    SNAP_TITLE = 0,
+    SNAP_ARTIST,
+    SNAP_GENRE,
+    SNAP_KEY,
+    SNAP_NOTES,
+    SNAP_LOCATION, // LocalTrack file path or StreamTrack platform
+    SNAP_STRING_COLUMNS
+};
+
+struct SnapshotHeader
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t byteOrder;
+    uint64_t headerSize;
+    uint64_t fileSize;
+    uint64_t lsn;
+    uint64_t trackCount;
+    uint64_t stringCount;
+    uint64_t bpmOffset;
+    uint64_t energyOffset;
+    uint64_t typeOffset;
+    uint64_t harmonicOffset;
+    uint64_t stringColumnOffset[SNAP_STRING_COLUMNS];
+    uint64_t stringOffsetsOffset;
+    uint64_t heapOffset;
+    uint64_t heapSize;
+};
+
+static_assert(sizeof(SnapshotHeader) % 8 == 0, "snapshot sections must stay 8-byte aligned");
+static_assert(is_trivially_copyable<SnapshotHeader>::value, "the header is written and mapped as raw bytes");
+
+// Flushes a FILE* all the way to the disk (fsync / _commit).
+inline bool syncFile(FILE* f)
+{
+    if (fflush(f) != 0)
+        return false;
+#ifdef _WIN32
+    return _commit(_fileno(f)) == 0;
+#else
+    return fsync(fileno(f)) == 0;
+#endif
+}
+
+// Moves 'from' over 'to' in one step, so readers see the old file or the new
+// one, never half of it.
+inline bool replaceFile(const string& from, const string& to)
+{
+#ifdef _WIN32
+    return MoveFileExA(from.c_str(), to.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != 0;
+#else
+    return rename(from.c_str(), to.c_str()) == 0;
+#endif
+}
+
+// Read-only memory map of a whole file. Throws DJException if it cannot be
+// opened or mapped. An empty file maps to (nullptr, 0).
+class MappedFile
+{
+private:
+    const char* bytes = nullptr;
+    size_t length = 0;
+#ifdef _WIN32
+    HANDLE file = INVALID_HANDLE_VALUE;
+    HANDLE mapping = nullptr;
+#endif
+
+    void release()
+    {
+#ifdef _WIN32
+        if (bytes) UnmapViewOfFile(bytes);
+        if (mapping) CloseHandle(mapping);
+        if (file != INVALID_HANDLE_VALUE) CloseHandle(file);
+        file = INVALID_HANDLE_VALUE;
+        mapping = nullptr;
+#else
+        if (bytes) munmap(const_cast<char*>(bytes), length);
+#endif
+        bytes = nullptr;
+        length = 0;
+    }
+
+public:
+    explicit MappedFile(const string& path)
+    {
+#ifdef _WIN32
+        file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+            FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (file == INVALID_HANDLE_VALUE)
+            throw DJException("Cannot open " + path);
+        LARGE_INTEGER size;
+        if (!GetFileSizeEx(file, &size))
+        {
+            release();
+            throw DJException("Cannot read the size of " + path);
+        }
+        length = static_cast<size_t>(size.QuadPart);
+        if (length > 0)
+        {
+            mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+            void* view = mapping ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+            if (!view)
+            {
+                release();
+                throw DJException("Cannot map " + path);
+            }
+            bytes = static_cast<const char*>(view);
+        }
+#else
+        int fd = open(path.c_str(), O_RDONLY);
+        if (fd < 0)
+            throw DJException("Cannot open " + path);
+        struct stat info;
+        if (fstat(fd, &info) != 0)
+        {
+            close(fd);
+            throw DJException("Cannot read the size of " + path);
+        }
+        length = static_cast<size_t>(info.st_size);
+        if (length > 0)
+        {
+            void* view = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (view == MAP_FAILED)
+            {
+                close(fd);
+                length = 0;
+                throw DJException("Cannot map " + path);
+            }
+            bytes = static_cast<const char*>(view);
+        }
+        close(fd); // the mapping keeps its own reference
+#endif
+    }
+
+    MappedFile(MappedFile&& other) noexcept
+        : bytes(other.bytes), length(other.length)
+    {
+#ifdef _WIN32
+        file = other.file;
+        mapping = other.mapping;
+        other.file = INVALID_HANDLE_VALUE;
+        other.mapping = nullptr;
+#endif
+        other.bytes = nullptr;
+        other.length = 0;
+    }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    MappedFile& operator=(MappedFile&&) = delete;
+
+    ~MappedFile() { release(); }
+
+    const char* data() const { return bytes; }
+    size_t size() const { return length; }
+};
+
+// Collects tracks column by column, then writes one snapshot file. Equal
+// strings (genres, artists, platforms) are stored once.
+class SnapshotWriter
+{
+private:
+    vector<int32_t> bpm;
+    vector<uint8_t> energy;
+    vector<uint8_t> type;
+    vector<uint8_t> harmonic;
+    vector<uint32_t> strings[SNAP_STRING_COLUMNS];
+    vector<uint64_t> stringOffsets;
+    string heap;
+    unordered_map<string, uint32_t> stringIds;
+
+    uint32_t intern(const string& text)
+    {
+        unordered_map<string, uint32_t>::const_iterator it = stringIds.find(text);
+        if (it != stringIds.end())
+            return it->second;
+        uint32_t id = static_cast<uint32_t>(stringOffsets.size() - 1);
+        stringIds.emplace(text, id);
+        heap += text;
+        stringOffsets.push_back(heap.size());
+        return id;
+    }
+
+    static uint64_t align8(uint64_t offset) { return (offset + 7) & ~static_cast<uint64_t>(7); }
+
+public:
+    SnapshotWriter()
+    {
+        stringOffsets.push_back(0);
+        intern(""); // string 0 is always the empty string
+    }
+
+    int getSize() const { return static_cast<int>(bpm.size()); }
+
+    void reserve(int n)
+    {
+        bpm.reserve(n);
+        energy.reserve(n);
+        type.reserve(n);
+        harmonic.reserve(n);
+        for (int c = 0; c < SNAP_STRING_COLUMNS; c++)
+            strings[c].reserve(n);
+    }
+
+    // text[c] is the value for SnapshotString column c.
+    void addTrack(TrackTypeTag tag, int bpmValue, EnergyLevel e, int harmonicKey, const string* const text[SNAP_STRING_COLUMNS])
+    {
+        bpm.push_back(static_cast<int32_t>(bpmValue));
+        energy.push_back(static_cast<uint8_t>(e));
+        type.push_back(static_cast<uint8_t>(tag));
+        harmonic.push_back((harmonicKey >= 0 && harmonicKey < HARMONIC_KEYS) ? static_cast<uint8_t>(harmonicKey) : NO_KEY_PACKED);
+        for (int c = 0; c < SNAP_STRING_COLUMNS; c++)
+            strings[c].push_back(intern(*text[c]));
+    }
+
+    // Writes path + ".tmp", syncs it and renames it over path. Throws
+    // DJException on any I/O error (the old file, if any, is left as it was).
+    void write(const string& path, uint64_t lsn = 0) const
+    {
+        uint64_t n = bpm.size();
+        uint64_t stringCount = stringOffsets.size() - 1;
+
+        SnapshotHeader h;
+        memset(&h, 0, sizeof(h));
+        memcpy(h.magic, SNAPSHOT_MAGIC, sizeof(h.magic));
+        h.version = SNAPSHOT_VERSION;
+        h.byteOrder = SNAPSHOT_BYTE_ORDER;
+        h.headerSize = sizeof(SnapshotHeader);
+        h.lsn = lsn;
+        h.trackCount = n;
+        h.stringCount = stringCount;
+
+        uint64_t at = sizeof(SnapshotHeader);
+        h.bpmOffset = at;                          at = align8(at + n * sizeof(int32_t));
+        h.energyOffset = at;                       at = align8(at + n);
+        h.typeOffset = at;                         at = align8(at + n);
+        h.harmonicOffset = at;                     at = align8(at + n);
+        for (int c = 0; c < SNAP_STRING_COLUMNS; c++)
+        {
+            h.stringColumnOffset[c] = at;          at = align8(at + n * sizeof(uint32_t));
+        }
+        h.stringOffsetsOffset = at;                at = align8(at + (stringCount + 1) * sizeof(uint64_t));
+        h.heapOffset = at;
+        h.heapSize = heap.size();
+        h.fileSize = at + h.heapSize;
+
+        string tmp = path + ".tmp";
+        FILE* f = fopen(tmp.c_str(), "wb");
+        if (!f)
+            throw DJException("Cannot write " + tmp);
+
+        uint64_t written = 0;
+        bool ok = true;
+        auto put = [&](const void* src, uint64_t bytes, uint64_t offset) {
+            static const char ZEROS[8] = { 0 };
+            if (ok && offset > written)
+                ok = fwrite(ZEROS, 1, static_cast<size_t>(offset - written), f) == offset - written;
+            if (ok && bytes > 0)
+                ok = fwrite(src, 1, static_cast<size_t>(bytes), f) == bytes;
+            written = offset + bytes;
+        };
+        put(&h, sizeof(h), 0);
+        put(bpm.data(), n * sizeof(int32_t), h.bpmOffset);
+        put(energy.data(), n, h.energyOffset);
+        put(type.data(), n, h.typeOffset);
+        put(harmonic.data(), n, h.harmonicOffset);
+        for (int c = 0; c < SNAP_STRING_COLUMNS; c++)
+            put(strings[c].data(), n * sizeof(uint32_t), h.stringColumnOffset[c]);
+        put(stringOffsets.data(), (stringCount + 1) * sizeof(uint64_t), h.stringOffsetsOffset);
+        put(heap.data(), h.heapSize, h.heapOffset);
+
+        ok = ok && syncFile(f);
+        ok = (fclose(f) == 0) && ok;
+        if (!ok || !replaceFile(tmp, path))
+        {
+            remove(tmp.c_str());
+            throw DJException("Cannot write " + path);
+        }
+    }
+};
+
+// Read-only view of a snapshot file, used in place from the memory map: the
+// columns are plain arrays and strings are decoded only when asked for.
+// Opening costs O(1) whatever the library size. Throws DJException when the
+// file is missing, from another version/byte order, or truncated.
+class SnapshotView
+{
+private:
+    MappedFile file;
+    SnapshotHeader header;
+    const int32_t* bpm = nullptr;
+    const uint8_t* energy = nullptr;
+    const uint8_t* type = nullptr;
+    const uint8_t* harmonic = nullptr;
+    const uint32_t* strings[SNAP_STRING_COLUMNS] = {};
+    const uint64_t* stringOffsets = nullptr;
+    const char* heap = nullptr;
+
+    template <class T>
+    const T* section(uint64_t offset, uint64_t count) const
+    {
+        if (offset % 8 != 0 || offset > file.size()
+            || count > (file.size() - offset) / sizeof(T))
+            throw DJException("Corrupt snapshot: section out of bounds");
+        return reinterpret_cast<const T*>(file.data() + offset);
+    }
+
+    void checkRow(int row) const
+    {
+        if (row < 0 || row >= getSize())
+            throw out_of_range("SnapshotView: row out of range");
+    }
+
+public:
+    explicit SnapshotView(const string& path)
+        : file(path)
+    {
+        if (file.size() < sizeof(SnapshotHeader))
+            throw DJException("Corrupt snapshot: " + path + " is too small");
+        memcpy(&header, file.data(), sizeof(header));
+        if (memcmp(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic)) != 0)
+            throw DJException("Not a library snapshot: " + path);
+        if (header.version != SNAPSHOT_VERSION)
+            throw DJException("Unsupported snapshot version " + to_string(header.version));
+        if (header.byteOrder != SNAPSHOT_BYTE_ORDER)
+            throw DJException("Snapshot was written with another byte order");
+        if (header.headerSize != sizeof(SnapshotHeader) || header.fileSize != file.size())
+            throw DJException("Corrupt snapshot: size mismatch (truncated?)");
+        if (header.trackCount > static_cast<uint64_t>(numeric_limits<int>::max())
+            || header.stringCount >= static_cast<uint64_t>(numeric_limits<uint32_t>::max()))
+            throw DJException("Corrupt snapshot: bad counts");
+
+        uint64_t n = header.trackCount;
+        bpm = section<int32_t>(header.bpmOffset, n);
+        energy = section<uint8_t>(header.energyOffset, n);
+        type = section<uint8_t>(header.typeOffset, n);
+        harmonic = section<uint8_t>(header.harmonicOffset, n);
+        for (int c = 0; c < SNAP_STRING_COLUMNS; c++)
+            strings[c] = section<uint32_t>(header.stringColumnOffset[c], n);
+        stringOffsets = section<uint64_t>(header.stringOffsetsOffset, header.stringCount + 1);
+        heap = section<char>(header.heapOffset, header.heapSize);
+    }
+
+    int getSize() const { return static_cast<int>(header.trackCount); }
+    uint64_t getLsn() const { return header.lsn; }
+    uint32_t getVersion() const { return header.version; }
+    int getStringCount() const { return static_cast<int>(header.stringCount); }
+    size_t getFileSize() const { return file.size(); }
+
+    // Columns, straight from the mapping (getSize() entries each).
+    const int32_t* bpmColumn() const { return bpm; }
+    const uint8_t* energyColumn() const { return energy; }
+    const uint8_t* typeColumn() const { return type; }
+    const uint8_t* harmonicKeyColumn() const { return harmonic; }
+
+    // Row access; throws out_of_range for a bad row and DJException for a
+    // value no writer produces.
+    int bpmAt(int row) const { checkRow(row); return bpm[row]; }
+
+    EnergyLevel energyAt(int row) const
+    {
+        checkRow(row);
+        if (energy[row] < LOW || energy[row] > HIGH)
+            throw DJException("Corrupt snapshot: bad energy");
+        return static_cast<EnergyLevel>(energy[row]);
+    }
+
+    TrackTypeTag typeAt(int row) const
+    {
+        checkRow(row);
+        if (type[row] > TAG_STREAM)
+            throw DJException("Corrupt snapshot: bad track type");
+        return static_cast<TrackTypeTag>(type[row]);
+    }
+
+    int harmonicKeyAt(int row) const
+    {
+        checkRow(row);
+        return (harmonic[row] < HARMONIC_KEYS) ? harmonic[row] : NO_KEY;
+    }
+
+    uint32_t stringIdAt(SnapshotString column, int row) const
+    {
+        checkRow(row);
+        return strings[column][row];
+    }
+
+    // Lazy decode: a view into the mapped heap, valid while this view lives.
+    string_view stringById(uint32_t id) const
+    {
+        if (id >= header.stringCount)
+            throw DJException("Corrupt snapshot: bad string id");
+        uint64_t begin = stringOffsets[id];
+        uint64_t end = stringOffsets[id + 1];
+        if (begin > end || end > header.heapSize)
+            throw DJException("Corrupt snapshot: bad string offsets");
+        return string_view(heap + begin, static_cast<size_t>(end - begin));
+    }
+
+    string_view stringAt(SnapshotString column, int row) const { return stringById(stringIdAt(column, row)); }
+    string_view titleAt(int row) const { return stringAt(SNAP_TITLE, row); }
+    string_view artistAt(int row) const { return stringAt(SNAP_ARTIST, row); }
+    string_view genreAt(int row) const { return stringAt(SNAP_GENRE, row); }
+    string_view keyAt(int row) const { return stringAt(SNAP_KEY, row); }
+    string_view notesAt(int row) const { return stringAt(SNAP_NOTES, row); }
+    string_view locationAt(int row) const { return stringAt(SNAP_LOCATION, row); }
+};
+
+// -------------------- Library Engine: Write-Ahead Log --------------------
+// Rewriting the whole snapshot after every edit does not scale, so edits are
+// appended to a log instead and the snapshot is only rewritten by compaction.
+//
+//   header   WAL_MAGIC, version, byte-order mark (16 bytes)
+//   record   uint32 payloadSize | uint32 crc32 | uint64 lsn | uint8 op | payload
+//
+// The CRC covers lsn, op and payload, so a record torn by a crash (or any
+// flipped byte) ends the log there. LSNs grow by one per record and carry on
+// from the snapshot's LSN, so recovery replays exactly the records with
+// lsn > snapshot lsn. Records name tracks by dense row index, not TrackId:
+// ids are not kept across sessions, while row order is (the snapshot stores
+// rows in order, and swap-remove and the stable BPM sort replay the same way).
+const char WAL_MAGIC[8] = { 'D', 'J', 'A', 'R', 'C', 'H', 'W', 'L' };
+const uint32_t WAL_VERSION = 1;
+const size_t WAL_HEADER_SIZE = 16;
+const size_t WAL_RECORD_HEADER = 17;
+const uint32_t WAL_MAX_PAYLOAD = 64u << 20;
+const char* const LIBRARY_LOG_FILE = "DJ_Library.djlog";
+
+enum LogOp
+{
+    LOG_ADD = 1,    // type, bpm, energy, every SnapshotString column
+    LOG_REMOVE,     // index
+    LOG_SET_BPM,    // index, bpm
+    LOG_SET_ENERGY, // index, energy
+    LOG_SET_KEY,    // index, text[SNAP_KEY]
+    LOG_SET_GENRE,  // index, text[SNAP_GENRE]
+    LOG_SORT_BPM    // no payload
+};
+
+struct LogRecord
+{
+    uint64_t lsn = 0;
+    LogOp op = LOG_ADD;
+    int index = 0;
+    int bpm = 0;
+    EnergyLevel energy = MEDIUM;
+    TrackTypeTag type = TAG_LOCAL;
+    string text[SNAP_STRING_COLUMNS];
+};
+
+// CRC-32 (IEEE 802.3, the zlib/PNG one). crc32Update(0, "123456789", 9) == 0xCBF43926.
+inline uint32_t crc32Update(uint32_t crc, const void* data, size_t n)
+{
+    static const struct Table
+    {
+        uint32_t v[256];
+        Table()
+        {
+            for (uint32_t i = 0; i < 256; i++)
+            {
+                uint32_t c = i;
+                for (int k = 0; k < 8; k++)
+                    c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+                v[i] = c;
             }
+        }
+    } table;
+
+    const unsigned char* p = static_cast<const unsigned char*>(data);
+    crc = ~crc;
+    for (size_t i = 0; i < n; i++)
+        crc = table.v[(crc ^ p[i]) & 0xFF] ^ (crc >> 8);
+    return ~crc;
+}
+
+// Reads the records of a log file in order (from a memory map). Stops at the
+// end or at the first record that is torn or fails its CRC; isTorn() tells
+// which. Throws DJException if the file is not a library log.
+class LogReader
+{
+private:
+    MappedFile file;
+    size_t at = WAL_HEADER_SIZE;
+    size_t recordStart = WAL_HEADER_SIZE;
+    bool torn = false;
+
+    template <class T>
+    static bool take(const char*& p, const char* end, T& out)
+    {
+        if (static_cast<size_t>(end - p) < sizeof(T))
+            return false;
+        memcpy(&out, p, sizeof(T));
+        p += sizeof(T);
+        return true;
+    }
+
+    static bool takeText(const char*& p, const char* end, string& out)
+    {
+        uint32_t len = 0;
+        if (!take(p, end, len) || static_cast<size_t>(end - p) < len)
+            return false;
+        out.assign(p, len);
+        p += len;
+        return true;
+    }
+
+    static bool decode(uint8_t op, const char* p, const char* end, LogRecord& r)
+    {
+        uint32_t index = 0;
+        int32_t bpm = 0;
+        uint8_t byte = 0;
+        r.op = static_cast<LogOp>(op);
+        switch (op)
+        {
+        case LOG_ADD:
+            if (!take(p, end, byte) || (byte != TAG_LOCAL && byte != TAG_STREAM))
+                return false;
+            r.type = static_cast<TrackTypeTag>(byte);
+            if (!take(p, end, bpm) || !take(p, end, byte) || byte < LOW || byte > HIGH)
+                return false;
+            r.bpm = bpm;
+            r.energy = static_cast<EnergyLevel>(byte);
+            for (int c = 0; c < SNAP_STRING_COLUMNS; c++)
+                if (!takeText(p, end, r.text[c]))
+                    return false;
+            break;
+        case LOG_SORT_BPM:
+            break;
+        default:
+            if (op < LOG_REMOVE || op > LOG_SET_GENRE || !take(p, end, index) || index > INT32_MAX)
+                return false;
+            r.index = static_cast<int>(index);
+            if (op == LOG_SET_BPM && !take(p, end, bpm))
+                return false;
+            r.bpm = bpm;
+            if (op == LOG_SET_ENERGY && (!take(p, end, byte) || byte < LOW || byte > HIGH))
+                return false;
+            if (op == LOG_SET_ENERGY)
+                r.energy = static_cast<EnergyLevel>(byte);
+            if (op == LOG_SET_KEY && !takeText(p, end, r.text[SNAP_KEY]))
+                return false;
+            if (op == LOG_SET_GENRE && !takeText(p, end, r.text[SNAP_GENRE]))
+                return false;
+        }
+        return p == end;
+    }
+
+public:
+    explicit LogReader(const string& path) : file(path)
+    {
+        if (file.size() == 0)
+        {
+            at = recordStart = 0; // created but never written: no records
+            return;
+        }
+        uint32_t version = 0;
+        uint32_t byteOrder = 0;
+        if (file.size() >= WAL_HEADER_SIZE)
+        {
+            memcpy(&version, file.data() + 8, 4);
+            memcpy(&byteOrder, file.data() + 12, 4);
+        }
+        if (file.size() < WAL_HEADER_SIZE || memcmp(file.data(), WAL_MAGIC, 8) != 0)
+            throw DJException(path + " is not a library log");
+        if (version != WAL_VERSION || byteOrder != SNAPSHOT_BYTE_ORDER)
+            throw DJException(path + " was written by another version or platform");
+    }
+
+    // Next intact record; false at the end of the log.
+    bool next(LogRecord& r)
+    {
+        if (torn || at >= file.size())
+            return false;
+        recordStart = at;
+        const char* p = file.data() + at;
+        size_t left = file.size() - at;
+        uint32_t size = 0;
+        uint32_t crc = 0;
+        if (left >= WAL_RECORD_HEADER)
+        {
+            memcpy(&size, p, 4);
+            memcpy(&crc, p + 4, 4);
+        }
+        if (left < WAL_RECORD_HEADER || size > WAL_MAX_PAYLOAD || left - WAL_RECORD_HEADER < size
+            || crc32Update(0, p + 8, 9 + size) != crc)
+        {
+            torn = true;
+            return false;
+        }
+
+        memcpy(&r.lsn, p + 8, 8);
+        if (!decode(static_cast<uint8_t>(p[16]), p + WAL_RECORD_HEADER, p + WAL_RECORD_HEADER + size, r))
+            throw DJException("Library log record " + to_string(r.lsn) + " is malformed");
+        at += WAL_RECORD_HEADER + size;
+        return true;
+    }
+
+    bool isTorn() const { return torn; }
+    bool isEmpty() const { return file.size() == 0; }
+
+    // Bytes up to the end of the last record read (the whole file when intact).
+    uint64_t validBytes() const { return at; }
+
+    // Raw bytes of the record last returned by next().
+    string_view lastRecordBytes() const { return string_view(file.data() + recordStart, at - recordStart); }
+};
+
+struct LogOptions
+{
+    // Group commit: records are buffered and written with ONE fsync when
+    // this many bytes are pending, or when the oldest pending record is
+    // groupCommitMs old (checked on append), or on sync(). 0 = every record.
+    size_t groupCommitBytes = 64 * 1024;
+    int groupCommitMs = 20;
+    uint64_t compactBytes = 32ull << 20; // needsCompaction() threshold
+};
+
+// Append side of the log. Opening scans the existing file, cuts off a torn
+// tail and carries on after the last LSN (or after minLsn, the snapshot's,
+// whichever is higher). Throws DJException on I/O errors; after a failed
+// write the log refuses further appends.
+class OperationLog
+{
+private:
+    string path;
+    LogOptions options;
+    FILE* file = nullptr;
+    string pending;       // encoded records not written yet
+    uint64_t lastLsn = 0;
+    uint64_t durableLsn = 0;
+    uint64_t fileBytes = 0;
+    int syncCount = 0;
+    bool failed = false;
+    chrono::steady_clock::time_point oldestPending;
+
+    template <class T>
+    void put(T value)
+    {
+        pending.append(reinterpret_cast<const char*>(&value), sizeof(T));
+    }
+
+    void putText(const string& text)
+    {
+        put(static_cast<uint32_t>(text.size()));
+        pending += text;
+    }
+
+    void openForAppend()
+    {
+        file = fopen(path.c_str(), "ab");
+        if (!file)
+            throw DJException("Cannot open " + path);
+    }
+
+    OperationLog(const OperationLog&) = delete;
+    OperationLog& operator=(const OperationLog&) = delete;
+
+public:
+    explicit OperationLog(const string& logPath, uint64_t minLsn = 0, const LogOptions& opts = LogOptions())
+        : path(logPath), options(opts)
+    {
+        bool repair = true;
+        if (ifstream(path))
+        {
+            LogReader reader(path);
+            LogRecord r;
+            while (reader.next(r))
+                lastLsn = r.lsn;
+            repair = reader.isTorn() || reader.isEmpty();
+            fileBytes = reader.validBytes();
+        }
+        if (repair)
+            rewrite(0); // new file, or drop the torn tail
+        else
+            openForAppend();
+        lastLsn = durableLsn = max(lastLsn, minLsn);
+    }
+
+    ~OperationLog()
+    {
+        try
+        {
+            sync();
+        }
+        catch (...)
+        {
+            // nothing to report to from a destructor; the tail is lost like in a crash
+        }
+        if (file)
+            fclose(file);
+    }
+
+    const string& getPath() const { return path; }
+    uint64_t getLastLsn() const { return lastLsn; }
+    uint64_t getDurableLsn() const { return durableLsn; }
+    int getSyncCount() const { return syncCount; }
+    uint64_t getBytes() const { return fileBytes + pending.size(); }
+    bool needsCompaction() const { return getBytes() > options.compactBytes; }
+
+    // Encodes the record (r.lsn is assigned) and commits the group if it is
+    // due. Returns the record's LSN.
+    uint64_t append(LogRecord& r)
+    {
+        if (failed)
+            throw DJException("Library log is unusable after a write error");
+        if (pending.empty())
+            oldestPending = chrono::steady_clock::now();
+
+        size_t start = pending.size();
+        pending.append(WAL_RECORD_HEADER, '\0');
+        switch (r.op)
+        {
+        case LOG_ADD:
+            put(static_cast<uint8_t>(r.type));
+            put(static_cast<int32_t>(r.bpm));
+            put(static_cast<uint8_t>(r.energy));
+            for (int c = 0; c < SNAP_STRING_COLUMNS; c++)
+                putText(r.text[c]);
+            break;
+        case LOG_SORT_BPM:
+            break;
+        default:
+            put(static_cast<uint32_t>(r.index));
+            if (r.op == LOG_SET_BPM) put(static_cast<int32_t>(r.bpm));
+            if (r.op == LOG_SET_ENERGY) put(static_cast<uint8_t>(r.energy));
+            if (r.op == LOG_SET_KEY) putText(r.text[SNAP_KEY]);
+            if (r.op == LOG_SET_GENRE) putText(r.text[SNAP_GENRE]);
+        }
+
+        r.lsn = lastLsn + 1;
+        char* h = &pending[start];
+        uint32_t size = static_cast<uint32_t>(pending.size() - start - WAL_RECORD_HEADER);
+        memcpy(h, &size, 4);
+        memcpy(h + 8, &r.lsn, 8);
+        h[16] = static_cast<char>(r.op);
+        uint32_t crc = crc32Update(0, h + 8, 9 + size);
+        memcpy(h + 4, &crc, 4);
+        lastLsn = r.lsn;
+
+        if (pending.size() >= options.groupCommitBytes
+            || chrono::steady_clock::now() - oldestPending >= chrono::milliseconds(options.groupCommitMs))
+            sync();
+        return r.lsn;
+    }
+
+    // Writes every pending record and fsyncs once (the group commit).
+    void sync()
+    {
+        if (pending.empty())
+            return;
+        if (failed || !file)
+            throw DJException("Library log is unusable after a write error");
+        bool ok = fwrite(pending.data(), 1, pending.size(), file) == pending.size();
+        ok = ok && syncFile(file);
+        if (!ok)
+        {
+            failed = true;
+            throw DJException("Cannot write " + path);
+        }
+        fileBytes += pending.size();
+        pending.clear();
+        durableLsn = lastLsn;
+        syncCount++;
+    }
+
+    // Rewrites the file with only the records after keepAfter (path.tmp,
+    // fsync, rename), e.g. once a snapshot covers everything up to it.
+    void rewrite(uint64_t keepAfter)
+    {
+        sync();
+        if (file)
+        {
+            fclose(file);
+            file = nullptr;
+        }
+
+        string tmp = path + ".tmp";
+        FILE* out = fopen(tmp.c_str(), "wb");
+        if (!out)
+            throw DJException("Cannot write " + tmp);
+        char header[WAL_HEADER_SIZE];
+        memcpy(header, WAL_MAGIC, 8);
+        memcpy(header + 8, &WAL_VERSION, 4);
+        memcpy(header + 12, &SNAPSHOT_BYTE_ORDER, 4);
+        bool ok = fwrite(header, 1, sizeof(header), out) == sizeof(header);
+        uint64_t bytes = sizeof(header);
+        if (ifstream(path))
+        {
+            LogReader reader(path); // unmapped again before the rename
+            LogRecord r;
+            while (ok && reader.next(r))
+            {
+                if (r.lsn <= keepAfter)
+                    continue;
+                string_view raw = reader.lastRecordBytes();
+                ok = fwrite(raw.data(), 1, raw.size(), out) == raw.size();
+                bytes += raw.size();
+            }
+        }
+        ok = ok && syncFile(out);
+        ok = (fclose(out) == 0) && ok;
+        if (!ok || !replaceFile(tmp, path))
+        {
+            remove(tmp.c_str());
+            failed = true;
+            throw DJException("Cannot write " + path);
+        }
+        openForAppend();
+        fileBytes = bytes;
+    }
+};
+
+// -------------------- Week 5/6/7/9: Manager Class --------------------
+// TrackManager OWNS TrackBase* objects. Library engine: storage is a columnar
+// TrackStore (which holds the DynamicArray<TrackBase*> plus dense columns).
+class TrackManager
+{
+private:
+    // -------------------- Week 09: std::vector replaces raw int array --------------------
+    // Library engine: the old bpmList mirror is now the store's BPM column
+    // (still a std::vector, kept aligned with the track objects by TrackStore).
+    TrackStore store;
+
+    // -------------------- Library Engine: sorted view (argsort) --------------------
+    // sortedView[k] = library index of the k-th slowest track. The TrackBase*
+    // objects never move; only this int permutation is built. It is rebuilt
+    // lazily (on the next lookup) when version != sortedViewVersion, i.e. only
+    // after the library actually changed.
+    unsigned long long version = 0;
+    mutable vector<int> sortedView;
+    mutable unsigned long long sortedViewVersion = ~0ULL;
+
+    // BPM -> TrackId slot buckets, maintained on every add/remove/edit.
+    BpmBucketIndex bpmIndex;
+
+    // Running totals (BPM sum/min/max, genre/key/energy counts), maintained
+    // on every add/remove/update*.
+    LibraryAggregates aggregates;
+
+    // Optional top-K "what can follow" lists (enableNeighborIndex()).
+    unique_ptr<NeighborIndex> neighbors;
+
+    // Optional write-ahead log (attachLog()). Every add/remove/edit is logged
+    // BEFORE it is applied, so a failed append leaves the library unchanged.
+    OperationLog* journal = nullptr;
+    LogRecord logScratch; // reused: logging an edit does not allocate
+
+    // Library engine: slab arenas for tracks created through emplaceLocal()/
+    // emplaceStream(). Tracks handed over with operator+= stay plain new/delete.
+    SlabPool<LocalTrack> localPool;
+    SlabPool<StreamTrack> streamPool;
+
+    void markChanged() { version++; }
+
+    void logOp(LogOp op, int index)
+    {
+        logScratch.op = op;
+        logScratch.index = index;
+        journal->append(logScratch);
+    }
+
+    void logAdd(TrackBase* p)
+    {
+        LogRecord& r = logScratch;
+        r.op = LOG_ADD;
+        r.bpm = p->getBpm();
+        r.energy = p->getEnergy();
+        r.text[SNAP_TITLE] = p->getTitle();
+        r.text[SNAP_ARTIST] = p->getArtistSymbol().str();
+        r.text[SNAP_GENRE] = p->getGenreSymbol().str();
+        r.text[SNAP_KEY] = p->getKeySymbol().str();
+        if (StreamTrack* s = dynamic_cast<StreamTrack*>(p))
+        {
+            r.type = TAG_STREAM;
+            r.text[SNAP_NOTES] = s->getNotes().getNotes();
+            r.text[SNAP_LOCATION] = s->getPlatform();
+        }
+        else
+        {
+            LocalTrack* l = static_cast<LocalTrack*>(p);
+            r.type = TAG_LOCAL;
+            r.text[SNAP_NOTES] = l->getNotes().getNotes();
+            r.text[SNAP_LOCATION] = l->getFilePath();
+        }
+        journal->append(r);
+    }
+
+    // Ends the life of the object in 'index' the way it was created.
+    void disposeRow(int index)
+    {
+        TrackBase* p = store.handle(index);
+        if (store.originAt(index) == ORIGIN_HEAP)
+            delete p;
+        else if (store.typeAt(index) == TAG_LOCAL)
+            localPool.destroy(static_cast<LocalTrack*>(p));
+        else
+            streamPool.destroy(static_cast<StreamTrack*>(p));
+    }
+
+    static void requireColumnBpm(int bpm)
+    {
+        if (!fitsColumn(bpm))
+            throw DJException("TrackManager: BPM " + to_string(bpm) + " is outside 0..65535");
+    }
+
+    TrackId addRow(TrackBase* p, TrackOrigin from)
+    {
+        requireColumnBpm(p->getBpm());
+        if (journal)
+            logAdd(p);
+        TrackId id = store.pushBack(p, from);
+        bpmIndex.insert(static_cast<int>(id.slot), store.bpmColumn().back());
+        if (neighbors)
+            neighbors->insert(store, bpmIndex, store.getSize() - 1);
+        aggregates.addRow(store, store.getSize() - 1);
+        markChanged();
+        return id;
+    }
+
+    template <class T>
+    TrackId addPooled(SlabPool<T>& pool, T* p)
+    {
+        try
+        {
+            return addRow(p, ORIGIN_POOL);
+        }
+        catch (...)
+        {
+            pool.destroy(p);
+            throw;
+        }
+    }
+
+    void ensureSortedView() const
+    {
+        if (sortedViewVersion == version)
+            return;
+        sortedView = countingSortOrder(store.bpmColumn());
+        sortedViewVersion = version;
+    }
+
+    // First sorted position whose BPM is >= target (classic lower bound).
+    int lowerBoundInView(int target) const
+    {
+        const vector<uint16_t>& bpms = store.bpmColumn();
+        int low = 0;
+        int high = static_cast<int>(sortedView.size());
+        while (low < high)
+        {
+            int mid = low + (high - low) / 2;
+            if (bpms[sortedView[mid]] < target)
+                low = mid + 1;
+            else
+                high = mid;
+        }
+        return low;
+    }
+
+    // Divide and conquer over the energy column: split the range in half until
+    // a chunk is small enough for one SIMD count. Depth is log2(n / LEAF), so
+    // a 1M-track library recurses ~8 levels instead of 1M.
+    int countHighEnergyRecursiveHelper(int lo, int hi) const
+    {
+        const int LEAF = 4096;
+
+        // Base case: small chunk -> vectorized count
+        if (hi - lo <= LEAF)
+        {
+            if (hi <= lo)
+                return 0;
+            return ColumnScanner::best().countInRange(store.energyColumn().data() + lo, hi - lo, HIGH, HIGH);
+        }
+
+        // Recursive case: count each half
+        int mid = lo + (hi - lo) / 2;
+        return countHighEnergyRecursiveHelper(lo, mid) + countHighEnergyRecursiveHelper(mid, hi);
+    }
+
+    TrackManager(const TrackManager&) = delete;
+    TrackManager& operator=(const TrackManager&) = delete;
+
+public:
+    TrackManager(int cap = 2, int tracksPerSlab = 1024)
+        : store(cap), localPool(tracksPerSlab), streamPool(tracksPerSlab)
+    {
+    }
+
+    int getSize() const { return store.getSize(); }
+    int getCapacity() const { return store.getCapacity(); }
+
+    // Read-only access to the dense columns (for scans outside the manager).
+    const TrackStore& getStore() const { return store; }
+
+    int countHighEnergyRecursive() const
+    {
+        return countHighEnergyRecursiveHelper(0, store.getSize());
+    }
+
+    // Pre-sizes storage before a bulk load (one allocation instead of repeated doubling).
+    void reserve(int cap)
+    {
+        store.reserve(cap);
+    }
+
+    // Adds a pointer (manager takes ownership)
+    // Library engine: returns the track's stable handle. A track whose BPM
+    // does not fit the column (outside 0..65535) is deleted and DJException thrown.
+    TrackId add(TrackBase* p)
+    {
+        try
+        {
+            return addRow(p, ORIGIN_HEAP);
+        }
+        catch (...)
+        {
+            delete p;
+            throw;
+        }
+    }
+
+    // Library engine: constructs the track inside the manager's slab pool
+    // (no per-track heap allocation). Same arguments as the constructors.
+    template <class... Args>
+    TrackId emplaceLocal(Args&&... args)
+    {
+        return addPooled(localPool, localPool.create(forward<Args>(args)...));
+    }
+
+    template <class... Args>
+    TrackId emplaceStream(Args&&... args)
+    {
+        return addPooled(streamPool, streamPool.create(forward<Args>(args)...));
+    }
+
+    // Library engine: stores a full Weeks 1-4 Track record (artist, genre, key,
+    // notes) as a pooled LocalTrack (location = file path, may be empty) or
+    // StreamTrack (location = platform).
+    TrackId addTrackRecord(const Track& t, TrackTypeTag type = TAG_LOCAL, const string& location = "")
+    {
+        if (type == TAG_STREAM)
+        {
+            StreamTrack* p = streamPool.create(t.title, t.bpm, t.energy, location, MixNotes(t.notes));
+            p->setArtistSymbol(t.artist);
+            p->setGenreSymbol(t.genre);
+            p->setKeySymbol(t.key);
+            return addPooled(streamPool, p);
+        }
+        LocalTrack* p = localPool.create(t.title, t.bpm, t.energy, location, MixNotes(t.notes));
+        p->setArtistSymbol(t.artist);
+        p->setGenreSymbol(t.genre);
+        p->setKeySymbol(t.key);
+        return addPooled(localPool, p);
+    }
+
+    // Rebuilds the Weeks 1-4 view of the track at 'index' (throws if invalid).
+    Track getTrackRecord(int index) const
+    {
+        TrackBase* p = (*this)[index];
+        Track t;
+        t.title = p->getTitle();
+        t.artist = p->getArtistSymbol();
+        t.genre = p->getGenreSymbol();
+        t.key = p->getKeySymbol();
+        t.bpm = p->getBpm();
+        t.energy = p->getEnergy();
+        t.notes = notesAt(index);
+        return t;
+    }
+
+    // Mix notes of either track type (type tag switch, no virtual call).
+    string notesAt(int index) const
+    {
+        TrackBase* p = (*this)[index];
+        if (store.typeAt(index) == TAG_STREAM)
+            return static_cast<StreamTrack*>(p)->getNotes().getNotes();
+        return static_cast<LocalTrack*>(p)->getNotes().getNotes();
+    }
+
+    // File path of a LocalTrack or platform of a StreamTrack.
+    string locationAt(int index) const
+    {
+        TrackBase* p = (*this)[index];
+        if (store.typeAt(index) == TAG_STREAM)
+            return static_cast<StreamTrack*>(p)->getPlatform();
+        return static_cast<LocalTrack*>(p)->getFilePath();
+    }
+
+    // -------------------- Library Engine: Binary Snapshot --------------------
+    // Writes the whole library (see SnapshotView for the format); lsn is the
+    // last log entry the file covers. Throws DJException on I/O errors.
+    void saveSnapshot(const string& path, uint64_t lsn = 0) const
+    {
+        SnapshotWriter writer;
+        fillSnapshot(writer);
+        writer.write(path, lsn);
+    }
+
+    // Copies every row into the writer (what saveSnapshot() writes).
+    void fillSnapshot(SnapshotWriter& writer) const
+    {
+        writer.reserve(getSize());
+        const vector<uint8_t>& keys = store.harmonicKeyColumn();
+        for (int i = 0; i < getSize(); i++)
+        {
+            TrackBase* p = store.handle(i);
+            string title = p->getTitle();
+            string notes = notesAt(i);
+            string location = locationAt(i);
+            const string* text[SNAP_STRING_COLUMNS] = {
+                &title, &p->getArtistSymbol().str(), &p->getGenreSymbol().str(), &p->getKeySymbol().str(), &notes, &location
+            };
+            writer.addTrack(store.typeAt(i), p->getBpm(), p->getEnergy(),
+                keys[i] == NO_KEY_PACKED ? NO_KEY : keys[i], text);
+        }
+    }
+
+    // Appends every track of a snapshot, in file order. This is where the
+    // strings get decoded; artist/genre/key/platform are interned once per
+    // distinct snapshot string. Every row becomes a pooled object with its
+    // own title/notes/location copies, so this is O(n) work and allocation
+    // (not the O(1) open of SnapshotView). Returns the number of tracks
+    // added. Throws DJException on corrupt rows (tracks before the bad row
+    // stay added).
+    int loadSnapshot(const SnapshotView& view)
+    {
+        int n = view.getSize();
+        reserve(getSize() + n);
+
+        const uint32_t UNSEEN = 0xFFFFFFFFu;
+        vector<uint32_t> symbolOf(static_cast<size_t>(view.getStringCount()), UNSEEN);
+        auto symbol = [&](SnapshotString column, int row) {
+            uint32_t id = view.stringIdAt(column, row);
+            string_view text = view.stringById(id);
+            if (symbolOf[id] == UNSEEN)
+                symbolOf[id] = SymbolTable::global().intern(string(text));
+            return Symbol::fromId(symbolOf[id]);
+        };
+
+        for (int row = 0; row < n; row++)
+        {
+            // read (and check) the whole row before any object is built
+            TrackTypeTag tag = view.typeAt(row);
+            string title(view.titleAt(row));
+            int bpm = view.bpmAt(row);
+            EnergyLevel e = view.energyAt(row);
+            MixNotes notes(string(view.notesAt(row)));
+            Symbol artist = symbol(SNAP_ARTIST, row);
+            Symbol genre = symbol(SNAP_GENRE, row);
+            Symbol key = symbol(SNAP_KEY, row);
+
+            if (tag == TAG_STREAM)
+            {
+                Symbol platform = symbol(SNAP_LOCATION, row);
+                StreamTrack* t = streamPool.create(title, bpm, e, "", notes);
+                t->setPlatformSymbol(platform);
+                t->setArtistSymbol(artist);
+                t->setGenreSymbol(genre);
+                t->setKeySymbol(key);
+                addPooled(streamPool, t);
+            }
+            else
+            {
+                LocalTrack* t = localPool.create(title, bpm, e, string(view.locationAt(row)), notes);
+                t->setArtistSymbol(artist);
+                t->setGenreSymbol(genre);
+                t->setKeySymbol(key);
+                addPooled(localPool, t);
+            }
+        }
+        return n;
+    }
+
+    int loadSnapshot(const string& path)
+    {
+        SnapshotView view(path);
+        return loadSnapshot(view);
+    }
+
+    // -------------------- Library Engine: Write-Ahead Log --------------------
+    // Logs every later add/remove/edit to 'log' (not owned; nullptr stops
+    // logging). Edits made straight through a TrackBase* are not seen.
+    void attachLog(OperationLog* log) { journal = log; }
+    OperationLog* getLog() const { return journal; }
+
+    // Replays one log record through the normal add/remove/update paths.
+    // Throws DJException if it names a row the library does not have.
+    void applyLogRecord(const LogRecord& r)
+    {
+        if (r.op != LOG_ADD && r.op != LOG_SORT_BPM && (r.index < 0 || r.index >= getSize()))
+            throw DJException("Library log record " + to_string(r.lsn) + " names row " + to_string(r.index)
+                + " of " + to_string(getSize()));
+        switch (r.op)
+        {
+        case LOG_ADD:
+        {
+            Track t;
+            t.title = r.text[SNAP_TITLE];
+            t.artist = Symbol(r.text[SNAP_ARTIST]);
+            t.genre = Symbol(r.text[SNAP_GENRE]);
+            t.key = Symbol(r.text[SNAP_KEY]);
+            t.bpm = r.bpm;
+            t.energy = r.energy;
+            t.notes = r.text[SNAP_NOTES];
+            addTrackRecord(t, r.type, r.text[SNAP_LOCATION]);
+            break;
+        }
+        case LOG_REMOVE: removeAt(r.index); break;
+        case LOG_SET_BPM: updateBpm(r.index, r.bpm); break;
+        case LOG_SET_ENERGY: updateEnergy(r.index, r.energy); break;
+        case LOG_SET_KEY: updateKey(r.index, r.text[SNAP_KEY]); break;
+        case LOG_SET_GENRE: updateGenre(r.index, r.text[SNAP_GENRE]); break;
+        case LOG_SORT_BPM: sortByBpm(); break;
+        }
+    }
+
+    // -------------------- Library Engine: O(1) stats (aggregates) --------------------
+    double averageBpm() const { return aggregates.averageBpm(); } // 0.0 when empty
+    int getMinBpm() const { return aggregates.getMinBpm(); }      // 0 when empty
+    int getMaxBpm() const { return aggregates.getMaxBpm(); }
+    const LibraryAggregates& getAggregates() const { return aggregates; }
+    AggregateSnapshot snapshotAggregates() const { return aggregates.snapshot(); }
+
+    int countKey(const string& key) const
+    {
+        long long id = SymbolTable::global().find(key);
+        return (id < 0) ? 0 : aggregates.keyCount(static_cast<uint32_t>(id));
+    }
+
+    // Counts every spelling of the same key ("Am", "8A", "1m", "a minor").
+    int countHarmonicKey(const string& key) const
+    {
+        return aggregates.harmonicKeyCount(parseHarmonicKey(key));
+    }
+
+    const PoolStats& getLocalPoolStats() const { return localPool.getStats(); }
+    const PoolStats& getStreamPoolStats() const { return streamPool.getStats(); }
+
+    // Removes by index (deletes object, closes the gap)
+    // Internal helper. We keep it throwing to match Week 07 behavior.
+    // Library engine: O(1) - the LAST track moves into the freed position
+    // (dense order is not kept). TrackIds of every other track stay valid.
+    void removeAt(int index)
+    {
+        // If invalid, TrackStore::handleAt throws out_of_range.
+        store.handleAt(index);
+        if (journal)
+            logOp(LOG_REMOVE, index);
+        aggregates.removeRow(store, index);
+        if (neighbors)
+            neighbors->erase(store, bpmIndex, index);
+        disposeRow(index);
+        bpmIndex.erase(static_cast<int>(store.idAt(index).slot), store.bpmColumn()[index]);
+        store.swapRemove(index);
+        markChanged();
+    }
+
+    // -------------------- Library Engine: Stable Handles (TrackId) --------------------
+    // Positions (operator[], search hits) change when tracks are removed or the
+    // library is sorted; TrackIds do not. A removed track's id is reported as
+    // stale (contains() == false, find() == nullptr, at()/remove() throw).
+    TrackId idAt(int index) const
+    {
+        if (index < 0 || index >= store.getSize())
+            throw DJException("TrackManager::idAt invalid index");
+        return store.idAt(index);
+    }
+
+    int indexOf(TrackId id) const { return store.rowOf(id); } // -1 if stale
+    bool contains(TrackId id) const { return store.rowOf(id) != -1; }
+
+    TrackBase* find(TrackId id) const
+    {
+        int row = store.rowOf(id);
+        return (row == -1) ? nullptr : store.handle(row);
+    }
+
+    TrackBase* at(TrackId id) const
+    {
+        int row = store.rowOf(id);
+        if (row == -1)
+            throw DJException("TrackManager::at stale or invalid TrackId");
+        return store.handle(row);
+    }
+
+    void remove(TrackId id)
+    {
+        int row = store.rowOf(id);
+        if (row == -1)
+            throw DJException("TrackManager::remove stale or invalid TrackId");
+        removeAt(row);
+    }
+
+    // Library engine: edits go through the manager so the columns and the
+    // BPM index never disagree with the track object.
+    void updateBpm(int index, int bpm)
+    {
+        TrackBase* p = (*this)[index];
+        requireColumnBpm(bpm);
+        if (journal)
+        {
+            logScratch.bpm = bpm;
+            logOp(LOG_SET_BPM, index);
+        }
+        int slot = static_cast<int>(store.idAt(index).slot);
+        if (neighbors)
+            neighbors->erase(store, bpmIndex, index);
+        bpmIndex.erase(slot, store.bpmColumn()[index]);
+        aggregates.removeRow(store, index);
+        p->setBpm(bpm);
+        store.refreshRow(index);
+        aggregates.addRow(store, index);
+        bpmIndex.insert(slot, store.bpmColumn()[index]);
+        if (neighbors)
+            neighbors->insert(store, bpmIndex, index);
+        markChanged();
+    }
+
+    void updateEnergy(int index, EnergyLevel e)
+    {
+        TrackBase* p = (*this)[index];
+        if (journal)
+        {
+            logScratch.energy = e;
+            logOp(LOG_SET_ENERGY, index);
+        }
+        if (neighbors)
+            neighbors->erase(store, bpmIndex, index);
+        aggregates.removeRow(store, index);
+        p->setEnergy(e);
+        store.refreshRow(index);
+        aggregates.addRow(store, index);
+        if (neighbors)
+            neighbors->insert(store, bpmIndex, index);
+        markChanged();
+    }
+
+    void updateKey(int index, const string& key)
+    {
+        TrackBase* p = (*this)[index];
+        if (journal)
+        {
+            logScratch.text[SNAP_KEY] = key;
+            logOp(LOG_SET_KEY, index);
+        }
+        if (neighbors)
+            neighbors->erase(store, bpmIndex, index);
+        aggregates.removeRow(store, index);
+        p->setKey(key);
+        store.refreshRow(index);
+        aggregates.addRow(store, index);
+        if (neighbors)
+            neighbors->insert(store, bpmIndex, index);
+        markChanged();
+    }
+
+    void updateGenre(int index, const string& genre)
+    {
+        TrackBase* p = (*this)[index];
+        if (journal)
+        {
+            logScratch.text[SNAP_GENRE] = genre;
+            logOp(LOG_SET_GENRE, index);
+        }
+        aggregates.removeRow(store, index);
+        p->setGenre(genre);
+        store.refreshRow(index);
+        aggregates.addRow(store, index);
+        markChanged();
+    }
+
+    // Week 07 requirement: operator[] must THROW on invalid index.
+    // Also: we use our CUSTOM exception here (DJException) to satisfy the rubric.
+    TrackBase* operator[](int index) const
+    {
+        if (index < 0 || index >= store.getSize())
+            throw DJException("TrackManager::operator[] invalid index");
+
+        // Valid index, safe to access:
+        return store.handle(index);
+    }
+
+    // Week 06: operator+= adds item pointer to container
+    TrackManager& operator+=(TrackBase* p)
+    {
+        // explicit use of this pointer (Week 06 requirement)
+        this->add(p);
+        return *this;
+    }
+
+    // Week 07 requirement: operator-= must THROW on invalid removal.
+    TrackManager& operator-=(int index)
+    {
+        if (index < 0 || index >= store.getSize())
+            throw DJException("TrackManager::operator-= invalid removal index");
+
+        this->removeAt(index);
+        return *this;
+    }
+
+    void printAll(ostream& out) const
+    {
+        if (store.getSize() == 0)
+        {
+            out << "No tracks stored yet.\n";
+            return;
+        }
+
+        // Library engine: one buffer per table instead of setw per cell
+        TableWriter w(out);
+        printWeek5TableHeader(w);
+
+        for (int i = 0; i < store.getSize(); i++)
+        {
+            w.left(i, 4).text(" ");
+            printRow(w, i);
+            w.endLine();
+        }
+
+        printSeparator(w);
+    }
+
+    void printRow(TableWriter& w, int index) const
+    {
+        TrackBase* p = store.handle(index);
+        if (store.typeAt(index) == TAG_STREAM)
+            static_cast<const StreamTrack*>(p)->print(w);
+        else
+            static_cast<const LocalTrack*>(p)->print(w);
+    }
+
+    // Weeks 1-4 table rows (printTrackRow) straight from the tracks, without
+    // building a Track record per row.
+    void printRecordRows(TableWriter& w) const
+    {
+        for (int i = 0; i < store.getSize(); i++)
+        {
+            TrackBase* p = store.handle(i);
+            const MixNotes& notes = (store.typeAt(i) == TAG_STREAM)
+                ? static_cast<const StreamTrack*>(p)->notesRef()
+                : static_cast<const LocalTrack*>(p)->notesRef();
+            printTrackRow(w, p->titleView(), p->getArtistSymbol().str(), p->getGenreSymbol().str(),
+                p->getKeySymbol().str(), p->getBpm(), p->getEnergy(), notes.view());
+        }
+    }
+
+    // Type-tag switch on the store's type column: the final classes' print()
+    // is called directly instead of through the vtable.
+    void printRow(ostream& out, int index) const
+    {
+        TrackBase* p = store.handle(index); // valid index, so handle() is safe (no exception)
+        if (!p)
+            return;
+
+        switch (store.typeAt(index))
+        {
+        case TAG_LOCAL:
+            static_cast<const LocalTrack*>(p)->print(out);
+            break;
+        case TAG_STREAM:
+            static_cast<const StreamTrack*>(p)->print(out);
+            break;
+        }
+    }
+
+    void toStreamAt(ostream& out, int index) const
+    {
+        TrackBase* p = (*this)[index];
+        switch (store.typeAt(index))
+        {
+        case TAG_LOCAL:
+            static_cast<const LocalTrack*>(p)->toStream(out);
+            break;
+        case TAG_STREAM:
+            static_cast<const StreamTrack*>(p)->toStream(out);
+            break;
+        }
+    }
+
+    // Copies the library into an inline (by value) list, dense order preserved.
+    InlineTrackList toInlineList() const
+    {
+        InlineTrackList list(store.getSize() > 2 ? store.getSize() : 2);
+        for (int i = 0; i < store.getSize(); i++)
+        {
+            TrackBase* p = store.handle(i);
+            if (store.typeAt(i) == TAG_STREAM)
+                list.add(*static_cast<const StreamTrack*>(p));
+            else
+                list.add(*static_cast<const LocalTrack*>(p));
+        }
+        return list;
+    }
+
+    void saveReport(const string& filename) const
+    {
+        ofstream fout(filename.c_str());
+        if (!fout)
+        {
+            cout << "Could not open file: " << filename << "\n";
+            return;
+        }
+
+        fout << "==================== DJ SET ARCHITECT REPORT (Week 7) ====================\n";
+        fout << "Tracks stored: " << store.getSize() << "\n\n";
+
+        printAll(fout);
+
+        fout << "\n";
+        aggregates.snapshot().writeTo(fout);
+
+        fout.close();
+        cout << "Report saved to " << filename << "\n";
+    }
+
+    // -------------------- Week 09: Sequential (Linear) Search --------------------
+    // Scans the BPM vector element-by-element from the start.
+    // Returns the index of the first match, or -1 if the target BPM is not found.
+    // No std::find or any library search is used — the loop does all the work.
+    int sequentialSearchBpm(int target) const
+    {
+        for (int i = 0; i < store.getSize(); i++)
+        {
+            if (store.bpmAt(i) == target)
+                return i; // found at this index
+        }
+        return -1; // not found
+    }
+
+    // -------------------- Week 09: Bubble Sort --------------------
+    // Sorts the BPM vector in ascending order using the Bubble Sort algorithm.
+    // Each outer pass "bubbles" the largest unsorted value to its final position.
+    // No std::sort — every swap is done manually.
+    // Kept as the Week 09 reference (and benchmark baseline); the menu now uses
+    // sortByBpm(), which is O(n).
+    // Library engine: whole store rows are swapped, so every column and the
+    // track objects stay aligned after sorting.
+    void sortBpmsBubble()
+    {
+        if (journal)
+            logOp(LOG_SORT_BPM, 0); // replayed with sortByBpm(): both sorts are stable
+        int n = store.getSize();
+        for (int i = 0; i < n - 1; i++)
+        {
+            for (int j = 0; j < n - i - 1; j++)
+            {
+                if (store.bpmAt(j) > store.bpmAt(j + 1))
+                    store.swapRows(j, j + 1); // swap adjacent elements
+            }
+        }
+        markChanged();
+    }
+
+    // -------------------- Library Engine: Linear-Time Sort --------------------
+    // Sorts the library by BPM with countingSortOrder() and applies the SAME
+    // permutation to every store column, so index i names the same track
+    // everywhere (operator[] and binarySearchBpm() agree afterwards).
+    // Returns the permutation: result[k] = pre-sort index of the track now at k.
+    vector<int> sortByBpm()
+    {
+        if (journal)
+            logOp(LOG_SORT_BPM, 0);
+        vector<int> order = countingSortOrder(store.bpmColumn());
+        store.permute(order);
+        markChanged();
+        return order;
+    }
+
+    // -------------------- Library Engine: Sorted View Queries --------------------
+    // These work WITHOUT sorting the library: results are real library indexes
+    // (usable with operator[]) or track pointers, found in O(log n) through the
+    // lazily rebuilt sortedView.
+
+    // Library index of the track at sorted position k (0 = slowest).
+    int sortedIndexAt(int k) const
+    {
+        ensureSortedView();
+        if (k < 0 || k >= static_cast<int>(sortedView.size()))
+            throw DJException("TrackManager::sortedIndexAt invalid sorted position");
+        return sortedView[k];
+    }
+
+    // Track at sorted position k (0 = slowest).
+    TrackBase* sortedAt(int k) const
+    {
+        return store.handle(sortedIndexAt(k));
+    }
+
+    // Library index of the first track (in BPM order) with exactly this BPM, or -1.
+    int findIndexByBpm(int target) const
+    {
+        ensureSortedView();
+        int pos = lowerBoundInView(target);
+        if (pos < static_cast<int>(sortedView.size()) && store.bpmColumn()[sortedView[pos]] == target)
+            return sortedView[pos];
+        return -1;
+    }
+
+    // Track with this BPM, or nullptr if none.
+    TrackBase* findTrackByBpm(int target) const
+    {
+        int idx = findIndexByBpm(target);
+        return (idx == -1) ? nullptr : store.handle(idx);
+    }
+
+    // Library indexes of every track with minBpm <= BPM <= maxBpm, slowest first.
+    vector<int> findIndexesInBpmRange(int minBpm, int maxBpm) const
+    {
+        vector<int> result;
+        if (minBpm > maxBpm)
+            return result;
+
+        ensureSortedView();
+        const vector<uint16_t>& bpms = store.bpmColumn();
+        int n = static_cast<int>(sortedView.size());
+        for (int pos = lowerBoundInView(minBpm); pos < n && bpms[sortedView[pos]] <= maxBpm; pos++)
+            result.push_back(sortedView[pos]);
+        return result;
+    }
+
+    // -------------------- Library Engine: Recommendations (BPM index) --------------------
+    // Same rule as recommendNextTracks(): BPM within +/-bpmRange of currentBpm and
+    // energy stays steady or rises by one. Only the 2*bpmRange+1 buckets around
+    // currentBpm are visited. Returns stable TrackIds (slowest BPM bucket first).
+    // Harmonic filter: with a currentKey (0..23, see parseHarmonicKey) only tracks
+    // whose key scores at least minKeyScore in KEY_COMPAT are kept; that check is
+    // one table lookup per candidate. NO_KEY disables the filter.
+    vector<TrackId> recommendNext(int currentBpm, EnergyLevel currentEnergy, int bpmRange,
+        int currentKey = NO_KEY, int minKeyScore = KEY_SCORE_COMPATIBLE) const
+    {
+        vector<int> candidates;
+        bpmIndex.collectWindow(currentBpm, bpmRange, candidates);
+
+        vector<TrackId> result;
+        result.reserve(candidates.size());
+        for (int slot : candidates)
+        {
+            int row = store.rowOfSlot(static_cast<uint32_t>(slot));
+            if (followsRule(row, currentEnergy, currentKey, minKeyScore))
+                result.push_back(store.idAt(row));
+        }
+        return result;
+    }
+
+    // Every track whose tempo fits targetBpm under tol (see TempoTolerance):
+    // one bucket-range lookup per tempo ratio. Sorted by the pitch change
+    // needed (smallest first); ties keep bucket order.
+    vector<TempoMatch> findTempoMatches(int targetBpm, const TempoTolerance& tol) const
+    {
+        vector<TempoMatch> result;
+        collectTempoMatches(targetBpm, tol, result, nullptr);
+        return result;
+    }
+
+    // recommendNext() with a TempoTolerance instead of a fixed +/-BPM window:
+    // tempo matches that also pass the energy and harmonic rules.
+    vector<TempoMatch> recommendByTempo(int currentBpm, EnergyLevel currentEnergy, const TempoTolerance& tol,
+        int currentKey = NO_KEY, int minKeyScore = KEY_SCORE_COMPATIBLE) const
+    {
+        TempoRule rule{ currentEnergy, currentKey, minKeyScore };
+        vector<TempoMatch> result;
+        collectTempoMatches(currentBpm, tol, result, &rule);
+        return result;
+    }
+
+    // The query.k best next tracks by one combined score, best first (see
+    // ScoredRecommender). Only the BPM buckets nearest the query are read.
+    vector<ScoredTrack> topRecommendations(const RecommendQuery& query) const
+    {
+        return ScoredRecommender(store, bpmIndex).top(query);
+    }
+
+    // Score of one track against a query, whatever its BPM distance.
+    ScoredTrack scoreRecommendation(const RecommendQuery& query, TrackId id) const
+    {
+        int row = store.rowOf(id);
+        if (row < 0)
+            throw DJException("scoreRecommendation: stale TrackId");
+        return ScoredRecommender(store, bpmIndex).scoreRow(query, row);
+    }
+
+private:
+    // recommendNext() rule for one row: energy steady or +1, key (if given)
+    // scoring at least minKeyScore.
+    bool followsRule(int row, EnergyLevel currentEnergy, int currentKey, int minKeyScore) const
+    {
+        int e = store.energyColumn()[row];
+        if (e != currentEnergy && e != currentEnergy + 1)
+            return false;
+        if (currentKey < 0 || currentKey >= HARMONIC_KEYS)
+            return true;
+        uint8_t key = store.harmonicKeyColumn()[row];
+        return key != NO_KEY_PACKED && KEY_COMPAT.score[currentKey][key] >= minKeyScore;
+    }
+
+    struct TempoRule
+    {
+        EnergyLevel energy;
+        int key;
+        int minScore;
+    };
+
+    // Tempo matches for targetBpm; rule == nullptr keeps every tempo match.
+    // Every track in one bucket needs the same pitch change, so the buckets
+    // (not the tracks) are put in pitch order and then emitted whole.
+    void collectTempoMatches(int targetBpm, const TempoTolerance& tol, vector<TempoMatch>& out, const TempoRule* rule) const
+    {
+        struct Span
+        {
+            double pitch;
+            int bpm;
+            double ratio;
+            int outlierSlot; // -1 = the whole bucket of 'bpm'
+        };
+
+        vector<Span> spans;
+        vector<int> slots;
+        for (const TempoRange& range : tempoRanges(targetBpm, tol))
+        {
+            int first = (range.lo < BPM_MIN) ? BPM_MIN : range.lo;
+            int last = (range.hi > BPM_MAX) ? BPM_MAX : range.hi;
+            for (int bpm = first; bpm <= last; bpm++)
+                spans.push_back({ tempoPitchPercent(targetBpm, bpm, range.ratio), bpm, range.ratio, -1 });
+
+            slots.clear();
+            bpmIndex.collectOutliers(range.lo, range.hi, slots);
+            for (int slot : slots)
+            {
+                int bpm = store.bpmAt(store.rowOfSlot(static_cast<uint32_t>(slot)));
+                spans.push_back({ tempoPitchPercent(targetBpm, bpm, range.ratio), bpm, range.ratio, slot });
+            }
+        }
+        stable_sort(spans.begin(), spans.end(), [](const Span& a, const Span& b) {
+            return fabs(a.pitch) < fabs(b.pitch);
+        });
+
+        for (const Span& span : spans)
+        {
+            int single[1] = { span.outlierSlot };
+            const int* begin = single;
+            const int* end = single + 1;
+            if (span.outlierSlot < 0)
+            {
+                const vector<int>& b = bpmIndex.bucket(span.bpm);
+                begin = b.data();
+                end = b.data() + b.size();
+            }
+            for (const int* slot = begin; slot != end; ++slot)
+            {
+                int row = store.rowOfSlot(static_cast<uint32_t>(*slot));
+                if (rule && !followsRule(row, rule->energy, rule->key, rule->minScore))
+                    continue;
+                out.push_back({ store.idAt(row), span.bpm, span.ratio, span.pitch });
+            }
+        }
+    }
+
+public:
+
+    // Library rows whose BPM is within +/-radius of center (bucket index; the
+    // rows are appended to 'rows', bucket by bucket).
+    void rowsInBpmWindow(int center, int radius, vector<int>& rows) const
+    {
+        size_t first = rows.size();
+        vector<int> slots;
+        bpmIndex.collectWindow(center, radius, slots);
+        rows.resize(first + slots.size());
+        for (size_t i = 0; i < slots.size(); i++)
+            rows[first + i] = store.rowOfSlot(static_cast<uint32_t>(slots[i]));
+    }
+
+    // -------------------- Library Engine: Neighbor Index --------------------
+    // Builds the top-K lists for the current library; from then on every
+    // add/remove/updateBpm/updateEnergy/updateKey keeps them current.
+    void enableNeighborIndex(const NeighborOptions& options = NeighborOptions())
+    {
+        neighbors.reset(new NeighborIndex(options));
+        neighbors->build(store, bpmIndex);
+    }
+
+    void disableNeighborIndex() { neighbors.reset(); }
+    bool hasNeighborIndex() const { return neighbors != nullptr; }
+
+    // O(1) lookup of the precomputed list (best first, at most K entries).
+    // Throws DJException if the index is off or the id is stale.
+    const vector<Neighbor>& neighborsOf(TrackId id) const
+    {
+        if (!neighbors)
+            throw DJException("TrackManager::neighborsOf neighbor index not enabled");
+        if (!contains(id))
+            throw DJException("TrackManager::neighborsOf stale or invalid TrackId");
+        return neighbors->neighborsOfSlot(id.slot);
+    }
+
+    // Number of tracks at exactly this BPM (O(1) bucket lookup).
+    int countAtBpm(int bpm) const { return bpmIndex.bucketSize(bpm); }
+
+    // -------------------- Library Engine: SIMD Column Scans --------------------
+    // Unlike sequentialSearchBpm(), these return EVERY match (ascending library
+    // indexes) and run the best SIMD kernel the CPU supports.
+    vector<int> findAllBpm(int target) const
+    {
+        return findAllBpmInRange(target, target);
+    }
+
+    vector<int> findAllBpmInRange(int minBpm, int maxBpm) const
+    {
+        vector<int> hits;
+        ColumnScanner::best().findAll(store.bpmColumn(), minBpm, maxBpm, hits);
+        return hits;
+    }
+
+    int countBpmEqual(int target) const
+    {
+        return ColumnScanner::best().count(store.bpmColumn(), target, target);
+    }
+
+    int countBpmInRange(int minBpm, int maxBpm) const
+    {
+        return ColumnScanner::best().count(store.bpmColumn(), minBpm, maxBpm);
+    }
+
+    vector<int> findAllEnergy(EnergyLevel e) const
+    {
+        vector<int> hits;
+        ColumnScanner::best().findAll(store.energyColumn(), e, e, hits);
+        return hits;
+    }
+
+    // Library engine: O(1) - counts are kept up to date by add/remove/updateEnergy.
+    int countEnergy(EnergyLevel e) const
+    {
+        return aggregates.getEnergy().of(e);
+    }
+
+    const EnergyCounts& getEnergyCounts() const { return aggregates.getEnergy(); }
+
+    // Recounts LOW/MEDIUM/HIGH in one SIMD pass over the energy column
+    // (ex: after tracks were edited directly through operator[]).
+    EnergyCounts energyHistogram() const
+    {
+        return ColumnScanner::best().histogram(store.energyColumn());
+    }
+
+    int countEnergyInRange(EnergyLevel lo, EnergyLevel hi) const
+    {
+        return ColumnScanner::best().count(store.energyColumn(), lo, hi);
+    }
+
+    // -------------------- Library Engine: Genre Counts (aggregates) --------------------
+    // One dictionary lookup, then the maintained per-genre count: O(1).
+    int countGenre(const string& genre) const
+    {
+        long long id = SymbolTable::global().find(genre);
+        if (id < 0)
+            return 0; // genre never stored
+        return aggregates.genreCount(static_cast<uint32_t>(id));
+    }
+
+    // -------------------- Week 09: Binary Search --------------------
+    // IMPORTANT: sortBpmsBubble() must be called before this function.
+    // Binary search requires the data to be in sorted order; without it the
+    // mid-point comparison sends the search in the wrong direction.
+    // Uses the classic low / mid / high index approach.
+    // Returns the index of the found element, or -1 if not found.
+    int binarySearchBpm(int target) const
+    {
+        int low  = 0;
+        int high = store.getSize() - 1;
+
+        while (low <= high)
+        {
+            int mid = low + (high - low) / 2; // avoids integer overflow vs (low+high)/2
+
+            if (store.bpmAt(mid) == target)
+                return mid;                   // exact match found
+            else if (store.bpmAt(mid) < target)
+                low = mid + 1;                // target is in right half
+            else
+                high = mid - 1;              // target is in left half
+        }
+        return -1; // not found
+    }
+
+    // Week 09 helper: returns how many BPMs are stored in the vector
+    int getBpmCount() const { return store.getSize(); }
+
+    // Week 09 helper: returns BPM value at position i (uses .at() for bounds check)
+    int getBpmAt(int i) const { return store.bpmAt(i); }
+
+    ~TrackManager()
+    {
+        // delete all owned objects (pooled ones are only destroyed here;
+        // their slabs are released in bulk by the SlabPool destructors)
+        for (int i = 0; i < store.getSize(); i++)
+            disposeRow(i);
+        // TrackStore (and its DynamicArray) cleans up the arrays
+    }
+};
+
+// -------------------- Library Engine: Setlist Builder (beam search) --------------------
+// A setlist is a path through the "can mix into" graph: every track links to the
+// tracks within a few BPM (bucket index), and each link has a transition score
+// (BPM jump, Camelot key compatibility, distance from the wanted energy).
+// SetBuilder keeps the beamWidth best partial sets at every step instead of
+// exploring all paths, so the cost is length * beamWidth * (candidates per step).
+// (TransitionScorer lives with the neighbor index, above TrackManager.)
+
+// Target energy over the set, as evenly spaced control points (1.0 = LOW, 3.0 = HIGH).
+struct EnergyArc
+{
+    vector<double> points;
+
+    static EnergyArc steady(EnergyLevel e) { return EnergyArc{ { static_cast<double>(e) } }; }
+    static EnergyArc rising() { return EnergyArc{ { 1.0, 3.0 } }; }
+    static EnergyArc peak() { return EnergyArc{ { 1.5, 3.0, 2.0 } }; } // build, peak, cool down
+
+    // Wanted energy at position 'step' of a 'length'-track set (linear interpolation).
+    double target(int step, int length) const
+    {
+        if (points.empty())
+            return MEDIUM;
+        if (points.size() == 1 || length <= 1)
+            return points.front();
+
+        double t = static_cast<double>(step) / (length - 1) * (points.size() - 1);
+        size_t seg = static_cast<size_t>(t);
+        if (seg >= points.size() - 1)
+            return points.back();
+        double frac = t - seg;
+        return points[seg] + (points[seg + 1] - points[seg]) * frac;
+    }
+};
+
+struct SetBuildOptions
+{
+    int length = 10;          // tracks in the set, start track included
+    int beamWidth = 200;      // partial sets kept per step
+    int expandPerState = 16;  // best next tracks tried from each partial set
+    EnergyArc arc = EnergyArc::rising();
+    TransitionWeights weights;
+    int maxBpmJump = 6;       // candidate window: +/- BPM from the current track
+    unsigned long long seed = 0; // with noise > 0: which randomized search to run
+    double noise = 0.0;       // random jitter added to scores when RANKING (not to results)
+};
+
+struct Setlist
+{
+    vector<TrackId> tracks;   // in play order, tracks[0] = start track
+    double score = 0.0;       // sum of transition scores
+};
+
+class SetBuilder
+{
+private:
+    const TrackManager& library;
+
+    // Beam entries live in one arena; a set is read back through parent links.
+    struct Node
+    {
+        int row;
+        int parent;   // arena index, -1 for the start
+        double score; // true sum of transition scores
+        double rank;  // score + seeded jitter (equal to score when noise == 0)
+    };
+
+    static bool usedInPath(const vector<Node>& arena, int node, int row)
+    {
+        for (int n = node; n != -1; n = arena[n].parent)
+            if (arena[n].row == row)
+                return true;
+        return false;
+    }
+
+    // Largest score one more transition can add (every term is <= 0 except the
+    // key term). Negative weights break that bound, so pruning is then disabled.
+    static double maxStepGain(const TransitionWeights& w)
+    {
+        if (w.bpm < 0 || w.key < 0 || w.energy < 0)
+            return -1.0;
+        return w.key * TransitionScorer::keyValue(KEY_SCORE_PERFECT);
+    }
+
+public:
+    SetBuilder(const TrackManager& lib) : library(lib) {}
+
+    // Throws DJException for a stale start id or a length < 1. The set is shorter
+    // than options.length only if no unused track is reachable within maxBpmJump.
+    Setlist build(TrackId start, const SetBuildOptions& options) const
+    {
+        return buildTop(start, options, 1).front();
+    }
+
+    // Up to 'count' best sets from the final beam, best first.
+    // pruneBelow (optional, may be raised by other threads while this runs):
+    // partial sets that cannot reach this score even with perfect remaining
+    // transitions are dropped early. Pruning never shortens a set: if it drops
+    // every continuation, no set from this search can beat the bound and the
+    // result is empty.
+    vector<Setlist> buildTop(TrackId start, const SetBuildOptions& options, int count,
+        const atomic<double>* pruneBelow = nullptr) const
+    {
+        int startRow = library.indexOf(start);
+        if (startRow == -1)
+            throw DJException("SetBuilder::build stale or invalid start TrackId");
+        if (options.length < 1)
+            throw DJException("SetBuilder::build length must be at least 1");
+
+        const TrackStore& store = library.getStore();
+        TransitionScorer scorer(options.weights, options.maxBpmJump);
+        int beamWidth = (options.beamWidth < 1) ? 1 : options.beamWidth;
+        int perState = (options.expandPerState < 1) ? 1 : options.expandPerState;
+        double gain = maxStepGain(options.weights);
+        unsigned long long rng = options.seed * 0x9E3779B97F4A7C15ULL + 1;
+
+        vector<Node> arena;
+        arena.push_back(Node{ startRow, -1, 0.0, 0.0 });
+        vector<int> beam(1, 0);
+
+        vector<int> window;
+        vector<pair<double, int>> best; // (rank, row), min-heap of this state's top picks
+        vector<int> next;
+        auto worse = [](const pair<double, int>& a, const pair<double, int>& b) {
+            return a.first > b.first || (a.first == b.first && a.second < b.second);
+        };
+
+        for (int step = 1; step < options.length; step++)
+        {
+            double target = options.arc.target(step, options.length);
+            double bound = (pruneBelow && gain >= 0) ? pruneBelow->load(memory_order_relaxed) : -1e300;
+            double reachable = gain * (options.length - 1 - step); // best case after this step
+            next.clear();
+            bool pruned = false;
+
+            for (int node : beam)
+            {
+                int row = arena[node].row;
+                window.clear();
+                library.rowsInBpmWindow(store.bpmColumn()[row], scorer.getMaxBpmJump(), window);
+
+                best.clear();
+                for (int cand : window)
+                {
+                    double rank = scorer.score(store, row, cand, target);
+                    if (options.noise > 0)
+                    {
+                        rng ^= rng << 13; rng ^= rng >> 7; rng ^= rng << 17; // xorshift64
+                        rank += options.noise * (static_cast<double>(rng >> 11) / 9007199254740992.0 - 0.5);
+                    }
+                    if (static_cast<int>(best.size()) == perState && !worse(make_pair(rank, cand), best.front()))
+                        continue; // cannot enter this state's top picks
+                    if (usedInPath(arena, node, cand))
+                        continue; // no repeats within a set
+                    best.push_back(make_pair(rank, cand));
+                    push_heap(best.begin(), best.end(), worse);
+                    if (static_cast<int>(best.size()) > perState)
+                    {
+                        pop_heap(best.begin(), best.end(), worse);
+                        best.pop_back();
+                    }
+                }
+
+                for (const pair<double, int>& pick : best)
+                {
+                    double sc = arena[node].score + scorer.score(store, row, pick.second, target);
+                    if (sc + reachable < bound)
+                    {
+                        pruned = true;
+                        continue; // cannot beat the shared bound any more
+                    }
+                    arena.push_back(Node{ pick.second, node, sc, arena[node].rank + pick.first });
+                    next.push_back(static_cast<int>(arena.size()) - 1);
+                }
+            }
+
+            if (next.empty() && pruned)
+                return vector<Setlist>(); // nothing here can beat the bound
+            if (next.empty())
+                break; // dead end: keep the best sets found so far
+
+            // Keep the beamWidth highest-ranked partial sets (ties: earlier node).
+            auto better = [&arena](int a, int b) {
+                return arena[a].rank > arena[b].rank || (arena[a].rank == arena[b].rank && a < b);
+            };
+            if (static_cast<int>(next.size()) > beamWidth)
+            {
+                nth_element(next.begin(), next.begin() + beamWidth, next.end(), better);
+                next.resize(beamWidth);
+            }
+            sort(next.begin(), next.end(), better);
+            beam.swap(next);
+        }
+
+        // Final order by true score (ranking jitter only steers the search).
+        sort(beam.begin(), beam.end(), [&arena](int a, int b) {
+            return arena[a].score > arena[b].score || (arena[a].score == arena[b].score && a < b);
+        });
+
+        vector<Setlist> result;
+        for (size_t i = 0; i < beam.size() && static_cast<int>(result.size()) < count; i++)
+        {
+            Setlist set;
+            set.score = arena[beam[i]].score;
+            for (int n = beam[i]; n != -1; n = arena[n].parent)
+                set.tracks.push_back(store.idAt(arena[n].row));
+            reverse(set.tracks.begin(), set.tracks.end());
+            result.push_back(set);
+        }
+        return result;
+    }
+};
+
+// -------------------- Library Engine: Work-Stealing Thread Pool --------------------
+// One task deque per worker. submit() spreads tasks round-robin over the deques
+// (a task submitted from inside a worker goes to that worker's own deque).
+// Workers take from the BACK of their own deque and, when it is empty, steal
+// from the FRONT of another worker's deque, so a worker with long tasks does
+// not hold up the rest. wait() blocks until every submitted task has finished
+// and rethrows the first exception a task threw.
+class WorkStealingPool
+{
+private:
+    struct TaskQueue
+    {
+        mutex lock;
+        deque<function<void()>> tasks;
+    };
+
+    vector<unique_ptr<TaskQueue>> queues;
+    vector<thread> workers;
+
+    mutex stateLock;
+    condition_variable wake;  // work queued or stopping
+    condition_variable idle;  // pending dropped to 0
+    int queued = 0;           // tasks sitting in deques (guarded by stateLock)
+    atomic<int> pending{ 0 }; // submitted, not finished
+    bool stopping = false;
+    atomic<unsigned> nextQueue{ 0 };
+    atomic<long long> steals{ 0 };
+    exception_ptr firstError;
+
+    static int& currentWorker()
+    {
+        static thread_local int index = -1;
+        return index;
+    }
+
+    bool popFrom(int q, bool back, function<void()>& task)
+    {
+        TaskQueue& tq = *queues[q];
+        lock_guard<mutex> guard(tq.lock);
+        if (tq.tasks.empty())
+            return false;
+        if (back)
+        {
+            task = move(tq.tasks.back());
+            tq.tasks.pop_back();
+        }
+        else
+        {
+            task = move(tq.tasks.front());
+            tq.tasks.pop_front();
+        }
+        return true;
+    }
+
+    bool takeTask(int self, function<void()>& task)
+    {
+        if (popFrom(self, true, task))
+            return true;
+        int n = static_cast<int>(queues.size());
+        for (int k = 1; k < n; k++)
+            if (popFrom((self + k) % n, false, task))
+            {
+                steals++;
+                return true;
+            }
+        return false;
+    }
+
+    void workerLoop(int self)
+    {
+        currentWorker() = self;
+        while (true)
+        {
+            {
+                unique_lock<mutex> lk(stateLock);
+                wake.wait(lk, [this]() { return stopping || queued > 0; });
+                if (queued == 0)
+                    return; // stopping and drained
+                queued--;   // claim one task; it is in some deque
+            }
+
+            function<void()> task;
+            while (!takeTask(self, task)) {} // claimed, so a deque holds it (pushed before queued++)
+
+            try
+            {
+                task();
+            }
+            catch (...)
+            {
+                lock_guard<mutex> guard(stateLock);
+                if (!firstError)
+                    firstError = current_exception();
+            }
+
+            if (--pending == 0)
+            {
+                lock_guard<mutex> guard(stateLock);
+                idle.notify_all();
+            }
+        }
+    }
+
+public:
+    // threadCount <= 0 -> one worker per hardware thread.
+    WorkStealingPool(int threadCount = 0)
+    {
+        if (threadCount <= 0)
+            threadCount = static_cast<int>(thread::hardware_concurrency());
+        if (threadCount <= 0)
+            threadCount = 1;
+
+        for (int i = 0; i < threadCount; i++)
+            queues.push_back(unique_ptr<TaskQueue>(new TaskQueue()));
+        for (int i = 0; i < threadCount; i++)
+            workers.push_back(thread(&WorkStealingPool::workerLoop, this, i));
+    }
+
+    WorkStealingPool(const WorkStealingPool&) = delete;
+    WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+
+    int getThreadCount() const { return static_cast<int>(workers.size()); }
+    long long getSteals() const { return steals.load(); }
+
+    void submit(function<void()> task)
+    {
+        int self = currentWorker();
+        int q = (self >= 0 && self < static_cast<int>(queues.size()))
+            ? self
+            : static_cast<int>(nextQueue++ % queues.size());
+
+        pending++;
+        {
+            lock_guard<mutex> guard(queues[q]->lock);
+            queues[q]->tasks.push_back(move(task));
+        }
+        {
+            lock_guard<mutex> guard(stateLock);
+            queued++;
+        }
+        wake.notify_one();
+    }
+
+    // Must not be called from inside a task (the worker would wait on itself).
+    void wait()
+    {
+        unique_lock<mutex> lk(stateLock);
+        idle.wait(lk, [this]() { return pending.load() == 0; });
+        if (firstError)
+        {
+            exception_ptr error = firstError;
+            firstError = nullptr;
+            rethrow_exception(error);
+        }
+    }
+
+    ~WorkStealingPool()
+    {
+        {
+            lock_guard<mutex> guard(stateLock);
+            stopping = true;
+        }
+        wake.notify_all();
+        for (thread& t : workers)
+            t.join();
+    }
+};
+
+// -------------------- Library Engine: Parallel Set Optimizer --------------------
+// Runs many independent beam searches (different seeds = different score jitter)
+// on a WorkStealingPool and merges their results into the top-k DISTINCT sets.
+// The k-th best score found so far is shared through an atomic: every search
+// prunes partial sets that can no longer beat it. Seed 0 runs without jitter,
+// so the best set is never worse than a single SetBuilder::build().
+struct ParallelSetOptions
+{
+    int seeds = 32;      // independent searches
+    int topK = 5;        // distinct setlists returned
+    double noise = 0.35; // jitter for seeds 1..n-1
+};
+
+class ParallelSetOptimizer
+{
+private:
+    const TrackManager& library;
+    WorkStealingPool& pool;
+
+    // Order: complete (longer) sets first, since a set cut short by a dead end
+    // skips transitions and its score is not comparable; then higher score,
+    // then lexicographic by slot (deterministic).
+    static bool betterSet(const Setlist& a, const Setlist& b)
+    {
+        if (a.tracks.size() != b.tracks.size())
+            return a.tracks.size() > b.tracks.size();
+        if (a.score != b.score)
+            return a.score > b.score;
+        for (size_t i = 0; i < a.tracks.size(); i++)
+            if (a.tracks[i].slot != b.tracks[i].slot)
+                return a.tracks[i].slot < b.tracks[i].slot;
+        return false;
+    }
+
+public:
+    ParallelSetOptimizer(const TrackManager& lib, WorkStealingPool& p) : library(lib), pool(p) {}
+
+    // The library must not change while this runs (searches read it concurrently).
+    vector<Setlist> optimize(TrackId start, const SetBuildOptions& options, const ParallelSetOptions& par) const
+    {
+        if (!library.contains(start))
+            throw DJException("ParallelSetOptimizer::optimize stale or invalid start TrackId");
+        int topK = (par.topK < 1) ? 1 : par.topK;
+        int seeds = (par.seeds < 1) ? 1 : par.seeds;
+
+        mutex resultLock;
+        vector<Setlist> top;
+        atomic<double> bound{ -1e300 };
+
+        for (int seed = 0; seed < seeds; seed++)
+        {
+            pool.submit([&, seed]() {
+                SetBuildOptions local = options;
+                local.seed = static_cast<unsigned long long>(seed);
+                local.noise = (seed == 0) ? 0.0 : par.noise;
+                vector<Setlist> found = SetBuilder(library).buildTop(start, local, topK, &bound);
+
+                lock_guard<mutex> guard(resultLock);
+                for (Setlist& set : found)
+                {
+                    bool duplicate = false;
+                    for (const Setlist& kept : top)
+                        duplicate = duplicate || kept.tracks == set.tracks;
+                    if (!duplicate)
+                        top.push_back(move(set));
+                }
+                sort(top.begin(), top.end(), betterSet);
+                if (static_cast<int>(top.size()) > topK)
+                    top.resize(topK);
+                // only complete sets may set the bound the searches prune against
+                if (static_cast<int>(top.size()) == topK && static_cast<int>(top.back().tracks.size()) == options.length)
+                    bound.store(top.back().score, memory_order_relaxed);
+            });
+        }
+        pool.wait();
+        return top;
+    }
+};
+
+// -------------------- Library Engine: Energy-Arc DP Planner --------------------
+// Plans a set that follows an exact EnergyLevel curve (ex: LOW LOW MEDIUM HIGH
+// HIGH MEDIUM). Tracks with the same (BPM, harmonic key, energy) are
+// interchangeable for the transition score, so the dynamic program runs over
+// those CELLS instead of over tracks:
+//   best[step][cell] = best total score of a plan whose step-th track is in cell
+// with 141 BPMs x 25 keys (24 + unknown) = 3525 cells per step, i.e. memory is
+// O(L x cells) no matter how many tracks the library holds. Each step looks only
+// at cells within +/-maxBpmStep BPM of the previous one (the BPM drift limit).
+// No repeats: a cell may be used at most as many times as it holds tracks. If
+// the best DP path overuses a cell, the planner branches: each child bans that
+// cell at ONE of the steps that used it, and children are explored best score
+// first. Bans only lower the DP score, so the first conflict-free path popped is
+// optimal. Most plans need no branching at all; maxRepairs caps the search.
+struct EnergyPlanOptions
+{
+    int maxBpmStep = 6;          // max BPM change between consecutive tracks
+    int minBpm = BPM_MIN;        // every planned track stays inside [minBpm, maxBpm]
+    int maxBpm = BPM_MAX;
+    TrackId start;               // optional: fixed first track (invalid = planner picks)
+    TransitionWeights weights;
+    int maxRepairs = 256;        // DP re-runs allowed to remove repeats
+};
+
+enum PlanStatus
+{
+    PLAN_FOUND,             // repeat-free plan (if maxRepairs ran out first, the
+                            // best one already solved, which may not be optimal)
+    PLAN_INFEASIBLE,        // no plan satisfies the constraints
+    PLAN_BUDGET_EXHAUSTED   // maxRepairs ran out and no solved branch was repeat-free
+};
+
+struct EnergyPlan
+{
+    vector<TrackId> tracks; // empty unless status == PLAN_FOUND
+    double score = 0.0;
+    int repairs = 0;        // DP re-runs needed to remove repeats
+    PlanStatus status = PLAN_INFEASIBLE;
+};
+
+class EnergyArcPlanner
+{
+private:
+    static const int KEY_SLOTS = HARMONIC_KEYS + 1; // last slot = unknown key
+    static const int CELLS = BPM_BUCKETS * KEY_SLOTS;
+
+    const TrackManager& library;
+
+    static int cellOf(int bpm, int keySlot) { return (bpm - BPM_MIN) * KEY_SLOTS + keySlot; }
+    static int bpmOfCell(int cell) { return BPM_MIN + cell / KEY_SLOTS; }
+    static int keyOfCell(int cell) { return cell % KEY_SLOTS; }
+
+    // Everything one DP run needs (built once per plan() call).
+    struct Problem
+    {
+        vector<EnergyLevel> curve;
+        vector<vector<int>> rows; // (energy - 1) * CELLS + cell -> library rows
+        int startRow = -1;
+        int startCell = -1;
+        int startEnergy = 0;
+        int lo = BPM_MIN, hi = BPM_MAX, maxStep = 0;
+        double bpmWeight = 1.0;
+        int maxJump = 1;
+        double keyTerm[KEY_SLOTS][KEY_SLOTS];
+        vector<double> energyPart; // per step t >= 1
+
+        const vector<int>& cellRows(int t, int cell) const { return rows[(curve[t] - 1) * CELLS + cell]; }
+    };
+
+    typedef vector<pair<int, int>> BanList; // (step, cell)
+
+    // Best path under 'bans'; returns false if none exists.
+    static bool runDp(const Problem& pr, const BanList& bans, vector<int>& cells, double& score)
+    {
+        const int L = static_cast<int>(pr.curve.size());
+        const double NONE = -1e300;
+        vector<vector<uint8_t>> banned(L);
+        for (const pair<int, int>& ban : bans)
+        {
+            if (banned[ban.first].empty())
+                banned[ban.first].assign(CELLS, 0);
+            banned[ban.first][ban.second] = 1;
+        }
+        auto isBanned = [&banned](int t, int c) { return !banned[t].empty() && banned[t][c]; };
+
+        vector<vector<int>> back(L, vector<int>(CELLS, -1));
+        vector<double> prev(CELLS), cur(CELLS);
+        for (int c = 0; c < CELLS; c++)
+        {
+            bool ok = (pr.startCell != -1) ? (c == pr.startCell) : (!pr.cellRows(0, c).empty() && !isBanned(0, c));
+            prev[c] = ok ? 0.0 : NONE;
+        }
+
+        for (int t = 1; t < L; t++)
+        {
+            for (int c = 0; c < CELLS; c++)
+            {
+                cur[c] = NONE;
+                if (pr.cellRows(t, c).empty() || isBanned(t, c))
+                    continue;
+
+                int b = bpmOfCell(c), k = keyOfCell(c);
+                int bFirst = (b - pr.maxStep < pr.lo) ? pr.lo : b - pr.maxStep;
+                int bLast = (b + pr.maxStep > pr.hi) ? pr.hi : b + pr.maxStep;
+                for (int pb = bFirst; pb <= bLast; pb++)
+                {
+                    double bpmPart = -pr.bpmWeight * absValue(b - pb) / pr.maxJump;
+                    int base = cellOf(pb, 0);
+                    for (int pk = 0; pk < KEY_SLOTS; pk++)
+                    {
+                        double v = prev[base + pk];
+                        if (v == NONE)
+                            continue;
+                        v += bpmPart + pr.keyTerm[pk][k] + pr.energyPart[t];
+                        if (v > cur[c])
+                        {
+                            cur[c] = v;
+                            back[t][c] = base + pk;
+                        }
+                    }
+                }
+            }
+            prev.swap(cur);
+        }
+
+        int bestCell = -1;
+        for (int c = 0; c < CELLS; c++)
+            if (prev[c] != NONE && (bestCell == -1 || prev[c] > prev[bestCell]))
+                bestCell = c;
+        if (bestCell == -1)
+            return false;
+
+        cells.assign(L, -1);
+        cells[L - 1] = bestCell;
+        for (int t = L - 1; t > 0; t--)
+            cells[t - 1] = back[t][cells[t]];
+        score = prev[bestCell];
+        return true;
+    }
+
+public:
+    EnergyArcPlanner(const TrackManager& lib) : library(lib) {}
+
+    // Throws DJException for an empty curve, a level outside LOW..HIGH or a
+    // stale start id. A start track
+    // outside [minBpm, maxBpm] or whose energy is not curve[0] is infeasible.
+    EnergyPlan plan(const vector<EnergyLevel>& curve, const EnergyPlanOptions& options = EnergyPlanOptions()) const
+    {
+        const int L = static_cast<int>(curve.size());
+        if (L == 0)
+            throw DJException("EnergyArcPlanner::plan empty energy curve");
+        for (EnergyLevel level : curve)
+            if (level < LOW || level > HIGH)
+                throw DJException("EnergyArcPlanner::plan energy level outside LOW..HIGH");
+
+        Problem pr;
+        pr.curve = curve;
+        if (options.start.isValid())
+        {
+            pr.startRow = library.indexOf(options.start);
+            if (pr.startRow == -1)
+                throw DJException("EnergyArcPlanner::plan stale or invalid start TrackId");
+        }
+
+        const TrackStore& store = library.getStore();
+        const vector<uint16_t>& bpms = store.bpmColumn();
+        const vector<uint16_t>& energies = store.energyColumn();
+        const vector<uint8_t>& keys = store.harmonicKeyColumn();
+        pr.lo = (options.minBpm < BPM_MIN) ? BPM_MIN : options.minBpm;
+        pr.hi = (options.maxBpm > BPM_MAX) ? BPM_MAX : options.maxBpm;
+        pr.maxStep = (options.maxBpmStep < 0) ? 0 : options.maxBpmStep;
+
+        // Rows of every (energy, cell), in dense order. The start row is kept out.
+        pr.rows.assign(3 * CELLS, vector<int>());
+        auto slotOfRow = [&](int r) { return (keys[r] == NO_KEY_PACKED) ? HARMONIC_KEYS : static_cast<int>(keys[r]); };
+        for (int r = 0; r < store.getSize(); r++)
+        {
+            int e = energies[r];
+            if (e < LOW || e > HIGH || bpms[r] < pr.lo || bpms[r] > pr.hi || r == pr.startRow)
+                continue;
+            pr.rows[(e - 1) * CELLS + cellOf(bpms[r], slotOfRow(r))].push_back(r);
+        }
+        if (pr.startRow != -1)
+        {
+            if (bpms[pr.startRow] < pr.lo || bpms[pr.startRow] > pr.hi || energies[pr.startRow] != curve[0])
+                return EnergyPlan();
+            pr.startCell = cellOf(bpms[pr.startRow], slotOfRow(pr.startRow));
+            pr.startEnergy = energies[pr.startRow];
+        }
+
+        // Split the transition score into parts that each depend on one thing.
+        TransitionScorer scorer(options.weights, pr.maxStep);
+        pr.bpmWeight = options.weights.bpm;
+        pr.maxJump = scorer.getMaxBpmJump();
+        for (int a = 0; a < KEY_SLOTS; a++)
+            for (int b = 0; b < KEY_SLOTS; b++)
+                pr.keyTerm[a][b] = scorer.scoreValues(0, a, 0, 0, b, 0, 0.0); // bpm/energy terms are 0
+        pr.energyPart.assign(L, 0.0);
+        for (int t = 1; t < L; t++)
+        {
+            int fromEnergy = (t == 1 && pr.startRow != -1) ? pr.startEnergy : static_cast<int>(curve[t - 1]);
+            pr.energyPart[t] = scorer.scoreValues(0, NO_KEY, fromEnergy, 0, NO_KEY, curve[t], curve[t])
+                               - pr.keyTerm[HARMONIC_KEYS][HARMONIC_KEYS];
+        }
+
+        // Best-first over ban lists: (DP score, ban list).
+        struct Branch
+        {
+            double score;
+            BanList bans;
+            vector<int> cells;
+            long long order;
+        };
+        auto lower = [](const Branch& x, const Branch& y) {
+            return x.score < y.score || (x.score == y.score && x.order > y.order);
+        };
+        vector<Branch> open;
+        long long created = 0;
+
+        Branch root;
+        root.order = created++;
+        if (!runDp(pr, root.bans, root.cells, root.score))
+            return EnergyPlan();
+        open.push_back(root);
+
+        int runs = 1;
+        bool budgetSpent = false;
+        while (!open.empty())
+        {
+            pop_heap(open.begin(), open.end(), lower);
+            Branch node = move(open.back());
+            open.pop_back();
+
+            // Assign real tracks; find the first overused cell.
+            vector<int> used(3 * CELLS, 0);
+            int conflictStep = -1;
+            for (int t = (pr.startRow != -1) ? 1 : 0; t < L && conflictStep == -1; t++)
+            {
+                int bucket = (curve[t] - 1) * CELLS + node.cells[t];
+                if (++used[bucket] > static_cast<int>(pr.rows[bucket].size()))
+                    conflictStep = t;
+            }
+
+            if (conflictStep == -1)
+            {
+                EnergyPlan result;
+                vector<int> next(3 * CELLS, 0);
+                for (int t = 0; t < L; t++)
+                {
+                    if (t == 0 && pr.startRow != -1)
+                    {
+                        result.tracks.push_back(store.idAt(pr.startRow));
+                        continue;
+                    }
+                    int bucket = (curve[t] - 1) * CELLS + node.cells[t];
+                    result.tracks.push_back(store.idAt(pr.rows[bucket][next[bucket]++]));
+                }
+                result.score = node.score;
+                result.repairs = runs - 1;
+                result.status = PLAN_FOUND;
+                return result;
+            }
+
+            // Out of DP runs: no new children, but the branches already solved
+            // only need the conflict scan above, so keep popping them.
+            if (budgetSpent)
+                continue;
+
+            // One child per step that used the overfull cell: ban it there.
+            int cell = node.cells[conflictStep];
+            for (int t = 0; t <= conflictStep; t++)
+            {
+                if (node.cells[t] != cell || curve[t] != curve[conflictStep] || (t == 0 && pr.startRow != -1))
+                    continue;
+                if (runs >= 1 + options.maxRepairs)
+                {
+                    budgetSpent = true;
+                    break;
+                }
+                Branch child;
+                child.bans = node.bans;
+                child.bans.push_back(make_pair(t, cell));
+                child.order = created++;
+                runs++;
+                if (runDp(pr, child.bans, child.cells, child.score))
+                {
+                    open.push_back(move(child));
+                    push_heap(open.begin(), open.end(), lower);
+                }
+            }
+        }
+        EnergyPlan none; // every branch infeasible, or the budget cut the search short
+        none.repairs = runs - 1;
+        none.status = budgetSpent ? PLAN_BUDGET_EXHAUSTED : PLAN_INFEASIBLE;
+        return none;
+    }
+};
+
+// -------------------- Library Engine: CSV/TSV Bulk Import --------------------
+// Loads a spreadsheet export in one go instead of one prompt per field:
+//   1. the file is memory-mapped; its header row names the columns (title,
+//      artist, genre, key, bpm, energy, notes, path, platform; any order, other
+//      columns ignored; title and bpm are required)
+//   2. the body is cut into chunks on line boundaries and the chunks are parsed
+//      on the WorkStealingPool. Fields stay string_views into the mapping (only
+//      quoted fields with "" escapes are copied). Rows are checked with the
+//      prompt rules: BPM_MIN..BPM_MAX, energy 1-3 or Low/Medium/High
+//   3. accepted rows are added in file order on the calling thread, because
+//      TrackManager and the symbol table are not thread-safe
+// Chunks go through in waves of a few per worker, so memory stays bounded
+// however large the file is. One record per line: a quoted field may hold the
+// delimiter but not a line break. A row with a platform becomes a StreamTrack,
+// any other row a LocalTrack (with its path).
+enum ImportColumn
+{
+    IMPORT_TITLE = 0,
+    IMPORT_ARTIST,
+    IMPORT_GENRE,
+    IMPORT_KEY,
+    IMPORT_BPM,
+    IMPORT_ENERGY,
+    IMPORT_NOTES,
+    IMPORT_PATH,
+    IMPORT_PLATFORM,
+    IMPORT_COLUMNS
+};
+
+struct ImportOptions
+{
+    char delimiter = 0;             // 0 = tab if the header has one, else ','
+    size_t chunkBytes = 1 << 20;    // parse work per pool task
+    size_t maxRejectedKept = 1000;  // rejected rows listed in the report (all are counted)
+};
+
+struct ImportRejection
+{
+    int line = 0;     // 1-based line in the file (the header is line 1)
+    string reason;
+    string text;      // the row as it was (cut to IMPORT_TEXT_KEPT chars)
+};
+
+const size_t IMPORT_TEXT_KEPT = 80;
+
+struct ImportReport
+{
+    int rows = 0;          // data rows seen (blank lines are skipped)
+    int imported = 0;
+    int rejectedCount = 0;
+    vector<ImportRejection> rejected; // line order, at most maxRejectedKept
+
+    void writeTo(ostream& out) const
+    {
+        out << "Imported " << imported << " of " << rows << " row(s), " << rejectedCount << " rejected\n";
+        for (const ImportRejection& r : rejected)
+            out << "  line " << r.line << ": " << r.reason << "  |  " << r.text << "\n";
+        if (static_cast<int>(rejected.size()) < rejectedCount)
+            out << "  ... " << (rejectedCount - static_cast<int>(rejected.size())) << " more not listed\n";
+    }
+};
+
+// Import BPM text: whole or decimal (rounded), checked against BPM_MIN..BPM_MAX
+// like the prompts. Shared by the CSV and XML importers.
+inline bool parseImportBpm(string_view v, int& bpm, string& reason)
+{
+    long long whole = 0;
+    size_t i = 0;
+    while (i < v.size() && isdigit(static_cast<unsigned char>(v[i])) && whole < 100000)
+        whole = whole * 10 + (v[i++] - '0');
+    bool hasDigits = i > 0;
+    bool roundUp = false;
+    if (i < v.size() && v[i] == '.')
+    {
+        i++;
+        if (i < v.size() && isdigit(static_cast<unsigned char>(v[i])))
+        {
+            hasDigits = true;
+            roundUp = v[i] >= '5';
+        }
+        while (i < v.size() && isdigit(static_cast<unsigned char>(v[i])))
+            i++;
+    }
+    if (!hasDigits || i != v.size())
+    {
+        reason = "BPM is not a number: '" + string(v) + "'";
+        return false;
+    }
+    if (roundUp) whole++;
+    if (whole < BPM_MIN || whole > BPM_MAX)
+    {
+        reason = "BPM " + to_string(whole) + " is outside " + to_string(BPM_MIN) + "-" + to_string(BPM_MAX);
+        return false;
+    }
+    bpm = static_cast<int>(whole);
+    return true;
+}
+
+class TrackImporter
+{
+private:
+    struct Row
+    {
+        string_view field[IMPORT_COLUMNS];
+        int bpm;
+        EnergyLevel energy;
+    };
+
+    // Parse output of one chunk (filled by a pool task, read by the caller).
+    struct Chunk
+    {
+        string_view text;
+        int lines = 0;                 // lines in the chunk, blank ones included
+        int dataRows = 0;
+        vector<Row> rows;
+        vector<ImportRejection> rejected; // line = line inside the chunk (1-based)
+        int rejectedCount = 0;
+        deque<string> unescaped;       // storage for quoted fields with "" escapes
+    };
+
+    TrackManager& library;
+    WorkStealingPool& pool;
+
+    static string_view trim(string_view v)
+    {
+        size_t b = 0;
+        size_t e = v.size();
+        while (b < e && (v[b] == ' ' || v[b] == '\t')) b++;
+        while (e > b && (v[e - 1] == ' ' || v[e - 1] == '\t')) e--;
+        return v.substr(b, e - b);
+    }
+
+    static bool equalsNoCase(string_view a, const char* b)
+    {
+        size_t n = strlen(b);
+        if (a.size() != n) return false;
+        for (size_t i = 0; i < n; i++)
+            if (tolower(static_cast<unsigned char>(a[i])) != b[i]) return false;
+        return true;
+    }
+
+    // Splits one line into fields. Returns false for a broken quote.
+    static bool splitLine(string_view line, char delim, vector<string_view>& fields, deque<string>& unescaped)
+    {
+        fields.clear();
+        size_t i = 0;
+        while (true)
+        {
+            if (i < line.size() && line[i] == '"')
+            {
+                size_t j = i + 1;
+                bool escaped = false;
+                size_t close = string_view::npos;
+                while (close == string_view::npos)
+                {
+                    size_t q = line.find('"', j);
+                    if (q == string_view::npos)
+                        return false; // unterminated
+                    if (q + 1 < line.size() && line[q + 1] == '"')
+                    {
+                        escaped = true;
+                        j = q + 2;
+                    }
+                    else
+                        close = q;
+                }
+
+                string_view raw = line.substr(i + 1, close - i - 1);
+                if (escaped)
+                {
+                    string text;
+                    text.reserve(raw.size());
+                    for (size_t k = 0; k < raw.size(); k++)
+                    {
+                        text.push_back(raw[k]);
+                        if (raw[k] == '"') k++; // "" -> "
+                    }
+                    unescaped.push_back(move(text));
+                    fields.push_back(unescaped.back());
+                }
+                else
+                    fields.push_back(raw);
+
+                i = close + 1;
+                if (i == line.size())
+                    return true;
+                if (line[i] != delim)
+                    return false; // text after the closing quote
+                i++;
+            }
+            else
+            {
+                size_t d = line.find(delim, i);
+                if (d == string_view::npos)
+                {
+                    fields.push_back(trim(line.substr(i)));
+                    return true;
+                }
+                fields.push_back(trim(line.substr(i, d - i)));
+                i = d + 1;
+            }
+        }
+    }
+
+    // 1-3 (the menu numbers) or Low/Medium/High; empty = MEDIUM.
+    static bool parseEnergy(string_view v, EnergyLevel& e, string& reason)
+    {
+        if (v.empty() || v == "2" || equalsNoCase(v, "medium") || equalsNoCase(v, "med")) { e = MEDIUM; return true; }
+        if (v == "1" || equalsNoCase(v, "low")) { e = LOW; return true; }
+        if (v == "3" || equalsNoCase(v, "high")) { e = HIGH; return true; }
+        reason = "unknown energy '" + string(v) + "' (use 1-3 or Low/Medium/High)";
+        return false;
+    }
+
+    static void reject(Chunk& c, size_t maxKept, int line, const string& reason, string_view text)
+    {
+        c.rejectedCount++;
+        if (c.rejected.size() < maxKept)
+            c.rejected.push_back({ line, reason, string(text.substr(0, IMPORT_TEXT_KEPT)) });
+    }
+
+    static void parseChunk(Chunk& c, char delim, const int (&columnOf)[IMPORT_COLUMNS], int fieldCount, size_t maxKept)
+    {
+        vector<string_view> fields;
+        string reason;
+        size_t pos = 0;
+        while (pos < c.text.size())
+        {
+            size_t nl = c.text.find('\n', pos);
+            size_t end = (nl == string_view::npos) ? c.text.size() : nl;
+            string_view line = c.text.substr(pos, end - pos);
+            pos = end + 1;
+            c.lines++;
+            if (!line.empty() && line.back() == '\r')
+                line.remove_suffix(1);
+            if (trim(line).empty())
+                continue;
+            c.dataRows++;
+
+            if (!splitLine(line, delim, fields, c.unescaped))
+            {
+                reject(c, maxKept, c.lines, "broken quotes", line);
+                continue;
+            }
+            if (static_cast<int>(fields.size()) != fieldCount)
+            {
+                reject(c, maxKept, c.lines, "expected " + to_string(fieldCount) + " fields, found " + to_string(fields.size()), line);
+                continue;
+            }
+
+            Row row;
+            for (int col = 0; col < IMPORT_COLUMNS; col++)
+                row.field[col] = (columnOf[col] >= 0) ? fields[columnOf[col]] : string_view();
+            if (row.field[IMPORT_TITLE].empty())
+            {
+                reject(c, maxKept, c.lines, "missing title", line);
+                continue;
+            }
+            if (!parseImportBpm(row.field[IMPORT_BPM], row.bpm, reason) || !parseEnergy(row.field[IMPORT_ENERGY], row.energy, reason))
+            {
+                reject(c, maxKept, c.lines, reason, line);
+                continue;
+            }
+            c.rows.push_back(row);
+        }
+    }
+
+    static int columnFor(string_view name)
+    {
+        static const struct { const char* name; ImportColumn column; } NAMES[] = {
+            { "title", IMPORT_TITLE }, { "name", IMPORT_TITLE }, { "track", IMPORT_TITLE },
+            { "artist", IMPORT_ARTIST },
+            { "genre", IMPORT_GENRE },
+            { "key", IMPORT_KEY }, { "tonality", IMPORT_KEY },
+            { "bpm", IMPORT_BPM }, { "tempo", IMPORT_BPM },
+            { "energy", IMPORT_ENERGY },
+            { "notes", IMPORT_NOTES }, { "comment", IMPORT_NOTES }, { "comments", IMPORT_NOTES },
+            { "path", IMPORT_PATH }, { "file", IMPORT_PATH }, { "location", IMPORT_PATH },
+            { "platform", IMPORT_PLATFORM },
+        };
+        for (const auto& n : NAMES)
+            if (equalsNoCase(name, n.name))
+                return n.column;
+        return -1;
+    }
+
+public:
+    TrackImporter(TrackManager& lib, WorkStealingPool& workers) : library(lib), pool(workers) {}
+
+    // Imports delimited text (the header row first). Throws DJException when
+    // the header lacks a title or bpm column; bad data rows are only reported.
+    ImportReport importText(string_view text, const ImportOptions& options = ImportOptions())
+    {
+        if (text.size() >= 3 && text.substr(0, 3) == "\xEF\xBB\xBF")
+            text.remove_prefix(3); // UTF-8 byte order mark
+
+        size_t headerEnd = text.find('\n');
+        string_view header = text.substr(0, headerEnd);
+        if (!header.empty() && header.back() == '\r')
+            header.remove_suffix(1);
+        string_view body = (headerEnd == string_view::npos) ? string_view() : text.substr(headerEnd + 1);
+
+        char delim = options.delimiter;
+        if (delim == 0)
+            delim = (header.find('\t') != string_view::npos) ? '\t' : ',';
+
+        vector<string_view> names;
+        deque<string> headerStorage;
+        if (!splitLine(header, delim, names, headerStorage))
+            throw DJException("Import: broken quotes in the header row");
+        int columnOf[IMPORT_COLUMNS];
+        for (int col = 0; col < IMPORT_COLUMNS; col++)
+            columnOf[col] = -1;
+        for (size_t i = 0; i < names.size(); i++)
+        {
+            int col = columnFor(names[i]);
+            if (col >= 0 && columnOf[col] < 0)
+                columnOf[col] = static_cast<int>(i);
+        }
+        if (columnOf[IMPORT_TITLE] < 0 || columnOf[IMPORT_BPM] < 0)
+            throw DJException("Import: the header needs 'title' and 'bpm' columns");
+        int fieldCount = static_cast<int>(names.size());
+
+        ImportReport report;
+        size_t chunkBytes = options.chunkBytes < 64 ? 64 : options.chunkBytes;
+        size_t wave = static_cast<size_t>(pool.getThreadCount()) * 4;
+        int lineBase = 1; // the header
+        size_t pos = 0;
+        vector<Chunk> chunks;
+
+        while (pos < body.size())
+        {
+            // next wave of line-aligned chunks
+            chunks.clear();
+            chunks.resize(wave);
+            size_t used = 0;
+            while (used < wave && pos < body.size())
+            {
+                size_t end = pos + chunkBytes;
+                if (end >= body.size())
+                    end = body.size();
+                else
+                {
+                    size_t nl = body.find('\n', end);
+                    end = (nl == string_view::npos) ? body.size() : nl + 1;
+                }
+                chunks[used++].text = body.substr(pos, end - pos);
+                pos = end;
+            }
+
+            for (size_t i = 0; i < used; i++)
+            {
+                Chunk* c = &chunks[i];
+                pool.submit([c, delim, &columnOf, fieldCount, &options]() {
+                    parseChunk(*c, delim, columnOf, fieldCount, options.maxRejectedKept);
+                });
+            }
+            pool.wait();
+
+            // add in file order on this thread
+            for (size_t i = 0; i < used; i++)
+            {
+                Chunk& c = chunks[i];
+                for (const Row& row : c.rows)
+                {
+                    Track t;
+                    t.title = string(row.field[IMPORT_TITLE]);
+                    t.artist = Symbol(string(row.field[IMPORT_ARTIST]));
+                    t.genre = Symbol(string(row.field[IMPORT_GENRE]));
+                    t.key = Symbol(string(row.field[IMPORT_KEY]));
+                    t.bpm = row.bpm;
+                    t.energy = row.energy;
+                    t.notes = string(row.field[IMPORT_NOTES]);
+                    if (!row.field[IMPORT_PLATFORM].empty())
+                        library.addTrackRecord(t, TAG_STREAM, string(row.field[IMPORT_PLATFORM]));
+                    else
+                        library.addTrackRecord(t, TAG_LOCAL, string(row.field[IMPORT_PATH]));
+                }
+                report.rows += c.dataRows;
+                report.imported += static_cast<int>(c.rows.size());
+                report.rejectedCount += c.rejectedCount;
+                for (ImportRejection& r : c.rejected)
+                {
+                    if (report.rejected.size() >= options.maxRejectedKept)
+                        break;
+                    r.line += lineBase;
+                    report.rejected.push_back(move(r));
+                }
+                lineBase += c.lines;
+            }
+        }
+        return report;
+    }
+
+    // Maps the file and imports it (see importText). Throws DJException if
+    // the file cannot be opened or has no usable header.
+    ImportReport importFile(const string& path, const ImportOptions& options = ImportOptions())
+    {
+        MappedFile file(path);
+        return importText(string_view(file.data() ? file.data() : "", file.size()), options);
+    }
+};
+
+// -------------------- Library Engine: DJ Software XML Import --------------------
+// Rekordbox and Traktor collections are XML exports of hundreds of MB, so they
+// are read with a pull parser instead of a DOM: a fixed 64 KB buffer is
+// refilled from the file, and only the tag being looked at is kept (one
+// element may grow the buffer, up to XML_MAX_TAG). Text content, comments,
+// CDATA, DOCTYPE and processing instructions are skipped: both formats keep
+// everything in attributes.
+class XmlPullReader
+{
+public:
+    enum Event { XML_START, XML_END, XML_DONE };
+
+private:
+    static const size_t XML_BUFFER = 1 << 16;
+    static const size_t XML_MAX_TAG = 16 << 20;
+    static const size_t NOT_FOUND = static_cast<size_t>(-1);
+
+    FILE* in;
+    vector<char> buf;
+    size_t pos = 0;     // next unread byte
+    size_t filled = 0;  // valid bytes in buf
+    bool atEof = false;
+    int line = 1;       // line at pos
+    int tagLine = 1;
+    string_view tagName;
+    bool selfClosing = false;
+    vector<pair<string_view, string_view>> attrs; // name, raw value
+
+    // Makes 'need' bytes available from pos (compacts, grows, reads).
+    // Returns false if the input ends first.
+    bool fill(size_t need)
+    {
+        while (filled - pos < need)
+        {
+            if (atEof)
+                return false;
+            if (pos > 0)
+            {
+                memmove(buf.data(), buf.data() + pos, filled - pos);
+                filled -= pos;
+                pos = 0;
+            }
+            if (filled == buf.size())
+            {
+                if (buf.size() >= XML_MAX_TAG)
+                    throw DJException("XML: element at line " + to_string(line) + " is too long");
+                buf.resize(buf.size() * 2);
+            }
+            size_t got = fread(buf.data() + filled, 1, buf.size() - filled, in);
+            if (got == 0)
+            {
+                if (ferror(in))
+                    throw DJException("XML: read error");
+                atEof = true;
+            }
+            filled += got;
+        }
+        return true;
+    }
+
+    void advance(size_t n)
+    {
+        line += static_cast<int>(count(buf.data() + pos, buf.data() + pos + n, '\n'));
+        pos += n;
+    }
+
+    // Offset (from pos) of the first c at or after 'from'; NOT_FOUND at the end.
+    size_t findChar(char c, size_t from)
+    {
+        while (true)
+        {
+            if (pos + from < filled)
+            {
+                const void* hit = memchr(buf.data() + pos + from, c, filled - pos - from);
+                if (hit)
+                    return static_cast<size_t>(static_cast<const char*>(hit) - (buf.data() + pos));
+            }
+            from = filled - pos;
+            if (!fill(from + 1))
+                return NOT_FOUND;
+        }
+    }
+
+    void skipPast(const char* terminator, size_t from)
+    {
+        size_t len = strlen(terminator);
+        while (true)
+        {
+            size_t at = findChar(terminator[0], from);
+            if (at == NOT_FOUND || !fill(at + len))
+                throw DJException("XML: unterminated markup from line " + to_string(line));
+            if (memcmp(buf.data() + pos + at, terminator, len) == 0)
+            {
+                advance(at + len);
+                return;
+            }
+            from = at + 1;
+        }
+    }
+
+    // Offset of the '>' closing the tag at pos ('>' inside quotes is text).
+    size_t findTagEnd()
+    {
+        char quote = 0;
+        for (size_t i = 1;; i++)
+        {
+            if (pos + i >= filled && !fill(i + 1))
+                return NOT_FOUND;
+            char c = buf[pos + i];
+            if (quote)
+            {
+                if (c == quote) quote = 0;
+            }
+            else if (c == '"' || c == '\'')
+                quote = c;
+            else if (c == '>')
+                return i;
+        }
+    }
+
+    static bool isSpace(char c) { return c == ' ' || c == '\t' || c == '\r' || c == '\n'; }
+
+    void parseAttributes(string_view text)
+    {
+        attrs.clear();
+        size_t i = 0;
+        while (true)
+        {
+            while (i < text.size() && isSpace(text[i])) i++;
+            if (i >= text.size())
+                return;
+            size_t nameStart = i;
+            while (i < text.size() && text[i] != '=' && !isSpace(text[i])) i++;
+            string_view name = text.substr(nameStart, i - nameStart);
+            while (i < text.size() && isSpace(text[i])) i++;
+            if (i >= text.size() || text[i] != '=')
+                throw DJException("XML: attribute without a value at line " + to_string(tagLine));
+            i++;
+            while (i < text.size() && isSpace(text[i])) i++;
+            if (i >= text.size() || (text[i] != '"' && text[i] != '\''))
+                throw DJException("XML: unquoted attribute at line " + to_string(tagLine));
+            char quote = text[i++];
+            size_t end = text.find(quote, i);
+            if (end == string_view::npos)
+                throw DJException("XML: unterminated attribute at line " + to_string(tagLine));
+            attrs.push_back({ name, text.substr(i, end - i) });
+            i = end + 1;
+        }
+    }
+
+    static void decodeEntities(string_view raw, string& out)
+    {
+        out.clear();
+        size_t amp = raw.find('&');
+        if (amp == string_view::npos)
+        {
+            out.assign(raw.data(), raw.size());
+            return;
+        }
+        out.reserve(raw.size());
+        size_t i = 0;
+        while (i < raw.size())
+        {
+            if (raw[i] != '&')
+            {
+                out.push_back(raw[i++]);
+                continue;
+            }
+            size_t semi = raw.find(';', i);
+            if (semi == string_view::npos)
+            {
+                out.append(raw.data() + i, raw.size() - i);
+                return;
+            }
+            string_view entity = raw.substr(i + 1, semi - i - 1);
+            if (entity == "amp") out.push_back('&');
+            else if (entity == "lt") out.push_back('<');
+            else if (entity == "gt") out.push_back('>');
+            else if (entity == "quot") out.push_back('"');
+            else if (entity == "apos") out.push_back('\'');
+            else if (entity.size() > 1 && entity[0] == '#')
+            {
+                bool hex = entity[1] == 'x' || entity[1] == 'X';
+                unsigned long code = strtoul(string(entity.substr(hex ? 2 : 1)).c_str(), nullptr, hex ? 16 : 10);
+                // UTF-8 encode
+                if (code < 0x80) out.push_back(static_cast<char>(code));
+                else if (code < 0x800)
+                {
+                    out.push_back(static_cast<char>(0xC0 | (code >> 6)));
+                    out.push_back(static_cast<char>(0x80 | (code & 0x3F)));
+                }
+                else if (code < 0x10000)
+                {
+                    out.push_back(static_cast<char>(0xE0 | (code >> 12)));
+                    out.push_back(static_cast<char>(0x80 | ((code >> 6) & 0x3F)));
+                    out.push_back(static_cast<char>(0x80 | (code & 0x3F)));
+                }
+                else
+                {
+                    out.push_back(static_cast<char>(0xF0 | (code >> 18)));
+                    out.push_back(static_cast<char>(0x80 | ((code >> 12) & 0x3F)));
+                    out.push_back(static_cast<char>(0x80 | ((code >> 6) & 0x3F)));
+                    out.push_back(static_cast<char>(0x80 | (code & 0x3F)));
+                }
+            }
+            else
+                out.append(raw.data() + i, semi + 1 - i); // unknown entity: kept as written
+            i = semi + 1;
+        }
+    }
+
+public:
+    explicit XmlPullReader(FILE* input) : in(input), buf(XML_BUFFER) {}
+
+    // Next element boundary. The name and attributes stay valid until the
+    // next call. A self-closing element gives XML_START only.
+    Event next()
+    {
+        while (true)
+        {
+            size_t lt = findChar('<', 0);
+            if (lt == NOT_FOUND)
+            {
+                advance(filled - pos);
+                return XML_DONE;
+            }
+            advance(lt); // text content
+
+            if (!fill(2))
+                throw DJException("XML: truncated at line " + to_string(line));
+            char kind = buf[pos + 1];
+            if (kind == '!')
+            {
+                if (fill(4) && memcmp(buf.data() + pos, "<!--", 4) == 0)
+                    skipPast("-->", 4);
+                else if (fill(9) && memcmp(buf.data() + pos, "<![CDATA[", 9) == 0)
+                    skipPast("]]>", 9);
+                else
+                    skipPast(">", 2); // DOCTYPE
+                continue;
+            }
+            if (kind == '?')
+            {
+                skipPast("?>", 2);
+                continue;
+            }
+
+            size_t gt = findTagEnd();
+            if (gt == NOT_FOUND)
+                throw DJException("XML: unterminated tag at line " + to_string(line));
+            tagLine = line;
+            string_view tag(buf.data() + pos + 1, gt - 1);
+            advance(gt + 1); // the bytes stay in buf until the next call
+
+            if (!tag.empty() && tag[0] == '/')
+            {
+                tag.remove_prefix(1);
+                while (!tag.empty() && isSpace(tag.back())) tag.remove_suffix(1);
+                tagName = tag;
+                attrs.clear();
+                return XML_END;
+            }
+
+            selfClosing = !tag.empty() && tag.back() == '/';
+            if (selfClosing)
+                tag.remove_suffix(1);
+            size_t nameEnd = 0;
+            while (nameEnd < tag.size() && !isSpace(tag[nameEnd])) nameEnd++;
+            tagName = tag.substr(0, nameEnd);
+            parseAttributes(tag.substr(nameEnd));
+            return XML_START;
+        }
+    }
+
+    string_view name() const { return tagName; }
+    bool isSelfClosing() const { return selfClosing; }
+    int lineNumber() const { return tagLine; }
+
+    // Decoded value of an attribute of the current start tag.
+    bool attribute(string_view key, string& out) const
+    {
+        for (const pair<string_view, string_view>& a : attrs)
+            if (a.first == key)
+            {
+                decodeEntities(a.second, out);
+                return true;
+            }
+        out.clear();
+        return false;
+    }
+};
+
+// Energy hints in DJ software: a star rating (0-5, 0 = unrated) or a colour.
+// Rating wins: 1-2 stars LOW, 3 MEDIUM, 4-5 HIGH. Otherwise the colour's hue:
+// red/orange/pink ("hot") HIGH, yellow/green MEDIUM, aqua/blue/purple LOW.
+// No hint at all: MEDIUM (the Track default).
+inline int colourEnergyHint(int rgb)
+{
+    if (rgb < 0)
+        return 0;
+    int r = (rgb >> 16) & 0xFF;
+    int g = (rgb >> 8) & 0xFF;
+    int b = rgb & 0xFF;
+    int hi = max(r, max(g, b));
+    int lo = min(r, min(g, b));
+    if (hi == lo)
+        return 0; // grey/white: no hint
+
+    double d = hi - lo;
+    double hue;
+    if (hi == r) hue = 60.0 * ((g - b) / d);
+    else if (hi == g) hue = 60.0 * ((b - r) / d + 2.0);
+    else hue = 60.0 * ((r - g) / d + 4.0);
+    if (hue < 0.0) hue += 360.0;
+
+    if (hue < 45.0 || hue >= 300.0) return HIGH;
+    if (hue < 150.0) return MEDIUM;
+    return LOW;
+}
+
+inline EnergyLevel energyFromTags(int stars, int rgb)
+{
+    if (stars >= 4) return HIGH;
+    if (stars == 3) return MEDIUM;
+    if (stars >= 1) return LOW;
+    int hint = colourEnergyHint(rgb);
+    return hint ? static_cast<EnergyLevel>(hint) : MEDIUM;
+}
+
+// 0-255 rating attribute (Rekordbox Rating, Traktor RANKING: 51 per star).
+inline int starsFromRating(const string& text)
+{
+    int rating = atoi(text.c_str());
+    if (rating <= 0) return 0;
+    return min(5, (rating + 25) / 51);
+}
+
+// Rekordbox Location URL: "file://localhost/C:/Music/A%20B.mp3" -> "C:/Music/A B.mp3"
+inline string fileUrlToPath(const string& url)
+{
+    size_t start = 0;
+    if (url.compare(0, 16, "file://localhost") == 0) start = 16;
+    else if (url.compare(0, 7, "file://") == 0) start = 7;
+
+    string path;
+    path.reserve(url.size() - start);
+    for (size_t i = start; i < url.size(); i++)
+    {
+        if (url[i] == '%' && i + 2 < url.size() && isxdigit(static_cast<unsigned char>(url[i + 1]))
+            && isxdigit(static_cast<unsigned char>(url[i + 2])))
+        {
+            path.push_back(static_cast<char>(strtol(url.substr(i + 1, 2).c_str(), nullptr, 16)));
+            i += 2;
+        }
+        else
+            path.push_back(url[i]);
+    }
+    if (path.size() >= 3 && path[0] == '/' && isalpha(static_cast<unsigned char>(path[1])) && path[2] == ':')
+        path.erase(0, 1); // "/C:/..." -> "C:/..."
+    return path;
+}
+
+// Traktor LOCATION: VOLUME="C:" DIR="/:Music/:House/:" FILE="a.mp3" -> "C:/Music/House/a.mp3".
+// A volume name that is not a drive letter (macOS "Macintosh HD") is not part of the path.
+inline string traktorPath(const string& volume, const string& dir, const string& file)
+{
+    string path;
+    if (!volume.empty() && volume.back() == ':')
+        path = volume;
+    for (size_t i = 0; i < dir.size(); i++)
+    {
+        if (dir[i] == '/' && i + 1 < dir.size() && dir[i + 1] == ':')
+        {
+            path.push_back('/');
+            i++;
+        }
+        else
+            path.push_back(dir[i]);
+    }
+    if (!path.empty() && path.back() != '/' && !file.empty())
+        path.push_back('/');
+    return path + file;
+}
+
+enum XmlLibraryFormat { XML_UNKNOWN = 0, XML_REKORDBOX, XML_TRAKTOR };
+
+// Maps collection entries onto LocalTracks (title, artist, genre, key, BPM,
+// comments as notes, file path) as they are read, so memory use does not grow
+// with the file. Rekordbox: <DJ_PLAYLISTS><COLLECTION><TRACK .../>; Traktor:
+// <NML><COLLECTION><ENTRY> with LOCATION/INFO/TEMPO/MUSICAL_KEY children.
+// Playlist references (TRACK/ENTRY outside COLLECTION) are ignored. Entries
+// without a usable BPM or title are rejected into the ImportReport.
+class XmlLibraryImporter
+{
+private:
+    struct Entry
+    {
+        string title, artist, genre, key, notes, path, bpm;
+        int stars = 0;
+        int rgb = -1;
+        int line = 0;
+
+        void clear()
+        {
+            title.clear(); artist.clear(); genre.clear(); key.clear();
+            notes.clear(); path.clear(); bpm.clear();
+            stars = 0;
+            rgb = -1;
+        }
+    };
+
+    TrackManager& library;
+    XmlLibraryFormat format = XML_UNKNOWN;
+
+    static int traktorColour(int index)
+    {
+        static const int RGB[8] = { -1, 0xFF0000, 0xFF8000, 0xFFFF00, 0x00FF00, 0x0000FF, 0x8000FF, 0xFF00FF };
+        return (index >= 1 && index <= 7) ? RGB[index] : -1;
+    }
+
+    void finish(const Entry& e, ImportReport& report, size_t maxKept)
+    {
+        report.rows++;
+        string reason;
+        int bpm = 0;
+        if (e.title.empty())
+            reason = "missing title";
+        else if (!parseImportBpm(e.bpm, bpm, reason))
+        {
+            if (e.bpm.empty())
+                reason = "no BPM (track not analyzed)";
+        }
+        if (!reason.empty())
+        {
+            report.rejectedCount++;
+            if (report.rejected.size() < maxKept)
+                report.rejected.push_back({ e.line, reason, e.title.substr(0, IMPORT_TEXT_KEPT) });
+            return;
+        }
+
+        Track t;
+        t.title = e.title;
+        t.artist = Symbol(e.artist);
+        t.genre = Symbol(e.genre);
+        t.key = Symbol(e.key);
+        t.bpm = bpm;
+        t.energy = energyFromTags(e.stars, e.rgb);
+        t.notes = e.notes;
+        library.addTrackRecord(t, TAG_LOCAL, e.path);
+        report.imported++;
+    }
+
+public:
+    explicit XmlLibraryImporter(TrackManager& lib) : library(lib) {}
+
+    XmlLibraryFormat getFormat() const { return format; }
+
+    // Throws DJException for unreadable/malformed XML, an unknown root
+    // element or a file that ends with elements still open (a cut-off
+    // export); tracks read before the error stay imported.
+    ImportReport importStream(FILE* in, const ImportOptions& options = ImportOptions())
+    {
+        XmlPullReader xml(in);
+        ImportReport report;
+        Entry entry;
+        string value;
+        int depth = 0;          // open elements around the current tag
+        bool inCollection = false;
+        bool inEntry = false;   // Traktor ENTRY being read
+        format = XML_UNKNOWN;
+
+        for (XmlPullReader::Event ev = xml.next(); ev != XmlPullReader::XML_DONE; ev = xml.next())
+        {
+            string_view name = xml.name();
+            if (ev == XmlPullReader::XML_END)
+            {
+                depth--;
+                if (depth == 1 && name == "COLLECTION")
+                    inCollection = false;
+                else if (inEntry && depth == 2 && name == "ENTRY")
+                {
+                    finish(entry, report, options.maxRejectedKept);
+                    inEntry = false;
+                }
+                continue;
+            }
+
+            if (depth == 0)
+            {
+                if (name == "DJ_PLAYLISTS") format = XML_REKORDBOX;
+                else if (name == "NML") format = XML_TRAKTOR;
+                else throw DJException("XML: unknown library format <" + string(name) + ">");
+            }
+            else if (depth == 1 && name == "COLLECTION")
+                inCollection = !xml.isSelfClosing();
+            else if (inCollection && depth == 2 && format == XML_REKORDBOX && name == "TRACK")
+            {
+                entry.clear();
+                entry.line = xml.lineNumber();
+                xml.attribute("Name", entry.title);
+                xml.attribute("Artist", entry.artist);
+                xml.attribute("Genre", entry.genre);
+                xml.attribute("Tonality", entry.key);
+                xml.attribute("Comments", entry.notes);
+                xml.attribute("AverageBpm", entry.bpm);
+                if (xml.attribute("Location", value))
+                    entry.path = fileUrlToPath(value);
+                if (xml.attribute("Rating", value))
+                    entry.stars = starsFromRating(value);
+                if (xml.attribute("Colour", value) && !value.empty())
+                    entry.rgb = static_cast<int>(strtol(value.c_str(), nullptr, 16));
+                finish(entry, report, options.maxRejectedKept);
+            }
+            else if (inCollection && depth == 2 && format == XML_TRAKTOR && name == "ENTRY")
+            {
+                entry.clear();
+                entry.line = xml.lineNumber();
+                xml.attribute("TITLE", entry.title);
+                xml.attribute("ARTIST", entry.artist);
+                inEntry = true;
+                if (xml.isSelfClosing())
+                {
+                    finish(entry, report, options.maxRejectedKept);
+                    inEntry = false;
+                }
+            }
+            else if (inEntry && depth == 3)
+            {
+                if (name == "LOCATION")
+                {
+                    string volume, dir, file;
+                    xml.attribute("VOLUME", volume);
+                    xml.attribute("DIR", dir);
+                    xml.attribute("FILE", file);
+                    entry.path = traktorPath(volume, dir, file);
+                }
+                else if (name == "INFO")
+                {
+                    xml.attribute("GENRE", entry.genre);
+                    xml.attribute("COMMENT", entry.notes);
+                    if (xml.attribute("KEY", value) && !value.empty())
+                        entry.key = value;
+                    if (xml.attribute("RANKING", value))
+                        entry.stars = starsFromRating(value);
+                    if (xml.attribute("COLOR", value))
+                        entry.rgb = traktorColour(atoi(value.c_str()));
+                }
+                else if (name == "TEMPO")
+                    xml.attribute("BPM", entry.bpm);
+                else if (name == "MUSICAL_KEY" && entry.key.empty() && xml.attribute("VALUE", value) && !value.empty())
+                {
+                    int v = atoi(value.c_str()); // 0-11 C..B major, 12-23 C..B minor
+                    if (v >= 0 && v < HARMONIC_KEYS)
+                        entry.key = keyToStandard(keyIdFromPitch(v % 12, v < 12));
+                }
+            }
+
+            if (!xml.isSelfClosing())
+                depth++;
+        }
+        if (format == XML_UNKNOWN)
+            throw DJException("XML: no library found");
+        if (depth > 0)
+            throw DJException("XML: truncated, " + to_string(depth) + " element(s) still open at the end of the file ("
+                + to_string(report.imported) + " track(s) imported before it)");
+        return report;
+    }
+
+    ImportReport importFile(const string& path, const ImportOptions& options = ImportOptions())
+    {
+        FILE* in = fopen(path.c_str(), "rb");
+        if (!in)
+            throw DJException("Cannot open " + path);
+        try
+        {
+            ImportReport report = importStream(in, options);
+            fclose(in);
+            return report;
+        }
+        catch (...)
+        {
+            fclose(in);
+            throw;
+        }
+    }
+};
+
+// -------------------- Library Engine: Log Recovery and Compaction --------------------
+struct RecoveryReport
+{
+    int snapshotTracks = 0;   // rows loaded from the snapshot
+    uint64_t snapshotLsn = 0;
+    int replayed = 0;         // log records applied on top
+    int skipped = 0;          // records the snapshot already covered
+    uint64_t lastLsn = 0;     // open the OperationLog after this
+    bool tornTail = false;    // the log ended in a torn/corrupt record
+};
+
+// Startup: loads the snapshot (if any) and replays the log records newer
+// than it, in LSN order. Call it on an empty library with no log attached.
+// Either file may be missing. Throws DJException if a file is unreadable
+// or a record does not fit the library.
+inline RecoveryReport recoverLibrary(TrackManager& library, const string& snapshotPath, const string& logPath)
+{
+    RecoveryReport report;
+    if (ifstream(snapshotPath))
+    {
+        SnapshotView view(snapshotPath);
+        report.snapshotTracks = library.loadSnapshot(view);
+        report.snapshotLsn = report.lastLsn = view.getLsn();
+    }
+    if (ifstream(logPath))
+    {
+        LogReader reader(logPath);
+        LogRecord r;
+        while (reader.next(r))
+        {
+            if (r.lsn <= report.snapshotLsn)
+            {
+                report.skipped++; // compaction stopped before the log was trimmed
+                continue;
+            }
+            library.applyLogRecord(r);
+            report.replayed++;
+            report.lastLsn = r.lsn;
+        }
+        report.tornTail = reader.isTorn();
+    }
+    return report;
+}
+
+// Folds the log into a new snapshot. start() copies the rows (on the calling
+// thread, the library is not thread-safe) and writes the snapshot on a
+// background thread while the library keeps changing and logging. finish()
+// (calling thread again) then drops the records the snapshot covers. A crash
+// at any point leaves a snapshot + log pair that recovers to the same state.
+class LogCompactor
+{
+private:
+    thread worker;
+    atomic<bool> done{ false };
+    bool running = false;
+    string error;
+    uint64_t lsn = 0;
+
+    LogCompactor(const LogCompactor&) = delete;
+    LogCompactor& operator=(const LogCompactor&) = delete;
+
+public:
+    LogCompactor() {}
+
+    ~LogCompactor()
+    {
+        if (worker.joinable())
+            worker.join();
+    }
+
+    bool isRunning() const { return running; }
+
+    // False if a compaction is already running.
+    bool start(const TrackManager& library, const OperationLog& log, const string& snapshotPath)
+    {
+        if (running)
+            return false;
+        SnapshotWriter writer;
+        library.fillSnapshot(writer);
+        lsn = log.getLastLsn();
+        error.clear();
+        done = false;
+        running = true;
+        uint64_t upTo = lsn;
+        worker = thread([this, rows = move(writer), snapshotPath, upTo]() {
+            try
+            {
+                rows.write(snapshotPath, upTo);
+            }
+            catch (const exception& ex)
+            {
+                error = ex.what();
+            }
+            done = true;
+        });
+        return true;
+    }
+
+    // Completes a finished compaction (or waits for it): trims the log to
+    // the records after the snapshot. Returns true if one completed. Throws
+    // DJException if writing the snapshot failed (the log is left whole).
+    bool finish(OperationLog& log, bool wait = false)
+    {
+        if (!running || (!wait && !done))
+            return false;
+        worker.join();
+        running = false;
+        if (!error.empty())
+            throw DJException("Compaction failed: " + error);
+        log.rewrite(lsn);
+        return true;
+    }
+
+    // Starts and finishes in one go (e.g. when quitting).
+    void compactNow(const TrackManager& library, OperationLog& log, const string& snapshotPath)
+    {
+        finish(log, true);
+        start(library, log, snapshotPath);
+        finish(log, true);
+    }
+};
+
+// -------------------- Main --------------------
+#if !defined(_DEBUG) && !defined(DJ_BENCHMARK)
+int main()
+{
+#ifdef _MSC_VER
+    // Ensure leak-check is enabled (also enabled via CrtLeakGuard above).
+    _CrtSetDbgFlag(_CRTDBG_ALLOC_MEM_DF | _CRTDBG_LEAK_CHECK_DF);
+#endif
+
+    // One library for every menu option (Weeks 1-4 and Week 5+)
+    TrackManager manager(2);
+
+    showBanner();
+
+    // Library engine: the library persists between sessions (binary snapshot
+    // + write-ahead log of every edit since, folded in by LogCompactor)
+    unique_ptr<OperationLog> libraryLog;
+    LogCompactor compactor;
+    try
+    {
+        RecoveryReport recovered = recoverLibrary(manager, LIBRARY_SNAPSHOT_FILE, LIBRARY_LOG_FILE);
+        if (manager.getSize() > 0 || recovered.replayed > 0)
+            cout << "Loaded " << manager.getSize() << " track(s) from " << LIBRARY_SNAPSHOT_FILE
+                 << " (+" << recovered.replayed << " logged change(s)).\n";
+        if (recovered.tornTail)
+            cout << "The last change before the previous exit was incomplete and was dropped.\n";
+        libraryLog.reset(new OperationLog(LIBRARY_LOG_FILE, recovered.lastLsn));
+        manager.attachLog(libraryLog.get());
+    }
+    catch (const exception& ex)
+    {
+        // keep the files as they are: saving a partial library would lose tracks
+        cout << "Could not load the saved library: " << ex.what()
+             << "\nThe library will not be saved this session.\n";
+    }
+
+    // 3+ mixed inputs: string (spaces), int, double (legacy)
+    string djName = getNonEmptyLine("Enter your DJ name: ");
+    int targetBPM = getValidatedInt("Enter target BPM for your set (60-200): ", BPM_MIN, BPM_MAX);
+    double prepHours = getValidatedDouble("How many hours can you prep today (0.0 - 12.0)? ", 0.0, 12.0);
+
+    // Compound if/else block #1 (rubric requirement)
+    if (prepHours >= 4.0 && prepHours <= 8.0)
+        cout << "\nNice. With " << prepHours << " hours, you can build a solid set.\n";
+    else if (prepHours < 4.0 && targetBPM >= 125)
+        cout << "\nShort prep time + high BPM target. Keep transitions simple.\n";
+    else
+        cout << "\nPlan smart: focus on clean BPM ranges and energy flow.\n";
+
+    // Compound if/else block #2 (rubric requirement)
+    if (targetBPM >= 128 && prepHours >= 5.0)
+        cout << "Recommendation: build an energy climb into a peak-hour section.\n";
+    else
+        cout << "Recommendation: keep a steady groove and avoid risky key jumps.\n";
+
+    // Fixed-count for loop (rubric requirement)
+    cout << "\nQuick Set-Prep Tips:\n";
+    const int TIP_COUNT = 3;
+    for (int i = 1; i <= TIP_COUNT; i++)
+    {
+        if (i == 1) cout << "  1) Group tracks by BPM buckets.\n";
+        if (i == 2) cout << "  2) Keep keys compatible when possible.\n";
+        if (i == 3) cout << "  3) Increase energy gradually.\n";
+    }
+
+    int choice = 0;
+    do
+    {
+        showMenu();
+        choice = getMenuChoice(MENU_MIN, MENU_MAX);
+
+        switch (choice)
+        {
+        case 1:
+            addTrack(manager);
+            break;
+        case 2:
+            printLibrary(manager);
+            break;
+        case 3:
+            recommendNextTracks(manager);
+            break;
+        case 4:
+            saveReportToFile(manager, "DJ_Set_Report.txt");
+            break;
+
+        case 5:
+        {
+            cout << "\n--- Add Local Track (Week 7) ---\n";
+            string t = getNonEmptyLine("Title: ");
+            int bpm = getValidatedInt("BPM (60-200): ", BPM_MIN, BPM_MAX);
+            EnergyLevel e = getEnergyFromUser();
+            string path = getNonEmptyLine("File path (ex: track.wav): ");
+            string noteText = getNonEmptyLine("Notes (mix notes): ");
+
+            manager.emplaceLocal(t, bpm, e, path, MixNotes(noteText));
+            cout << "Local track added (Week 7).\n";
+            break;
+        }
+        case 6:
+        {
+            cout << "\n--- Add Stream Track (Week 7) ---\n";
+            string t = getNonEmptyLine("Title: ");
+            int bpm = getValidatedInt("BPM (60-200): ", BPM_MIN, BPM_MAX);
+            EnergyLevel e = getEnergyFromUser();
+            string platform = getNonEmptyLine("Platform (ex: Spotify): ");
+            string noteText = getNonEmptyLine("Notes (mix notes): ");
+
+            manager.emplaceStream(t, bpm, e, platform, MixNotes(noteText));
+            cout << "Stream track added (Week 7).\n";
+            break;
+        }
+        case 7:
+            cout << "\n==================== WEEK 7 LIBRARY ====================\n";
+            manager.printAll(cout);
+            // NEW Week 08 recursive feature
+            cout << "High-energy tracks (recursive): "
+                << manager.countHighEnergyRecursive() << "\n";
+
+            // operator[] now throws if invalid, so we only do it if size > 0
+            if (manager.getSize() > 0)
+            {
+                try
+                {
+                    cout << "One-line summary (operator<<): " << *manager[0] << "\n";
+                }
+                catch (const exception& ex)
+                {
+                    cout << "Unexpected error: " << ex.what() << "\n";
+                }
+            }
+            break;
+
+        case 8:
+        {
+            cout << "\n--- Remove Week 7 Track ---\n";
+            if (manager.getSize() == 0)
+            {
+                cout << "Nothing to remove.\n";
+                break;
+            }
+
+            manager.printAll(cout);
+            int idx = safeIndexFromUser("Enter index to remove: ", manager.getSize());
+
+            // operator-= now throws if invalid removal
+            try
+            {
+                bool moved = idx != manager.getSize() - 1;
+                manager -= idx;
+                cout << "Removed item " << idx << ".\n";
+                if (moved)
+                    cout << "The last track moved into index " << idx << " (other indexes are unchanged).\n";
+            }
+            catch (const exception& ex)
+            {
+                cout << "Remove failed: " << ex.what() << "\n";
+            }
+
+            break;
+        }
+        case 9:
+            manager.saveReport("DJ_Set_Report_Week7.txt");
+            break;
+
+        // -------------------- Week 09: Sequential Search --------------------
+        case 10:
+        {
+            if (manager.getBpmCount() == 0)
+            {
+                cout << "No tracks in library yet. Add some first (options 1, 5 or 6).\n";
+                break;
+            }
+            int target = getValidatedInt("Enter BPM to search for (60-200): ", BPM_MIN, BPM_MAX);
+            vector<int> hits = manager.findAllBpm(target); // every match, SIMD column scan
+            if (hits.empty())
+                cout << "BPM " << target << " not found (sequential search).\n";
+            else
+            {
+                cout << "BPM " << target << " found " << hits.size() << " time(s) (sequential search):\n";
+                for (int idx : hits)
+                    cout << setw(6) << idx << "  " << *manager[idx] << "\n";
+            }
+            break;
+        }
+
+        // -------------------- Week 09: Bubble Sort + Binary Search --------------------
+        case 11:
+        {
+            if (manager.getBpmCount() == 0)
+            {
+                cout << "No tracks in library yet. Add some first (options 1, 5 or 6).\n";
+                break;
+            }
+            // Sort must come before binary search
+            manager.sortByBpm();
+            cout << "Library sorted by BPM (counting sort).\n";
+
+            cout << "Sorted BPMs: ";
+            for (int i = 0; i < manager.getBpmCount(); i++)
+                cout << manager.getBpmAt(i) << " ";
+            cout << "\n";
+
+            int target = getValidatedInt("Enter BPM to binary search for (60-200): ", BPM_MIN, BPM_MAX);
+            int idx = manager.binarySearchBpm(target);
+            if (idx == -1)
+                cout << "BPM " << target << " not found (binary search).\n";
+            else
+                cout << "BPM " << target << " found at sorted index " << idx
+                     << " (binary search): " << *manager[idx] << "\n";
+            break;
+        }
+
+        // -------------------- Library Engine: Setlist Builder --------------------
+        case 12:
+        {
+            if (manager.getSize() == 0)
+            {
+                cout << "No tracks in library yet. Add some first (options 1, 5 or 6).\n";
+                break;
+            }
+            manager.printAll(cout);
+            int startIdx = safeIndexFromUser("Start track index: ", manager.getSize());
+
+            SetBuildOptions options;
+            options.length = getValidatedInt("Set length (2-100 tracks): ", 2, 100);
+            int arcChoice = getValidatedInt("Energy arc (1=Rising, 2=Peak, 3=Steady): ", 1, 3);
+            if (arcChoice == 2)
+                options.arc = EnergyArc::peak();
+            else if (arcChoice == 3)
+                options.arc = EnergyArc::steady(manager[startIdx]->getEnergy());
+
+            Setlist set = SetBuilder(manager).build(manager.idAt(startIdx), options);
+            cout << "\nSetlist (" << set.tracks.size() << " tracks, score "
+                 << fixed << setprecision(2) << set.score << "):\n";
+            for (size_t i = 0; i < set.tracks.size(); i++)
+            {
+                TrackBase* p = manager.at(set.tracks[i]);
+                string camelot = keyToCamelot(parseHarmonicKey(p->getKey()));
+                cout << setw(4) << (i + 1) << ". " << *p
+                     << (camelot.empty() ? "" : " | " + camelot) << "\n";
+            }
+            if (static_cast<int>(set.tracks.size()) < options.length)
+                cout << "(Stopped early: no unused track within +/-" << options.maxBpmJump << " BPM.)\n";
+            break;
+        }
+
+        // -------------------- Library Engine: CSV/TSV Import --------------------
+        case 13:
+        {
+            cout << "\nCSV/TSV: columns are read from the header row: title, artist, genre, key, bpm,\n"
+                 << "energy (1-3 or Low/Medium/High), notes, path, platform (comma or tab separated).\n"
+                 << "XML/NML: Rekordbox or Traktor collection export.\n";
+            string path = getNonEmptyLine("File to import: ");
+            string ext = path.size() >= 4 ? path.substr(path.size() - 4) : "";
+            for (char& c : ext)
+                c = static_cast<char>(tolower(static_cast<unsigned char>(c)));
+            try
+            {
+                ImportReport report;
+                if (ext == ".xml" || ext == ".nml")
+                    report = XmlLibraryImporter(manager).importFile(path);
+                else
+                {
+                    WorkStealingPool workers;
+                    report = TrackImporter(manager, workers).importFile(path);
+                }
+
+                const int REJECTS_SHOWN = 20;
+                if (report.rejectedCount <= REJECTS_SHOWN)
+                    report.writeTo(cout);
+                else
+                {
+                    ofstream fout("DJ_Import_Rejected.txt");
+                    report.writeTo(fout);
+                    cout << "Imported " << report.imported << " of " << report.rows << " row(s); "
+                         << report.rejectedCount << " rejected rows listed in DJ_Import_Rejected.txt\n";
+                }
+            }
+            catch (const exception& ex)
+            {
+                cout << "Import failed: " << ex.what() << "\n";
+            }
+            break;
+        }
+
+        case 14:
+            if (libraryLog)
+            {
+                try
+                {
+                    compactor.compactNow(manager, *libraryLog, LIBRARY_SNAPSHOT_FILE);
+                    cout << "\nLibrary saved to " << LIBRARY_SNAPSHOT_FILE << " (" << manager.getSize() << " tracks).\n";
+                }
+                catch (const exception& ex)
+                {
+                    cout << "\nLibrary not saved: " << ex.what() << "\n";
+                }
+            }
+            cout << "\nGoodbye, " << djName << "! Keep the crowd moving.\n";
+            break;
+
+        default:
+            cout << "Invalid choice.\n";
+        }
+
+        // Library engine: this action's edits reach the disk in one group
+        // commit; a long log is folded into the snapshot in the background.
+        if (libraryLog)
+        {
+            try
+            {
+                libraryLog->sync();
+                compactor.finish(*libraryLog);
+                if (libraryLog->needsCompaction())
+                    compactor.start(manager, *libraryLog, LIBRARY_SNAPSHOT_FILE);
+            }
+            catch (const exception& ex)
+            {
+                cout << "\nLibrary not saved: " << ex.what() << "\n";
+            }
+        }
+
+    } while (choice != MENU_MAX);
+
+    manager.attachLog(nullptr);
+    return 0;
+}
+#endif
+
+// -------------------- UI Functions --------------------
+void showBanner()
+{
+    cout << "=============================================\n";
+    cout << "        DJ SET ARCHITECT - C++ EDITION       \n";
+    cout << " Weeks 1-4 + Weeks 5/6/7/09 Upgrade Combined \n"; // Week 09: updated banner
+    cout << "=============================================\n";
+}
+
+void showMenu()
+{
+    cout << "\n-------------------- MENU --------------------\n";
+    cout << "WEEKS 1-4 (Track details: artist, genre, key)\n";
+    cout << "1) Add a track to library\n";
+    cout << "2) View library summary\n";
+    cout << "3) Recommend next tracks (BPM/Energy rules)\n";
+    cout << "4) Save report to file\n\n";
+
+    cout << "WEEK 5+ (Abstract + Polymorphism + Operators + Templates + Exceptions)\n";
+    cout << "5) Add Local Track\n";
+    cout << "6) Add Stream Track\n";
+    cout << "7) View library\n";
+    cout << "8) Remove track by index (the last track takes its place)\n";
+    cout << "9) Save report to file\n\n";
+
+    cout << "WEEK 09 (Vector + Search + Sort)\n";
+    cout << "10) Sequential search BPM in library\n";
+    cout << "11) Sort library by BPM then binary search\n\n";
+
+    cout << "LIBRARY ENGINE\n";
+    cout << "12) Auto-build a setlist (beam search)\n";
+    cout << "13) Import tracks (CSV/TSV, Rekordbox XML, Traktor NML)\n\n";
+
+    cout << "14) Quit\n";
+    cout << "----------------------------------------------\n";
+}
+
+int getMenuChoice(int minChoice, int maxChoice)
+{
+    int choice;
+    while (true)
+    {
+        cout << "Enter choice (" << minChoice << "-" << maxChoice << "): ";
+
+        if (cin >> choice && choice >= minChoice && choice <= maxChoice)
+        {
+            cin.ignore(numeric_limits<streamsize>::max(), '\n');
+            return choice;
+        }
+
+        cout << "Invalid menu choice. Try again.\n";
+        cin.clear();
+        cin.ignore(numeric_limits<streamsize>::max(), '\n');
+    }
+}
+
+// -------------------- Input Helpers --------------------
+string getNonEmptyLine(const string& prompt)
+{
+    string value;
+    do
+    {
+        cout << prompt;
+        getline(cin, value);
+
+        if (value.empty())
+            cout << "Input cannot be empty. Please try again.\n";
+
+    } while (value.empty());
+
+    return value;
+}
+
+int getValidatedInt(const string& prompt, int minVal, int maxVal)
+{
+    int value;
+    while (true)
+    {
+        cout << prompt;
+
+        if (cin >> value && value >= minVal && value <= maxVal)
+        {
+            cin.ignore(numeric_limits<streamsize>::max(), '\n');
+            return value;
+        }
+
+        cout << "Invalid number. Enter " << minVal << " to " << maxVal << ".\n";
+        cin.clear();
+        cin.ignore(numeric_limits<streamsize>::max(), '\n');
+    }
+}
+
+double getValidatedDouble(const string& prompt, double minVal, double maxVal)
+{
+    double value;
+    while (true)
+    {
+        cout << prompt;
+
+        if (cin >> value && value >= minVal && value <= maxVal)
+        {
+            cin.ignore(numeric_limits<streamsize>::max(), '\n');
+            return value;
+        }
+
+        cout << "Invalid number. Enter " << minVal << " to " << maxVal << ".\n";
+        cin.clear();
+        cin.ignore(numeric_limits<streamsize>::max(), '\n');
+    }
+}
+
+// -------------------- Enum Helpers --------------------
+EnergyLevel getEnergyFromUser()
+{
+    cout << "Energy Level:\n";
+    cout << "  1) Low\n";
+    cout << "  2) Medium\n";
+    cout << "  3) High\n";
+
+    int choice = getValidatedInt("Choose energy (1-3): ", 1, 3);
+
+    switch (choice)
+    {
+    case 1: return LOW;
+    case 2: return MEDIUM;
+    case 3: return HIGH;
+    default: return MEDIUM;
+    }
+}
+
+string energyToString(EnergyLevel e)
+{
+    return string(energyLabel(e));
+}
+
+// -------------------- Output Helpers (Weeks 1-4) --------------------
+// Library engine: the tables are laid out by TableWriter (same bytes as the
+// old setw/left/right cells). Callers keep one writer for the whole table.
+void printLegacyTableHeader(TableWriter& w)
+{
+    w.left("Title", TITLE_W)
+        .left("Artist", ARTIST_W)
+        .left("Genre", GENRE_W)
+        .left("Key", KEY_W)
+        .right("BPM", 6).text("  ")
+        .left("Energy", 8)
+        .left("Notes", NOTE_W)
+        .endLine();
+
+    w.repeat('-', LINE_W).endLine();
+}
+
+void printTrackRow(TableWriter& w, string_view title, string_view artist, string_view genre,
+    string_view key, int bpm, EnergyLevel e, string_view notes)
+{
+    w.left(TableWriter::cut(title, TITLE_W), TITLE_W)
+        .left(TableWriter::cut(artist, ARTIST_W), ARTIST_W)
+        .left(TableWriter::cut(genre, GENRE_W), GENRE_W)
+        .left(TableWriter::cut(key, KEY_W), KEY_W)
+        .right(bpm, 6).text("  ")
+        .left(energyLabel(e), 8)
+        .left(TableWriter::cut(notes, NOTE_W), NOTE_W)
+        .endLine();
+}
+
+// -------------------- Main Features (Weeks 1-4) --------------------
+// Library engine: these now read and write the shared TrackManager.
+void addTrack(TrackManager& library)
+{
+    cout << "\n--- Add Track (" << (library.getSize() + 1) << ") ---\n";
+
+    Track t;
+    t.title = getNonEmptyLine("Title: ");
+    t.artist = getNonEmptyLine("Artist: ");
+    t.genre = getNonEmptyLine("Genre: ");
+    t.key = getNonEmptyLine("Key (ex: Am, C, F#m): ");
+    t.bpm = getValidatedInt("BPM (60-200): ", BPM_MIN, BPM_MAX);
+    t.energy = getEnergyFromUser();
+    t.notes = getNonEmptyLine("Notes (mix notes): ");
+
+    library.addTrackRecord(t);
+
+    cout << "Track added!\n";
+}
+
+void printLibrary(const TrackManager& library)
+{
+    if (library.getSize() == 0)
+    {
+        cout << "No tracks saved yet.\n";
+        return;
+    }
+
+    cout << "\n==================== LIBRARY (Weeks 1-4) ====================\n";
+    {
+        TableWriter w(cout);
+        printLegacyTableHeader(w);
+        library.printRecordRows(w);
+    }
+
+    double avg = computeAverageBPM(library);
+    cout << "\nAverage BPM: " << fixed << setprecision(1) << avg << "\n";
+
+    string checkGenre = getNonEmptyLine("Enter a genre to count matches: ");
+    int matches = countGenreMatches(library, checkGenre);
+    cout << "Tracks in genre \"" << checkGenre << "\": " << matches << "\n";
+}
+
+void recommendNextTracks(const TrackManager& library)
+{
+    if (library.getSize() == 0)
+    {
+        cout << "No tracks in library. Add tracks first.\n";
+        return;
+    }
+
+    cout << "\n--- Recommend Next Tracks ---\n";
+    int currentBPM = getValidatedInt("Current BPM you are playing (60-200): ", BPM_MIN, BPM_MAX);
+    EnergyLevel currentEnergy = getEnergyFromUser();
+
+    int currentKey = NO_KEY;
+    while (true)
+    {
+        string keyText = getNonEmptyLine("Current key (ex: Am, 8A, 1m) or 'any': ");
+        if (keyText == "any" || keyText == "ANY")
+            break;
+        currentKey = parseHarmonicKey(keyText);
+        if (currentKey != NO_KEY)
+            break;
+        cout << "Unknown key. Try again.\n";
+    }
+
+    const int BPM_RANGE = 5;
+    const double PITCH_RANGE = 8.0; // typical +/-8% turntable fader
+
+    int tempoMode = getValidatedInt("Tempo match (1 = +/-5 BPM, 2 = +/-8% pitch incl. half/double time): ", 1, 2);
+    TempoTolerance tol = TempoTolerance::bpm(BPM_RANGE);
+    if (tempoMode == 2)
+    {
+        tol = TempoTolerance::pitchFader(PITCH_RANGE);
+        tol.halfDouble = true;
+    }
+
+    cout << "\nSuggested tracks (";
+    if (tempoMode == 2)
+        cout << "reachable with +/-" << PITCH_RANGE << "% pitch, half/double time allowed";
+    else
+        cout << "within +/-" << BPM_RANGE << " BPM";
+    cout << " and energy stays steady or rises";
+    if (currentKey != NO_KEY)
+        cout << ", harmonic with " << keyToCamelot(currentKey);
+    cout << "):\n";
+
+    // BPM bucket index: only the bucket ranges of the tempo window are visited
+    vector<TempoMatch> picks = library.recommendByTempo(currentBPM, currentEnergy, tol, currentKey);
+    for (const TempoMatch& match : picks)
+    {
+        TrackBase* p = library.at(match.id);
+        cout << " - " << p->getTitle();
+        if (!p->getArtistSymbol().empty())
+            cout << " by " << p->getArtist();
+        cout << " (" << p->getBpm() << " BPM, " << energyToString(p->getEnergy());
+        string camelot = keyToCamelot(parseHarmonicKey(p->getKey()));
+        if (!camelot.empty())
+            cout << ", " << camelot;
+        cout << ")";
+        if (match.ratio != 1.0)
+            cout << (match.ratio > 1.0 ? " [double time]" : " [half time]");
+        if (tempoMode == 2)
+            cout << " pitch " << showpos << fixed << setprecision(1) << match.pitchPercent << "%" << noshowpos;
+        cout << "\n";
+    }
+
+    if (picks.empty())
+        cout << "No close matches found. Try adding more tracks.\n";
+
+    // Ranked view: one score over BPM distance, energy and key (top-K heap)
+    const int TOP_PICKS = 5;
+    RecommendQuery query;
+    query.bpm = currentBPM;
+    query.energy = currentEnergy;
+    query.key = currentKey;
+    query.k = TOP_PICKS;
+    vector<ScoredTrack> ranked = library.topRecommendations(query);
+    if (!ranked.empty())
+    {
+        cout << "\nBest " << ranked.size() << " by score:\n";
+        for (size_t i = 0; i < ranked.size(); i++)
+        {
+            cout << "  " << (i + 1) << ". " << library.at(ranked[i].id)->getTitle()
+                << " (" << ranked[i].bpm << " BPM, score " << fixed << setprecision(2) << ranked[i].score << ")\n";
+        }
+    }
+}
+
+void writeLegacyReport(ostream& out, const TrackManager& library)
+{
+    out << "==================== DJ SET ARCHITECT REPORT (Weeks 1-4) ====================\n";
+    out << "Tracks stored: " << library.getSize() << "\n\n";
+
+    if (library.getSize() == 0)
+    {
+        out << "No tracks saved.\n";
+        return;
+    }
+
+    {
+        TableWriter w(out);
+        printLegacyTableHeader(w);
+        library.printRecordRows(w);
+    }
+
+    double avg = computeAverageBPM(library);
+    out << "\nAverage BPM: " << fixed << setprecision(1) << avg << "\n";
+    library.snapshotAggregates().writeTo(out);
+}
+
+void saveReportToFile(const TrackManager& library, const string& filename)
+{
+    ofstream fout(filename.c_str());
+    if (!fout)
+    {
+        cout << "Could not open file: " << filename << "\n";
+        return;
+    }
+
+    writeLegacyReport(fout, library);
+
+    fout.close();
+    cout << "Report saved to " << filename << "\n";
+}
+
+// -------------------- Calculations / Derived Values (Weeks 1-4) --------------------
+double computeAverageBPM(const Track library[], int count)
+{
+    if (count == 0) return 0.0;
+
+    int sum = 0;
+    for (int i = 0; i < count; i++)
+        sum += library[i].bpm;
+
+    return static_cast<double>(sum) / static_cast<double>(count);
+}
+
+double computeAverageBPM(const TrackManager& library)
+{
+    return library.averageBpm();
+}
+
+// Library engine: genres are interned, so the loop compares 32-bit ids.
+int countGenreMatches(const Track library[], int count, const string& genre)
+{
+    long long id = SymbolTable::global().find(genre);
+    if (id < 0)
+        return 0; // no track was ever stored with this genre
+
+    Symbol target = Symbol::fromId(static_cast<uint32_t>(id));
+    int matches = 0;
+    for (int i = 0; i < count; i++)
+    {
+        if (library[i].genre == target)
+            matches++;
+    }
+    return matches;
+}
+
+int countGenreMatches(const TrackManager& library, const string& genre)
+{
+    return library.countGenre(genre);
+}
+
+// -------------------- Week 5/6/7 Helper Output --------------------
+void printWeek5TableHeader(TableWriter& w)
+{
+    w.text("Idx ")
+        .left("Title", TITLE_W)
+        .left("Type", TYPE_W)
+        .right("BPM", 6).text("  ")
+        .left("Energy", 8)
+        .left("Notes", NOTE_W)
+        .text("  Source")
+        .endLine();
+
+    printSeparator(w);
+}
+
+void printSeparator(ostream& out)
+{
+    out << string(LINE_W, '-') << "\n";
+}
+
+void printSeparator(TableWriter& w)
+{
+    w.repeat('-', LINE_W).endLine();
+}
+
+int safeIndexFromUser(const string& prompt, int size)
+{
+    if (size <= 0) return -1;
+    return getValidatedInt(prompt, 0, size - 1);
+}
+
+// -------------------- Benchmarks --------------------
+// Timing runs for the library engine. Build WITHOUT _DEBUG and with DJ_BENCHMARK:
+//   g++ -std=c++17 -O2 -DDJ_BENCHMARK "Dj Archetex/Dj Archetex.cpp" -o bench
+#if defined(DJ_BENCHMARK) && !defined(_DEBUG)
+
+// Deterministic pseudo-random generator so every run times the same library.
+struct BenchRng
+{
+    unsigned long long state;
+
+    BenchRng(unsigned long long seed) : state(seed * 2654435761ULL + 1) {}
+
+    int nextInt(int lo, int hi)
+    {
+        state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+        return lo + static_cast<int>((state >> 33) % static_cast<unsigned long long>(hi - lo + 1));
+    }
+};
+
+void fillBenchLibrary(TrackManager& m, int n, unsigned long long seed)
+{
+    BenchRng rng(seed);
+    m.reserve(n);
+    for (int i = 0; i < n; i++)
+    {
+        int bpm = rng.nextInt(BPM_MIN, BPM_MAX);
+        EnergyLevel e = static_cast<EnergyLevel>(rng.nextInt(LOW, HIGH));
+        if (i % 2 == 0)
+            m.emplaceLocal("Track " + to_string(i), bpm, e, "t" + to_string(i) + ".wav", MixNotes(""));
+        else
+            m.emplaceStream("Track " + to_string(i), bpm, e, "Spotify", MixNotes(""));
+    }
+}
+
+template <class Fn>
+double timeMs(Fn fn)
+{
+    chrono::steady_clock::time_point t0 = chrono::steady_clock::now();
+    fn();
+    chrono::steady_clock::time_point t1 = chrono::steady_clock::now();
+    return chrono::duration<double, milli>(t1 - t0).count();
+}
+
+void benchSortBpms()
+{
+    cout << "\n[sort] bubble sort vs counting sort (ms)\n";
+    cout << left << setw(10) << "tracks" << right << setw(14) << "bubble" << setw(14) << "counting" << "\n";
+
+    const int sizes[] = { 1000, 5000, 20000, 100000, 1000000 };
+    const int BUBBLE_LIMIT = 20000; // O(n^2): larger sizes take minutes
+    for (int n : sizes)
+    {
+        TrackManager a(2);
+        fillBenchLibrary(a, n, 42);
+        double countingMs = timeMs([&a]() { a.sortByBpm(); });
+
+        cout << left << setw(10) << n << right << setw(14);
+        if (n <= BUBBLE_LIMIT)
+        {
+            TrackManager b(2);
+            fillBenchLibrary(b, n, 42);
+            cout << fixed << setprecision(2) << timeMs([&b]() { b.sortBpmsBubble(); });
+        }
+        else
+        {
+            cout << "(skipped)";
+        }
+        cout << setw(14) << fixed << setprecision(2) << countingMs << "\n";
+    }
+}
+
+void benchRecommendations()
+{
+    const int N = 250000;
+    const int QUERIES = 2000;
+    const int BPM_RANGE = 5;
+
+    TrackManager m(2);
+    fillBenchLibrary(m, N, 7);
+
+    // Baseline: full-library scan with the recommendNextTracks() rule.
+    BenchRng rng(99);
+    long long scanHits = 0;
+    double scanMs = timeMs([&]() {
+        for (int q = 0; q < QUERIES; q++)
+        {
+            int bpm = rng.nextInt(BPM_MIN, BPM_MAX);
+            EnergyLevel e = static_cast<EnergyLevel>(rng.nextInt(LOW, HIGH));
+            for (int i = 0; i < m.getSize(); i++)
+            {
+                int diff = absValue(m.getBpmAt(i) - bpm);
+                EnergyLevel te = m[i]->getEnergy();
+                if (diff <= BPM_RANGE && (te == e || te == e + 1))
+                    scanHits++;
+            }
+        }
+    });
+
+    BenchRng rng2(99);
+    long long indexHits = 0;
+    double indexMs = timeMs([&]() {
+        for (int q = 0; q < QUERIES; q++)
+        {
+            int bpm = rng2.nextInt(BPM_MIN, BPM_MAX);
+            EnergyLevel e = static_cast<EnergyLevel>(rng2.nextInt(LOW, HIGH));
+            indexHits += static_cast<long long>(m.recommendNext(bpm, e, BPM_RANGE).size());
+        }
+    });
+
+    cout << "\n[recommend] " << N << " tracks, +/-" << BPM_RANGE << " BPM, per query (ms)\n";
+    cout << "  full scan : " << fixed << setprecision(4) << scanMs / QUERIES << "\n";
+    cout << "  BPM index : " << fixed << setprecision(4) << indexMs / QUERIES
+         << (scanHits == indexHits ? "  (same results)" : "  (RESULT MISMATCH)") << "\n";
+}
+
+void benchColumnScans()
+{
+    const int N = 1000000;
+    const int REPS = 50;
+
+    TrackManager m(2);
+    fillBenchLibrary(m, N, 11);
+
+    vector<uint16_t> col(N);
+    for (int i = 0; i < N; i++)
+        col[i] = packColumnValue(m.getBpmAt(i));
+    double megabytes = static_cast<double>(N) * sizeof(uint16_t) / (1024.0 * 1024.0);
+
+    cout << "\n[scan] " << N << " tracks, BPM column (" << fixed << setprecision(1) << megabytes
+         << " MB), detected: " << simdLevelToString(detectSimdLevel()) << "\n";
+
+    long long baseline = 0;
+    double baseMs = timeMs([&]() {
+        for (int r = 0; r < REPS; r++)
+            for (int i = 0; i < m.getBpmCount(); i++)
+                if (m.getBpmAt(i) == 128) baseline++;
+    });
+    cout << "  vector::at loop     count: " << setprecision(3) << baseMs / REPS << " ms\n";
+
+    for (int level = SIMD_SCALAR; level <= detectSimdLevel(); level++)
+    {
+        ColumnScanner sc = ColumnScanner::forLevel(static_cast<SimdLevel>(level));
+        long long counted = 0;
+        double countMs = timeMs([&]() {
+            for (int r = 0; r < REPS; r++)
+                counted += sc.count(col, 128, 128);
+        });
+
+        vector<int> hits;
+        double findMs = timeMs([&]() {
+            for (int r = 0; r < REPS; r++)
+            {
+                hits.clear();
+                sc.findAll(col, 128, 128, hits);
+            }
+        });
+
+        double perCount = countMs / REPS;
+        cout << "  " << left << setw(8) << simdLevelToString(sc.level) << right
+             << "  count: " << setprecision(3) << perCount << " ms ("
+             << setprecision(1) << megabytes / (perCount / 1000.0) / 1024.0 << " GB/s)"
+             << "  findAll: " << setprecision(3) << findMs / REPS << " ms"
+             << (counted == baseline ? "" : "  (COUNT MISMATCH)") << "\n";
+    }
+}
+
+void benchBulkLoad()
+{
+    const int N = 500000;
+    cout << "\n[load] " << N << " tracks: operator+= (new per track) vs emplace (slab pool)\n";
+
+    double heapMs = timeMs([&]() {
+        TrackManager m(2);
+        m.reserve(N);
+        for (int i = 0; i < N; i++)
+            m += new LocalTrack("Track", BPM_MIN + i % BPM_BUCKETS, MEDIUM, "t.wav", MixNotes(""));
+    });
+
+    PoolStats stats;
+    double poolMs = timeMs([&]() {
+        TrackManager m(2);
+        m.reserve(N);
+        for (int i = 0; i < N; i++)
+            m.emplaceLocal("Track", BPM_MIN + i % BPM_BUCKETS, MEDIUM, "t.wav", MixNotes(""));
+        stats = m.getLocalPoolStats();
+    });
+
+    cout << "  operator+= : " << fixed << setprecision(1) << heapMs << " ms (" << N << " allocations)\n";
+    cout << "  emplace    : " << fixed << setprecision(1) << poolMs << " ms ("
+         << stats.slabAllocations << " slab allocations)\n";
+}
+
+void benchInlineScans()
+{
+    const int N = 500000;
+    const int REPS = 20;
+
+    TrackManager m(2);
+    fillBenchLibrary(m, N, 13);
+    InlineTrackList list = m.toInlineList();
+
+    cout << "\n[variant] " << N << " tracks: TrackBase* (heap) vs inline std::variant\n";
+
+    // Non-virtual getters: measures pointer chasing vs contiguous values.
+    long long ptrSum = 0;
+    double ptrMs = timeMs([&]() {
+        for (int r = 0; r < REPS; r++)
+            for (int i = 0; i < m.getSize(); i++)
+            {
+                const TrackBase* p = m[i];
+                ptrSum += p->getBpm() + (p->getEnergy() == HIGH ? 1 : 0);
+            }
+    });
+
+    long long inlineSum = 0;
+    double inlineMs = timeMs([&]() {
+        for (int r = 0; r < REPS; r++)
+            for (int i = 0; i < list.getSize(); i++)
+                inlineSum += visit([](const auto& t) {
+                    return t.getBpm() + (t.getEnergy() == HIGH ? 1 : 0);
+                }, list.variantAt(i));
+    });
+
+    cout << "  bpm+energy scan  pointer: " << fixed << setprecision(2) << ptrMs / REPS << " ms"
+         << "   inline: " << inlineMs / REPS << " ms"
+         << (ptrSum == inlineSum ? "" : "  (RESULT MISMATCH)") << "\n";
+
+    // toStream over the full library: virtual dispatch vs std::visit.
+    ostringstream virtualOut;
+    double virtualMs = timeMs([&]() {
+        for (int i = 0; i < m.getSize(); i++)
+            virtualOut << *m[i] << "\n";
+    });
+
+    ostringstream visitOut;
+    double visitMs = timeMs([&]() { list.toStreamAll(visitOut); });
+
+    cout << "  toStream (full)  virtual: " << fixed << setprecision(1) << virtualMs << " ms"
+         << "   visit: " << visitMs << " ms"
+         << (virtualOut.str() == visitOut.str() ? "" : "  (OUTPUT MISMATCH)") << "\n";
+}
+
+void benchSetBuilder()
+{
+    const int N = 50000;
+    const int LENGTH = 20;
+    static const char* const KEYS[6] = { "Am", "8B", "9A", "F#m", "1m", "C" };
+
+    TrackManager m(2);
+    m.reserve(N);
+    BenchRng rng(21);
+    for (int i = 0; i < N; i++)
+    {
+        m.emplaceLocal("Track", rng.nextInt(BPM_MIN, BPM_MAX),
+            static_cast<EnergyLevel>(rng.nextInt(LOW, HIGH)), "t.wav", MixNotes(""));
+        m.updateKey(i, KEYS[rng.nextInt(0, 5)]);
+    }
+
+    cout << "\n[setlist] " << N << "-track crate, " << LENGTH << "-track rising set\n";
+    SetBuilder builder(m);
+    int beams[3] = { 100, 300, 500 };
+    for (int beam : beams)
+    {
+        SetBuildOptions options;
+        options.length = LENGTH;
+        options.beamWidth = beam;
+        Setlist set;
+        double ms = timeMs([&]() { set = builder.build(m.idAt(0), options); });
+        cout << "  beam " << setw(4) << beam << " : " << fixed << setprecision(1) << ms << " ms  (score "
+             << setprecision(2) << set.score << ", " << set.tracks.size() << " tracks)\n";
+    }
+}
+
+// 1, 2, 4, ... below 'hardware', then 'hardware' itself.
+vector<int> benchThreadCounts(int hardware)
+{
+    vector<int> counts;
+    for (int threads = 1; threads < hardware; threads *= 2)
+        counts.push_back(threads);
+    counts.push_back(hardware < 1 ? 1 : hardware);
+    return counts;
+}
+
+void benchParallelSets()
+{
+    const int N = 50000;
+    const int SEEDS = 32;
+
+    TrackManager m(2);
+    fillBenchLibrary(m, N, 23);
+
+    SetBuildOptions options;
+    options.length = 20;
+    options.beamWidth = 100;
+    ParallelSetOptions par;
+    par.seeds = SEEDS;
+
+    int hardware = static_cast<int>(thread::hardware_concurrency());
+    if (hardware <= 0)
+        hardware = 1;
+    cout << "\n[parallel sets] " << N << "-track crate, " << SEEDS << " seeded beam searches (beam "
+         << options.beamWidth << "), " << hardware << " hardware thread(s)\n";
+
+    double baseMs = 0.0;
+    for (int threads : benchThreadCounts(hardware))
+    {
+        WorkStealingPool pool(threads);
+        vector<Setlist> top;
+        double ms = timeMs([&]() { top = ParallelSetOptimizer(m, pool).optimize(m.idAt(0), options, par); });
+        if (threads == 1)
+            baseMs = ms;
+        cout << "  threads " << setw(3) << threads << " : " << fixed << setprecision(1) << setw(8) << ms
+             << " ms  speedup " << setprecision(2) << baseMs / ms << "x  best " << top.front().score
+             << "  steals " << pool.getSteals() << "\n";
+    }
+}
+
+void benchEnergyPlanner()
+{
+    const int N = 50000;
+    static const char* const KEYS[6] = { "Am", "8B", "9A", "F#m", "1m", "C" };
+
+    TrackManager m(2);
+    m.reserve(N);
+    BenchRng rng(29);
+    for (int i = 0; i < N; i++)
+    {
+        m.emplaceLocal("Track", rng.nextInt(BPM_MIN, BPM_MAX),
+            static_cast<EnergyLevel>(rng.nextInt(LOW, HIGH)), "t.wav", MixNotes(""));
+        m.updateKey(i, KEYS[rng.nextInt(0, 5)]);
+    }
+
+    vector<EnergyLevel> curve;
+    for (int i = 0; i < 8; i++) curve.push_back(LOW);
+    for (int i = 0; i < 8; i++) curve.push_back(MEDIUM);
+    for (int i = 0; i < 12; i++) curve.push_back(HIGH);
+    for (int i = 0; i < 4; i++) curve.push_back(MEDIUM);
+
+    EnergyPlan plan;
+    double ms = timeMs([&]() { plan = EnergyArcPlanner(m).plan(curve); });
+    cout << "\n[energy plan] " << N << "-track crate, " << curve.size() << "-step curve: "
+         << fixed << setprecision(1) << ms << " ms (score " << setprecision(2) << plan.score
+         << ", repairs " << plan.repairs << ")\n";
+}
+
+void benchNeighborIndex()
+{
+    const int N = 50000;
+    const int OPS = 2000;
+
+    TrackManager m(2);
+    fillBenchLibrary(m, N, 31);
+
+    double buildMs = timeMs([&]() { m.enableNeighborIndex(); });
+
+    BenchRng rng(32);
+    double addMs = timeMs([&]() {
+        for (int i = 0; i < OPS; i++)
+            m.emplaceLocal("New", rng.nextInt(BPM_MIN, BPM_MAX), static_cast<EnergyLevel>(rng.nextInt(LOW, HIGH)),
+                "n.wav", MixNotes(""));
+    });
+    double removeMs = timeMs([&]() {
+        for (int i = 0; i < OPS; i++)
+            m.removeAt(rng.nextInt(0, m.getSize() - 1));
+    });
+
+    long long listed = 0;
+    double queryMs = timeMs([&]() {
+        for (int i = 0; i < m.getSize(); i++)
+            listed += static_cast<long long>(m.neighborsOf(m.idAt(i)).size());
+    });
+
+    cout << "\n[neighbors] " << N << " tracks, k = " << NeighborOptions().k << "\n";
+    cout << "  full build : " << fixed << setprecision(1) << buildMs << " ms\n";
+    cout << "  add        : " << setprecision(4) << addMs / OPS << " ms per track\n";
+    cout << "  remove     : " << removeMs / OPS << " ms per track\n";
+    cout << "  lookup     : " << queryMs * 1000000.0 / m.getSize() << " ns per track ("
+         << listed << " neighbors listed)\n";
+}
+
+void benchTempoMatching()
+{
+    const int N = 1000000;
+    const int QUERIES = 200;
+
+    TrackManager m(2);
+    fillBenchLibrary(m, N, 41);
+
+    TempoTolerance tol = TempoTolerance::pitchFader(8.0);
+    tol.halfDouble = true;
+    const double RATIOS[] = { 1.0, 2.0, 0.5 };
+
+    // Baseline: one linear pass per tempo ratio with the same pitch limit,
+    // then the matches sorted by pitch change (same output as the index).
+    BenchRng rng(42);
+    long long scanHits = 0;
+    vector<TempoMatch> scanned;
+    double scanMs = timeMs([&]() {
+        for (int q = 0; q < QUERIES; q++)
+        {
+            int target = rng.nextInt(BPM_MIN, BPM_MAX);
+            scanned.clear();
+            for (double ratio : RATIOS)
+                for (int i = 0; i < m.getSize(); i++)
+                {
+                    int bpm = m.getBpmAt(i);
+                    double pitch = tempoPitchPercent(target, bpm, ratio);
+                    if (pitch >= -8.0 - 1e-9 && pitch <= 8.0 + 1e-9)
+                        scanned.push_back({ m.idAt(i), bpm, ratio, pitch });
+                }
+            stable_sort(scanned.begin(), scanned.end(), [](const TempoMatch& a, const TempoMatch& b) {
+                return fabs(a.pitchPercent) < fabs(b.pitchPercent);
+            });
+            scanHits += static_cast<long long>(scanned.size());
+        }
+    });
+
+    BenchRng rng2(42);
+    long long indexHits = 0;
+    double indexMs = timeMs([&]() {
+        for (int q = 0; q < QUERIES; q++)
+            indexHits += static_cast<long long>(m.findTempoMatches(rng2.nextInt(BPM_MIN, BPM_MAX), tol).size());
+    });
+
+    cout << "\n[tempo] " << N << " tracks, +/-8% pitch with 0.5x/2x, per query (ms)\n";
+    cout << "  scan per ratio : " << fixed << setprecision(3) << scanMs / QUERIES << "\n";
+    cout << "  bucket ranges  : " << indexMs / QUERIES
+         << (scanHits == indexHits ? "  (same counts)" : "  (COUNT MISMATCH)") << "\n";
+}
+
+void benchTopRecommendations()
+{
+    const int N = 1000000;
+    const int QUERIES = 200;
+    const int K = 10;
+
+    TrackManager m(2);
+    fillBenchLibrary(m, N, 51);
+    BenchRng keys(52);
+    for (int i = 0; i < N; i++)
+        m.updateKey(i, keyToCamelot(keys.nextInt(0, HARMONIC_KEYS - 1)));
+
+    RecommendQuery q;
+    q.k = K;
+
+    // Baseline: score every track in the window, bounded heap, O(n log K).
+    BenchRng rng(53);
+    double checksumScan = 0.0;
+    double scanMs = timeMs([&]() {
+        vector<ScoredTrack> heap;
+        for (int r = 0; r < QUERIES; r++)
+        {
+            q.bpm = rng.nextInt(BPM_MIN, BPM_MAX);
+            q.energy = static_cast<EnergyLevel>(rng.nextInt(LOW, HIGH));
+            q.key = rng.nextInt(0, HARMONIC_KEYS - 1);
+            heap.clear();
+            for (int i = 0; i < m.getSize(); i++)
+            {
+                if (absValue(m.getBpmAt(i) - q.bpm) > q.maxBpmDistance)
+                    continue;
+                ScoredTrack t = m.scoreRecommendation(q, m.idAt(i));
+                if (static_cast<int>(heap.size()) == K && !scoredBefore(t, heap.front()))
+                    continue;
+                heap.push_back(t);
+                push_heap(heap.begin(), heap.end(), scoredBefore);
+                if (static_cast<int>(heap.size()) > K)
+                {
+                    pop_heap(heap.begin(), heap.end(), scoredBefore);
+                    heap.pop_back();
+                }
+            }
+            for (const ScoredTrack& t : heap)
+                checksumScan += t.score;
+        }
+    });
+
+    BenchRng rng2(53);
+    double checksumIndex = 0.0;
+    double indexMs = timeMs([&]() {
+        for (int r = 0; r < QUERIES; r++)
+        {
+            q.bpm = rng2.nextInt(BPM_MIN, BPM_MAX);
+            q.energy = static_cast<EnergyLevel>(rng2.nextInt(LOW, HIGH));
+            q.key = rng2.nextInt(0, HARMONIC_KEYS - 1);
+            for (const ScoredTrack& t : m.topRecommendations(q))
+                checksumIndex += t.score;
+        }
+    });
+
+    cout << "\n[top-k] " << N << " tracks, k = " << K << ", per query (ms)\n";
+    cout << "  heap over scan : " << fixed << setprecision(3) << scanMs / QUERIES << "\n";
+    cout << "  BPM index      : " << indexMs / QUERIES
+         << (absValue(checksumScan - checksumIndex) < 1e-6 ? "  (same scores)" : "  (SCORE MISMATCH)") << "\n";
+}
+
+void benchSnapshot()
+{
+    const int N = 1000000;
+    const char* PATH = "bench_library.djsnap";
+
+    TrackManager m(2);
+    fillBenchLibrary(m, N, 61);
+    const char* genres[] = { "House", "Techno", "Trance", "Drum & Bass" };
+    for (int i = 0; i < N; i++)
+        m.updateGenre(i, genres[i % 4]);
+
+    double saveMs = timeMs([&]() { m.saveSnapshot(PATH); });
+
+    // Open + one column scan: no parsing, no per-track allocation.
+    long long at128 = 0;
+    size_t fileBytes = 0;
+    double openMs = timeMs([&]() {
+        SnapshotView view(PATH);
+        fileBytes = view.getFileSize();
+        const int32_t* bpm = view.bpmColumn();
+        for (int i = 0; i < view.getSize(); i++)
+            at128 += (bpm[i] == 128);
+    });
+
+    size_t titleBytes = 0;
+    double lazyMs = timeMs([&]() {
+        SnapshotView view(PATH);
+        for (int i = 0; i < view.getSize(); i += 1000)
+            titleBytes += view.titleAt(i).size();
+    });
+
+    TrackManager loaded(2);
+    double loadMs = timeMs([&]() { loaded.loadSnapshot(PATH); });
+    remove(PATH);
+
+    cout << "\n[snapshot] " << N << " tracks, " << fixed << setprecision(1)
+         << fileBytes / (1024.0 * 1024.0) << " MB file\n";
+    cout << "  save                    : " << saveMs << " ms\n";
+    cout << "  open + BPM column scan  : " << setprecision(2) << openMs << " ms ("
+         << (at128 == m.countBpmEqual(128) ? "same count" : "COUNT MISMATCH") << ")\n";
+    cout << "  open + 1000 lazy titles : " << lazyMs << " ms\n";
+    cout << "  full load (app startup) : " << setprecision(1) << loadMs << " ms ("
+         << (loaded.getSize() == N ? "all tracks" : "TRACKS MISSING") << ")\n";
+}
+
+void benchCsvImport()
+{
+    const int N = 1000000;
+    const char* PATH = "bench_library.csv";
+    const char* genres[] = { "House", "Techno", "Trance", "Drum & Bass" };
+    const char* energies[] = { "Low", "Medium", "High" };
+
+    {
+        BenchRng rng(71);
+        ofstream out(PATH, ios::binary);
+        out << "title,artist,genre,key,bpm,energy,notes,path,platform\n";
+        for (int i = 0; i < N; i++)
+        {
+            out << "Track " << i << ",Artist " << (i % 5000) << "," << genres[i % 4] << ","
+                << keyToCamelot(rng.nextInt(0, HARMONIC_KEYS - 1)) << "," << rng.nextInt(BPM_MIN, BPM_MAX) << ","
+                << energies[rng.nextInt(0, 2)] << ",\"cue at 0:32, fade out\",";
+            if (i % 2 == 0)
+                out << "music/t" << i << ".wav,\n";
+            else
+                out << ",Spotify\n";
+        }
+    }
+
+    WorkStealingPool workers;
+    TrackManager m(2);
+    ImportReport report;
+    double importMs = timeMs([&]() { report = TrackImporter(m, workers).importFile(PATH); });
+    remove(PATH);
+
+    cout << "\n[csv import] " << N << " rows, " << workers.getThreadCount() << " worker(s)\n";
+    cout << "  import : " << fixed << setprecision(1) << importMs << " ms ("
+         << report.imported << " imported, " << report.rejectedCount << " rejected)\n";
+}
+
+void benchXmlImport()
+{
+    const int N = 200000;
+    const char* PATH = "bench_rekordbox.xml";
+    const char* genres[] = { "House", "Techno", "Trance", "Drum &amp; Bass" };
+
+    {
+        BenchRng rng(83);
+        ofstream out(PATH, ios::binary);
+        out << "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n<DJ_PLAYLISTS Version=\"1.0.0\">\n"
+            << "  <PRODUCT Name=\"rekordbox\" Version=\"6.7.4\" Company=\"AlphaTheta\"/>\n"
+            << "  <COLLECTION Entries=\"" << N << "\">\n";
+        for (int i = 0; i < N; i++)
+        {
+            out << "    <TRACK TrackID=\"" << i << "\" Name=\"Track " << i << "\" Artist=\"Artist " << (i % 5000)
+                << "\" Composer=\"\" Album=\"Album " << (i % 900) << "\" Grouping=\"\" Genre=\"" << genres[i % 4]
+                << "\" Kind=\"MP3 File\" Size=\"9876543\" TotalTime=\"" << rng.nextInt(180, 480)
+                << "\" DiscNumber=\"0\" TrackNumber=\"1\" Year=\"2024\" AverageBpm=\"" << rng.nextInt(BPM_MIN, BPM_MAX)
+                << ".00\" DateAdded=\"2024-01-01\" BitRate=\"320\" SampleRate=\"44100\" Comments=\"cue at 0:32, fade out\""
+                << " PlayCount=\"3\" Rating=\"" << rng.nextInt(0, 5) * 51 << "\" Location=\"file://localhost/C:/Music/Track%20"
+                << i << ".mp3\" Remixer=\"\" Tonality=\"" << keyToCamelot(rng.nextInt(0, HARMONIC_KEYS - 1))
+                << "\" Label=\"\" Mix=\"\">\n"
+                << "      <TEMPO Inizio=\"0.025\" Bpm=\"124.00\" Metro=\"4/4\" Battito=\"1\"/>\n"
+                << "      <POSITION_MARK Name=\"\" Type=\"0\" Start=\"32.025\" Num=\"0\" Red=\"40\" Green=\"226\" Blue=\"20\"/>\n"
+                << "    </TRACK>\n";
+        }
+        out << "  </COLLECTION>\n  <PLAYLISTS><NODE Type=\"0\" Name=\"ROOT\" Count=\"0\"/></PLAYLISTS>\n</DJ_PLAYLISTS>\n";
+    }
+    double mb = 0.0;
+    {
+        ifstream in(PATH, ios::binary | ios::ate);
+        mb = static_cast<double>(in.tellg()) / (1024.0 * 1024.0);
+    }
+
+    TrackManager m(2);
+    ImportReport report;
+    double importMs = timeMs([&]() { report = XmlLibraryImporter(m).importFile(PATH); });
+    remove(PATH);
+
+    cout << "\n[xml import] Rekordbox collection, " << N << " tracks, " << fixed << setprecision(1) << mb << " MB\n";
+    cout << "  import : " << importMs << " ms, " << (mb * 1000.0 / importMs) << " MB/s ("
+         << report.imported << " imported, " << report.rejectedCount << " rejected)\n";
+}
+
+void benchWriteAheadLog()
+{
+    const int N = 1000000;
+    const int EDITS = 2000;
+    const char* LOG = "bench_library.djlog";
+    const char* SNAP = "bench_library.djsnap";
+    remove(LOG);
+    remove(SNAP);
+
+    TrackManager plain(N);
+    double plainMs = timeMs([&]() { fillBenchLibrary(plain, N, 91); });
+
+    TrackManager live(N);
+    OperationLog log(LOG);
+    live.attachLog(&log);
+    double loggedMs = timeMs([&]() {
+        fillBenchLibrary(live, N, 91);
+        log.sync();
+    });
+    int groupSyncs = log.getSyncCount();
+
+    // one fsync per edit vs the default group commit
+    BenchRng rng(92);
+    double perRecordMs = 0.0;
+    {
+        LogOptions each;
+        each.groupCommitBytes = 0;
+        OperationLog strict("bench_strict.djlog", 0, each);
+        plain.attachLog(&strict);
+        perRecordMs = timeMs([&]() {
+            for (int i = 0; i < EDITS; i++)
+                plain.updateBpm(rng.nextInt(0, N - 1), rng.nextInt(BPM_MIN, BPM_MAX));
+        });
+        plain.attachLog(nullptr);
+    }
+    remove("bench_strict.djlog");
+    double groupedMs = timeMs([&]() {
+        for (int i = 0; i < EDITS; i++)
+            live.updateBpm(rng.nextInt(0, N - 1), rng.nextInt(BPM_MIN, BPM_MAX));
+        log.sync();
+    });
+    uint64_t logBytes = log.getBytes();
+
+    TrackManager replayed(N);
+    RecoveryReport report;
+    double replayMs = timeMs([&]() { report = recoverLibrary(replayed, SNAP, LOG); });
+
+    LogCompactor compactor;
+    double copyMs = timeMs([&]() { compactor.start(live, log, SNAP); });
+    double writeMs = timeMs([&]() { compactor.finish(log, true); });
+    live.attachLog(nullptr);
+
+    cout << "\n[write-ahead log] " << N << " adds, then " << EDITS << " BPM edits\n";
+    cout << "  bulk load, no log        : " << fixed << setprecision(1) << plainMs << " ms\n";
+    cout << "  bulk load, logged        : " << loggedMs << " ms (" << groupSyncs << " fsyncs, "
+         << setprecision(1) << (logBytes / (1024.0 * 1024.0)) << " MB log)\n";
+    cout << "  edits, fsync per record  : " << setprecision(2) << perRecordMs << " ms\n";
+    cout << "  edits, group commit      : " << groupedMs << " ms\n";
+    cout << "  recovery (log replay)    : " << setprecision(1) << replayMs << " ms ("
+         << report.replayed << " records, " << (replayed.getStore().bpmColumn() == live.getStore().bpmColumn() ? "same BPM column" : "BPM MISMATCH") << ")\n";
+    cout << "  compaction copy / write  : " << copyMs << " ms on the caller / " << writeMs << " ms waited ("
+         << log.getBytes() << " log bytes left)\n";
+    remove(LOG);
+    remove(SNAP);
+}
+
+void benchReportFormatting()
+{
+    const int N = 1000000;
+    TrackManager m(N);
+    fillBenchLibrary(m, N, 97);
+
+    // the pre-TableWriter table: setw/left/right per cell
+    ostringstream viaSetw;
+    double setwMs = timeMs([&]() {
+        viaSetw << left << "Idx " << setw(TITLE_W) << "Title" << setw(TYPE_W) << "Type"
+                << right << setw(6) << "BPM" << "  " << left << setw(8) << "Energy"
+                << setw(NOTE_W) << "Notes" << "  Source\n" << string(LINE_W, '-') << "\n";
+        for (int i = 0; i < m.getSize(); i++)
+        {
+            viaSetw << setw(4) << i << " ";
+            m.printRow(viaSetw, i);
+            viaSetw << "\n";
+        }
+        viaSetw << string(LINE_W, '-') << "\n";
+    });
+
+    ostringstream viaWriter;
+    double writerMs = timeMs([&]() { m.printAll(viaWriter); });
+
+    ostringstream legacySetw;
+    double legacySetwMs = timeMs([&]() {
+        for (int i = 0; i < m.getSize(); i++)
+        {
+            Track t = m.getTrackRecord(i);
+            legacySetw << left << setw(TITLE_W) << t.title.substr(0, TITLE_W - 1)
+                       << setw(ARTIST_W) << t.artist.str().substr(0, ARTIST_W - 1)
+                       << setw(GENRE_W) << t.genre.str().substr(0, GENRE_W - 1)
+                       << setw(KEY_W) << t.key.str().substr(0, KEY_W - 1)
+                       << right << setw(6) << t.bpm << "  "
+                       << left << setw(8) << energyToString(t.energy)
+                       << setw(NOTE_W) << t.notes.substr(0, NOTE_W - 1) << "\n";
+        }
+    });
+    ostringstream legacyWriter;
+    double legacyWriterMs = timeMs([&]() {
+        TableWriter w(legacyWriter);
+        m.printRecordRows(w);
+    });
+
+    cout << "\n[report formatting] " << N << " rows\n";
+    cout << "  printAll, setw per cell      : " << fixed << setprecision(1) << setwMs << " ms\n";
+    cout << "  printAll, TableWriter        : " << writerMs << " ms ("
+         << (viaWriter.str() == viaSetw.str() ? "identical bytes" : "OUTPUT DIFFERS") << ")\n";
+    cout << "  Weeks 1-4 rows, setw + Track : " << legacySetwMs << " ms\n";
+    cout << "  Weeks 1-4 rows, TableWriter  : " << legacyWriterMs << " ms ("
+         << (legacyWriter.str() == legacySetw.str() ? "identical bytes" : "OUTPUT DIFFERS") << ")\n";
+}
+
+int main()
+{
+    cout << "==================== DJ SET ARCHITECT BENCHMARKS ====================\n";
+    benchSortBpms();
+    benchRecommendations();
+    benchColumnScans();
+    benchBulkLoad();
+    benchInlineScans();
+    benchSetBuilder();
+    benchParallelSets();
+    benchEnergyPlanner();
+    benchNeighborIndex();
+    benchTempoMatching();
+    benchTopRecommendations();
+    benchSnapshot();
+    benchCsvImport();
+    benchXmlImport();
+    benchWriteAheadLog();
+    benchReportFormatting();
+    return 0;
+}
+#endif
+
+// -------------------- Doctest Unit Tests --------------------
+#ifdef _DEBUG
+
+Track makeTrack(const string& title, const string& genre, int bpm, EnergyLevel e)
+{
+    Track t;
+    t.title = title;
+    t.artist = "Test";
+    t.genre = genre;
+    t.key = "Am";
+    t.bpm = bpm;
+    t.energy = e;
+    t.notes = "";
+    return t;
+}
+
+// -------------------- Existing Week 05 tests (keep) --------------------
+TEST_CASE("Average BPM: 0 tracks returns 0.0")
+{
+    Track lib[1];
+    CHECK(computeAverageBPM(lib, 0) == doctest::Approx(0.0));
+}
+
+TEST_CASE("Average BPM: 1 track")
+{
+    Track lib[1];
+    lib[0] = makeTrack("A", "House", 120, MEDIUM);
+    CHECK(computeAverageBPM(lib, 1) == doctest::Approx(120.0));
+}
+
+TEST_CASE("Average BPM: 2 tracks")
+{
+    Track lib[2];
+    lib[0] = makeTrack("A", "House", 120, MEDIUM);
+    lib[1] = makeTrack("B", "House", 140, HIGH);
+    CHECK(computeAverageBPM(lib, 2) == doctest::Approx(130.0));
+}
+
+TEST_CASE("Average BPM: 3 tracks")
+{
+    Track lib[3];
+    lib[0] = makeTrack("A", "House", 100, LOW);
+    lib[1] = makeTrack("B", "Techno", 110, MEDIUM);
+    lib[2] = makeTrack("C", "Techno", 130, HIGH);
+    CHECK(computeAverageBPM(lib, 3) == doctest::Approx(113.3333333));
+}
+
+TEST_CASE("Energy enum prints correct strings")
+{
+    CHECK(energyToString(LOW) == "Low");
+    CHECK(energyToString(MEDIUM) == "Medium");
+    CHECK(energyToString(HIGH) == "High");
+}
+
+TEST_CASE("Genre matches: 0 matches")
+{
+    Track lib[2];
+    lib[0] = makeTrack("A", "House", 120, MEDIUM);
+    lib[1] = makeTrack("B", "Techno", 130, HIGH);
+
+    CHECK(countGenreMatches(lib, 2, "Trance") == 0);
+}
+
+TEST_CASE("Genre matches: some matches")
+{
+    Track lib[3];
+    lib[0] = makeTrack("A", "House", 120, MEDIUM);
+    lib[1] = makeTrack("B", "House", 125, HIGH);
+    lib[2] = makeTrack("C", "Techno", 130, HIGH);
+
+    CHECK(countGenreMatches(lib, 3, "House") == 2);
+}
+
+TEST_CASE("Genre matches: all matches")
+{
+    Track lib[3];
+    lib[0] = makeTrack("A", "House", 120, MEDIUM);
+    lib[1] = makeTrack("B", "House", 125, HIGH);
+    lib[2] = makeTrack("C", "House", 130, LOW);
+
+    CHECK(countGenreMatches(lib, 3, "House") == 3);
+}
+
+TEST_CASE("TrackBase is abstract: test base behavior via derived")
+{
+    LocalTrack t("Test", 128, HIGH, "x.wav", MixNotes("n"));
+    CHECK(t.getTitle() == "Test");
+    CHECK(t.getBpm() == 128);
+    CHECK(t.getEnergy() == HIGH);
+    CHECK(t.getType() == "LocalTrack");
+}
+
+TEST_CASE("Polymorphism: base pointer calls derived override (StreamTrack)")
+{
+    TrackBase* p = new StreamTrack("S", 140, HIGH, "Apple Music", MixNotes("hi"));
+    CHECK(p->getType() == "StreamTrack");
+
+    ostringstream oss;
+    p->print(oss);
+    string out = oss.str();
+
+    CHECK(out.find("StreamTrack") != string::npos);
+    CHECK(out.find("Apple Music") != string::npos);
+
+    delete p;
+}
+
+// -------------------- Week 06 tests (still valid) --------------------
+TEST_CASE("operator==: equal LocalTrack objects")
+{
+    LocalTrack a("Song", 128, HIGH, "song.wav", MixNotes("x"));
+    LocalTrack b("Song", 100, LOW, "song.wav", MixNotes("different notes"));
+    CHECK(a == b);
+}
+
+TEST_CASE("operator==: not equal LocalTrack objects")
+{
+    LocalTrack a("Song", 128, HIGH, "song.wav", MixNotes("x"));
+    LocalTrack b("Song", 128, HIGH, "other.wav", MixNotes("x"));
+    CHECK((a == b) == false);
+}
+
+TEST_CASE("operator<<: outputs derived LocalTrack one-line summary")
+{
+    LocalTrack t("LocalName", 124, MEDIUM, "track.wav", MixNotes("n"));
+    ostringstream oss;
+    oss << t;
+    string s = oss.str();
+    CHECK(s.find("LocalTrack") != string::npos);
+    CHECK(s.find("LocalName") != string::npos);
+    CHECK(s.find("Path=track.wav") != string::npos);
+}
+
+TEST_CASE("operator<<: outputs derived StreamTrack one-line summary")
+{
+    StreamTrack t("StreamName", 140, HIGH, "Spotify", MixNotes("n"));
+    ostringstream oss;
+    oss << t;
+    string s = oss.str();
+    CHECK(s.find("StreamTrack") != string::npos);
+    CHECK(s.find("StreamName") != string::npos);
+    CHECK(s.find("Platform=Spotify") != string::npos);
+}
+
+// -------------------- Week 07 doctest updates (THROWS) --------------------
+
+// TrackManager operator[]: valid index returns correct pointer
+TEST_CASE("Week07 operator[]: valid index returns correct item pointer")
+{
+    TrackManager m(2);
+    m += new LocalTrack("A", 120, MEDIUM, "a.wav", MixNotes(""));
+
+    TrackBase* p = m[0];
+    CHECK(p != nullptr);
+    CHECK(p->getType() == "LocalTrack");
+    CHECK(p->getTitle() == "A");
+}
+
+// TrackManager operator[]: invalid index throws
+TEST_CASE("Week07 operator[]: invalid index throws")
+{
+    TrackManager m(2);
+    m += new LocalTrack("A", 120, MEDIUM, "a.wav", MixNotes(""));
+
+    CHECK_THROWS(m[99]);
+    CHECK_THROWS(m[-1]);
+}
+
+// operator+= add increases size / stores correct pointer
+TEST_CASE("operator+= add increases size and stores correct pointer")
+{
+    TrackManager m(2);
+    CHECK(m.getSize() == 0);
+
+    m += new StreamTrack("B", 125, HIGH, "Spotify", MixNotes(""));
+    CHECK(m.getSize() == 1);
+    CHECK(m[0] != nullptr);
+    CHECK(m[0]->getType() == "StreamTrack");
+}
+
+// operator-= valid removal deletes and shifts
+TEST_CASE("Week07 operator-= valid removal shifts properly")
+{
+    TrackManager m(2);
+    m += new LocalTrack("A", 120, MEDIUM, "a.wav", MixNotes(""));
+    m += new StreamTrack("B", 125, HIGH, "Spotify", MixNotes(""));
+    m += new LocalTrack("C", 130, HIGH, "c.wav", MixNotes(""));
+
+    CHECK(m.getSize() == 3);
+
+    m -= 1; // remove middle; should shift "C" to index 1
+    CHECK(m.getSize() == 2);
+
+    CHECK(m[0]->getTitle() == "A");
+    CHECK(m[1]->getTitle() == "C");
+}
+
+// operator-= invalid removal throws
+TEST_CASE("Week07 operator-= invalid removal throws")
+{
+    TrackManager m(2);
+    m += new LocalTrack("A", 120, MEDIUM, "a.wav", MixNotes(""));
+    CHECK_THROWS(m -= 5);
+    CHECK_THROWS(m -= -1);
+}
+
+// Function template tests
+TEST_CASE("Function template absValue works for int")
+{
+    CHECK(absValue(-10) == 10);
+    CHECK(absValue(5) == 5);
+}
+
+TEST_CASE("Function template absValue works for double")
+{
+    CHECK(absValue(-2.5) == doctest::Approx(2.5));
+    CHECK(absValue(3.25) == doctest::Approx(3.25));
+}
+
+// DynamicArray now throws on invalid access/removal (Week07)
+TEST_CASE("Week07 DynamicArray<int>: store/remove/resizing still works")
+{
+    DynamicArray<int> a(2);
+    CHECK(a.getSize() == 0);
+    CHECK(a.getCapacity() == 2);
+
+    a.pushBack(10);
+    a.pushBack(20);
+    a.pushBack(30); // resize
+    CHECK(a.getSize() == 3);
+    CHECK(a.getCapacity() >= 3);
+
+    CHECK(a.at(0) == 10);
+    CHECK(a.at(1) == 20);
+    CHECK(a.at(2) == 30);
+
+    a.removeAt(1);
+    CHECK(a.getSize() == 2);
+    CHECK(a.at(0) == 10);
+    CHECK(a.at(1) == 30);
+}
+
+TEST_CASE("Week07 DynamicArray throws on invalid access/removal")
+{
+    DynamicArray<int> a(2);
+    a.pushBack(1);
+
+    CHECK_THROWS(a.at(5));
+    CHECK_THROWS(a.at(-1));
+    CHECK_THROWS(a.removeAt(2));
+    CHECK_THROWS(a.removeAt(-1));
+}
+
+TEST_CASE("Week07 DynamicArray<TrackBase*> basic works and throws on invalid")
+{
+    DynamicArray<TrackBase*> a(2);
+    TrackBase* p1 = new LocalTrack("A", 120, MEDIUM, "a.wav", MixNotes(""));
+    TrackBase* p2 = new StreamTrack("B", 125, HIGH, "Spotify", MixNotes(""));
+
+    a.pushBack(p1);
+    a.pushBack(p2);
+
+    CHECK(a.getSize() == 2);
+    CHECK(a.at(0)->getType() == "LocalTrack");
+    CHECK(a.at(1)->getType() == "StreamTrack");
+    CHECK_THROWS(a.at(99));
+    CHECK_THROWS(a.removeAt(99));
+
+    // Clean up (template does not own pointed-to objects)
+    delete p1;
+    delete p2;
+}
+
+// Library engine: raw-storage DynamicArray (move-aware growth, reserve, emplaceBack)
+
+// Counts how a DynamicArray treats its elements (copies vs moves vs default constructions).
+struct LifetimeProbe
+{
+    static int defaults;
+    static int copies;
+    static int moves;
+    static int alive;
+
+    int value;
+
+    LifetimeProbe() : value(0) { defaults++; alive++; }
+    LifetimeProbe(int v) : value(v) { alive++; }
+    LifetimeProbe(const LifetimeProbe& o) : value(o.value) { copies++; alive++; }
+    LifetimeProbe(LifetimeProbe&& o) noexcept : value(o.value) { moves++; alive++; }
+    LifetimeProbe& operator=(const LifetimeProbe& o) { value = o.value; copies++; return *this; }
+    LifetimeProbe& operator=(LifetimeProbe&& o) noexcept { value = o.value; moves++; return *this; }
+    ~LifetimeProbe() { alive--; }
+
+    static void reset() { defaults = copies = moves = alive = 0; }
+};
+int LifetimeProbe::defaults = 0;
+int LifetimeProbe::copies = 0;
+int LifetimeProbe::moves = 0;
+int LifetimeProbe::alive = 0;
+
+TEST_CASE("DynamicArray growth moves elements and never default-constructs spare slots")
+{
+    LifetimeProbe::reset();
+    {
+        DynamicArray<LifetimeProbe> a(2);
+        CHECK(LifetimeProbe::defaults == 0); // raw storage: nothing constructed up front
+
+        for (int i = 0; i < 9; i++)
+            a.emplaceBack(i);
+
+        CHECK(a.getSize() == 9);
+        CHECK(a.getCapacity() == 16);
+        CHECK(LifetimeProbe::defaults == 0);
+        CHECK(LifetimeProbe::copies == 0);  // growth relocates by move
+        CHECK(LifetimeProbe::alive == 9);   // old buffers' objects were destroyed
+
+        a.removeAt(0);                      // shifting also moves
+        CHECK(LifetimeProbe::copies == 0);
+        CHECK(a.rawAt(0).value == 1);
+        CHECK(a.rawAt(7).value == 8);
+        CHECK(LifetimeProbe::alive == 8);
+    }
+    CHECK(LifetimeProbe::alive == 0); // destructor ends every live element
+}
+
+TEST_CASE("DynamicArray reserve/shrinkToFit adjust capacity without touching contents")
+{
+    DynamicArray<string> a(2);
+    a.reserve(100);
+    CHECK(a.getCapacity() == 100);
+    a.reserve(10); // never shrinks
+    CHECK(a.getCapacity() == 100);
+
+    a.pushBack("alpha");
+    a.emplaceBack(3, 'x');
+    a.shrinkToFit();
+    CHECK(a.getCapacity() == 2);
+    CHECK(a.at(0) == "alpha");
+    CHECK(a.at(1) == "xxx");
+
+    // pushBack of an element of the same array while it must grow
+    a.pushBack(a.rawAt(0));
+    CHECK(a.getSize() == 3);
+    CHECK(a.at(2) == "alpha");
+}
+
+TEST_CASE("DynamicArray<int> trivially copyable path keeps order across growth and removal")
+{
+    DynamicArray<int> a(2);
+    for (int i = 0; i < 1000; i++)
+        a.pushBack(i);
+    for (int i = 0; i < 500; i++)
+        a.removeAt(0);
+
+    CHECK(a.getSize() == 500);
+    CHECK(a.at(0) == 500);
+    CHECK(a.at(499) == 999);
+    CHECK(a.getCapacity() < 2048); // shrank after many removals
+
+    DynamicArray<int> b(move(a));
+    CHECK(b.getSize() == 500);
+    CHECK(a.getSize() == 0);
+    a.pushBack(7); // moved-from array is still usable
+    CHECK(a.at(0) == 7);
+}
+
+// Week 08 tests
+
+TEST_CASE("Week08 recursive countHighEnergyRecursive: counts HIGH tracks correctly")
+{
+    TrackManager m(2);
+    m += new LocalTrack("A", 120, LOW, "a.wav", MixNotes(""));
+    m += new StreamTrack("B", 125, HIGH, "Spotify", MixNotes(""));
+    m += new LocalTrack("C", 130, HIGH, "c.wav", MixNotes(""));
+    m += new StreamTrack("D", 128, MEDIUM, "Apple Music", MixNotes(""));
+
+    CHECK(m.countHighEnergyRecursive() == 2);
+}
+
+TEST_CASE("Week08 recursive countHighEnergyRecursive: no HIGH tracks returns 0")
+{
+    TrackManager m(2);
+    m += new LocalTrack("A", 120, LOW, "a.wav", MixNotes(""));
+    m += new StreamTrack("B", 125, MEDIUM, "Spotify", MixNotes(""));
+
+    CHECK(m.countHighEnergyRecursive() == 0);
+}
+
+TEST_CASE("Week08 recursive countHighEnergyRecursive: empty manager returns 0")
+{
+    TrackManager m(2);
+    CHECK(m.countHighEnergyRecursive() == 0);
+}
+
+// ==================== Week 09 Tests: vector, sequential search, sort, binary search ====================
+
+// Test 1: vector .push_back() grows bpmList; .at() retrieves correct values
+TEST_CASE("Week09 vector: push_back stores BPMs and .at() retrieves them")
+{
+    TrackManager m(2);
+    CHECK(m.getBpmCount() == 0); // empty vector (edge case)
+
+    m += new LocalTrack("A", 120, MEDIUM, "a.wav", MixNotes(""));
+    m += new StreamTrack("B", 135, HIGH, "Spotify", MixNotes(""));
+
+    CHECK(m.getBpmCount() == 2);    // .size() via getBpmCount()
+    CHECK(m.getBpmAt(0) == 120);    // .at(0)
+    CHECK(m.getBpmAt(1) == 135);    // .at(1)
+}
+
+// Test 2: sequential search — found returns index; not found or empty returns -1
+TEST_CASE("Week09 sequentialSearchBpm: found returns index, not found or empty returns -1")
+{
+    TrackManager empty(2);
+    CHECK(empty.sequentialSearchBpm(128) == -1); // edge case: empty vector
+
+    TrackManager m(2);
+    m += new LocalTrack("A", 120, MEDIUM, "a.wav", MixNotes(""));
+    m += new StreamTrack("B", 135, HIGH, "Spotify", MixNotes(""));
+
+    CHECK(m.sequentialSearchBpm(135) == 1);  // found
+    CHECK(m.sequentialSearchBpm(999) == -1); // not found
+}
+
+// Test 3: bubble sort — out-of-order BPMs sorted ascending
+TEST_CASE("Week09 sortBpmsBubble: sorts BPM values into ascending order")
+{
+    TrackManager m(2);
+    m += new LocalTrack("A", 150, HIGH, "a.wav", MixNotes(""));
+    m += new StreamTrack("B", 120, MEDIUM, "Spotify", MixNotes(""));
+    m += new LocalTrack("C", 135, HIGH, "c.wav", MixNotes(""));
+
+    m.sortBpmsBubble();
+
+    CHECK(m.getBpmAt(0) == 120);
+    CHECK(m.getBpmAt(1) == 135);
+    CHECK(m.getBpmAt(2) == 150);
+}
+
+// Test 4: binary search — requires sort first; finds element or returns -1
+TEST_CASE("Week09 binarySearchBpm: finds element after sort; returns -1 if not found or empty")
+{
+    TrackManager empty(2);
+    CHECK(empty.binarySearchBpm(128) == -1); // edge case: empty vector
+
+    TrackManager m(2);
+    m += new LocalTrack("A", 150, HIGH, "a.wav", MixNotes(""));
+    m += new StreamTrack("B", 120, MEDIUM, "Spotify", MixNotes(""));
+    m += new LocalTrack("C", 135, HIGH, "c.wav", MixNotes(""));
+
+    m.sortBpmsBubble(); // must sort before binary search — [120, 135, 150]
+    CHECK(m.binarySearchBpm(135) == 1);  // found at index 1
+    CHECK(m.binarySearchBpm(999) == -1); // not found
+}
+
+// ==================== Library Engine: counting sort ====================
+
+TEST_CASE("countingSortOrder returns a stable ascending permutation")
+{
+    vector<int> bpms = { 128, 90, 128, 200, 60, 90 };
+    vector<int> order = countingSortOrder(bpms);
+
+    REQUIRE(order.size() == bpms.size());
+    CHECK(order == vector<int>({ 4, 1, 5, 0, 2, 3 })); // equal BPMs keep library order
+
+    CHECK(countingSortOrder(vector<int>()).empty()); // edge case: empty
+}
+
+TEST_CASE("countingSortOrder falls back gracefully for unvalidated BPM values")
+{
+    vector<int> bpms = { 5000000, -3, 120 };
+    CHECK(countingSortOrder(bpms) == vector<int>({ 1, 2, 0 }));
+}
+
+TEST_CASE("sortByBpm reorders items and bpmList together")
+{
+    TrackManager m(2);
+    m += new LocalTrack("A", 150, HIGH, "a.wav", MixNotes(""));
+    m += new StreamTrack("B", 120, MEDIUM, "Spotify", MixNotes(""));
+    m += new LocalTrack("C", 135, HIGH, "c.wav", MixNotes(""));
+
+    vector<int> order = m.sortByBpm();
+    CHECK(order == vector<int>({ 1, 2, 0 }));
+
+    for (int i = 0; i < m.getSize(); i++)
+        CHECK(m.getBpmAt(i) == m[i]->getBpm()); // still aligned
+
+    int idx = m.binarySearchBpm(135);
+    REQUIRE(idx == 1);
+    CHECK(m[idx]->getTitle() == "C"); // sorted index is usable with operator[]
+}
 
-            manager.printAll(cout);
-            int idx = safeIndexFromUser("Enter index to remove: ", manager.getSize());
+// ==================== Library Engine: sorted view ====================
 
-            // operator-= now throws if invalid removal
-            try
-            {
-                manager -= idx;
-                cout << "Removed item " << idx << ".\n";
-            }
-            catch (const exception& ex)
-            {
-                cout << "Remove failed: " << ex.what() << "\n";
-            }
+TEST_CASE("Sorted view finds real tracks without reordering the library")
+{
+    TrackManager m(2);
+    m += new LocalTrack("A", 150, HIGH, "a.wav", MixNotes(""));
+    m += new StreamTrack("B", 120, MEDIUM, "Spotify", MixNotes(""));
+    m += new LocalTrack("C", 135, HIGH, "c.wav", MixNotes(""));
+    m += new StreamTrack("D", 120, LOW, "Tidal", MixNotes(""));
 
-            break;
-        }
-        case 9:
-            manager.saveReport("DJ_Set_Report_Week7.txt");
-            break;
+    CHECK(m.findTrackByBpm(135)->getTitle() == "C");
+    CHECK(m.findIndexByBpm(120) == 1); // first 120 in library order
+    CHECK(m.findTrackByBpm(999) == nullptr);
+    CHECK(m.findIndexByBpm(60) == -1);
 
-        // -------------------- Week 09: Sequential Search --------------------
-        case 10:
-        {
-            if (manager.getBpmCount() == 0)
-            {
-                cout << "No tracks in Week 09 library yet. Add some first (options 5 or 6).\n";
-                break;
-            }
-            int target = getValidatedInt("Enter BPM to search for (60-200): ", BPM_MIN, BPM_MAX);
-            int idx = manager.sequentialSearchBpm(target);
-            if (idx == -1)
-                cout << "BPM " << target << " not found (sequential search).\n";
-            else
-                cout << "BPM " << target << " found at index " << idx
-                     << " (sequential search): " << *manager[idx] << "\n";
-            break;
-        }
+    CHECK(m.sortedAt(0)->getTitle() == "B");
+    CHECK(m.sortedAt(1)->getTitle() == "D");
+    CHECK(m.sortedAt(3)->getTitle() == "A");
+    CHECK_THROWS(m.sortedAt(4));
 
-        // -------------------- Week 09: Bubble Sort + Binary Search --------------------
-        case 11:
-        {
-            if (manager.getBpmCount() == 0)
-            {
-                cout << "No tracks in Week 09 library yet. Add some first (options 5 or 6).\n";
-                break;
-            }
-            // Sort must come before binary search
-            manager.sortBpmsBubble();
-            cout << "BPM list sorted (bubble sort).\n";
+    CHECK(m.findIndexesInBpmRange(120, 140) == vector<int>({ 1, 3, 2 }));
+    CHECK(m.findIndexesInBpmRange(160, 200).empty());
 
-            cout << "Sorted BPMs: ";
-            for (int i = 0; i < manager.getBpmCount(); i++)
-                cout << manager.getBpmAt(i) << " ";
-            cout << "\n";
+    // library order untouched
+    CHECK(m[0]->getTitle() == "A");
+    CHECK(m.getBpmAt(0) == 150);
+}
 
-            int target = getValidatedInt("Enter BPM to binary search for (60-200): ", BPM_MIN, BPM_MAX);
-            int idx = manager.binarySearchBpm(target);
-            if (idx == -1)
-                cout << "BPM " << target << " not found (binary search).\n";
-            else
-                cout << "BPM " << target << " found at sorted index " << idx << ".\n";
-            break;
-        }
+TEST_CASE("Sorted view is rebuilt after add/remove")
+{
+    TrackManager m(2);
+    m += new LocalTrack("A", 150, HIGH, "a.wav", MixNotes(""));
+    CHECK(m.findTrackByBpm(128) == nullptr);
 
-        case 12:
-            cout << "\nGoodbye, " << djName << "! Keep the crowd moving.\n";
-            break;
+    m += new LocalTrack("B", 128, HIGH, "b.wav", MixNotes(""));
+    CHECK(m.findTrackByBpm(128)->getTitle() == "B");
 
-        default:
-            cout << "Invalid choice.\n";
-        }
+    m -= 0; // B shifts to index 0
+    CHECK(m.findIndexByBpm(128) == 0);
+    CHECK(m.findTrackByBpm(150) == nullptr);
+}
 
-    } while (choice != 12);
+TEST_CASE("sortBpmsBubble keeps items aligned with bpmList")
+{
+    TrackManager m(2);
+    m += new LocalTrack("A", 150, HIGH, "a.wav", MixNotes(""));
+    m += new StreamTrack("B", 120, MEDIUM, "Spotify", MixNotes(""));
 
-    return 0;
+    m.sortBpmsBubble();
+    CHECK(m[0]->getTitle() == "B");
+    CHECK(m[0]->getBpm() == m.getBpmAt(0));
 }
-#endif
 
-// -------------------- UI Functions --------------------
-void showBanner()
+// ==================== Library Engine: BPM bucket index ====================
+
+TEST_CASE("BpmBucketIndex window query visits only the requested buckets")
 {
-    cout << "=============================================\n";
-    cout << "        DJ SET ARCHITECT - C++ EDITION       \n";
-    cout << " Weeks 1-4 + Weeks 5/6/7/09 Upgrade Combined \n"; // Week 09: updated banner
-    cout << "=============================================\n";
+    BpmBucketIndex idx;
+    idx.insert(0, 120);
+    idx.insert(1, 125);
+    idx.insert(2, 126);
+    idx.insert(3, 60);
+    idx.insert(4, 250); // unvalidated outlier
+
+    vector<int> out;
+    idx.collectWindow(120, 5, out);
+    CHECK(out == vector<int>({ 0, 1 }));
+
+    out.clear();
+    idx.collectWindow(62, 5, out); // clamps at BPM_MIN
+    CHECK(out == vector<int>({ 3 }));
+
+    out.clear();
+    idx.collectWindow(200, 50, out); // outliers are still found
+    CHECK(out == vector<int>({ 4 }));
+
+    CHECK(idx.bucketSize(125) == 1);
+    CHECK(idx.bucketSize(250) == 1);
+    CHECK(idx.getCount() == 5);
+
+    CHECK(idx.bucket(BPM_MIN) == vector<int>({ 3 }));
+    CHECK(idx.bucket(BPM_MAX).empty());
+    CHECK_THROWS_AS(idx.bucket(250), out_of_range); // outliers have no bucket
+    CHECK_THROWS_AS(idx.bucket(BPM_MIN - 1), out_of_range);
+    CHECK_THROWS_AS(idx.bucket(-5), out_of_range);
 }
 
-void showMenu()
+TEST_CASE("recommendNext follows the BPM/energy rule and tracks add/remove")
 {
-    cout << "\n-------------------- MENU --------------------\n";
-    cout << "WEEKS 1-4 (Struct + Array)\n";
-    cout << "1) Add a track to library\n";
-    cout << "2) View library summary\n";
-    cout << "3) Recommend next tracks (BPM/Energy rules)\n";
-    cout << "4) Save report to file\n\n";
+    TrackManager m(2);
+    m += new LocalTrack("A", 128, MEDIUM, "a.wav", MixNotes(""));
+    m += new StreamTrack("B", 130, HIGH, "Spotify", MixNotes(""));
+    m += new LocalTrack("C", 131, LOW, "c.wav", MixNotes(""));      // energy drops
+    m += new StreamTrack("D", 140, MEDIUM, "Tidal", MixNotes(""));  // too fast
+    m += new LocalTrack("E", 126, MEDIUM, "e.wav", MixNotes(""));
+
+    vector<TrackId> first = m.recommendNext(128, MEDIUM, 5);
+    REQUIRE(first.size() == 3);
+    CHECK(m.indexOf(first[0]) == 4); // E (126)
+    CHECK(m.indexOf(first[1]) == 0); // A (128)
+    CHECK(m.indexOf(first[2]) == 1); // B (130)
+    CHECK(m.countAtBpm(130) == 1);
+
+    m -= 0; // remove A; E moves into position 0
+    vector<TrackId> hits = m.recommendNext(128, MEDIUM, 5);
+    REQUIRE(hits.size() == 2);
+    CHECK(m.at(hits[0])->getTitle() == "E");
+    CHECK(m.at(hits[1])->getTitle() == "B");
+    CHECK(m.countAtBpm(128) == 0);
+
+    m.sortByBpm(); // reorder: handles stay valid, no index rebuild needed
+    CHECK(m.recommendNext(128, MEDIUM, 5) == hits);
+    CHECK(m.at(hits[0])->getTitle() == "E");
+}
 
-    cout << "WEEK 5+ (Abstract + Polymorphism + Operators + Templates + Exceptions)\n";
-    cout << "5) Add Local Track\n";
-    cout << "6) Add Stream Track\n";
-    cout << "7) View library\n";
-    cout << "8) Remove track by index\n";
-    cout << "9) Save report to file\n\n";
+TEST_CASE("TrackManager rejects BPMs the 16-bit column would clamp")
+{
+    TrackManager m(2);
+    m += new LocalTrack("Outlier", 999, LOW, "o.wav", MixNotes("")); // unvalidated but exact
+    CHECK(m.getBpmAt(0) == 999);
 
-    cout << "WEEK 09 (Vector + Search + Sort)\n";
-    cout << "10) Sequential search BPM in library\n";
-    cout << "11) Sort library BPMs then binary search\n\n";
+    CHECK_THROWS_AS(m += new LocalTrack("Neg", -5, LOW, "n.wav", MixNotes("")), DJException);
+    CHECK_THROWS_AS(m.emplaceStream("Huge", 70000, HIGH, "Spotify", MixNotes("")), DJException);
+    CHECK(m.getSize() == 1);
 
-    cout << "12) Quit\n";
-    cout << "----------------------------------------------\n";
+    CHECK_THROWS_AS(m.updateBpm(0, 65536), DJException);
+    CHECK(m[0]->getBpm() == 999); // the object and the column still agree
+    CHECK(m.getBpmAt(0) == 999);
+    CHECK(m.countAtBpm(999) == 1);
+
+    m.updateBpm(0, 65535);
+    CHECK(m.getBpmAt(0) == 65535);
+    CHECK(m.getMaxBpm() == 65535);
 }
 
-int getMenuChoice(int minChoice, int maxChoice)
+// ==================== Library Engine: SIMD column scans ====================
+
+TEST_CASE("Every available SIMD level matches the scalar kernel")
 {
-    int choice;
-    while (true)
+    // 1000 values: exercises full vectors and the scalar tail
+    vector<uint16_t> col;
+    for (int i = 0; i < 1000; i++)
+        col.push_back(static_cast<uint16_t>(BPM_MIN + (i * 37) % BPM_BUCKETS));
+    col.push_back(0xFFFF);
+
+    ColumnScanner scalar = ColumnScanner::forLevel(SIMD_SCALAR);
+    CHECK(scalar.level == SIMD_SCALAR);
+
+    for (int level = SIMD_SCALAR; level <= SIMD_AVX2; level++)
     {
-        cout << "Enter choice (" << minChoice << "-" << maxChoice << "): ";
+        ColumnScanner sc = ColumnScanner::forLevel(static_cast<SimdLevel>(level));
+        CHECK(sc.level <= detectSimdLevel());
 
-        if (cin >> choice && choice >= minChoice && choice <= maxChoice)
+        for (int target : { 60, 128, 200, 0xFFFF, 5 })
         {
-            cin.ignore(numeric_limits<streamsize>::max(), '\n');
-            return choice;
+            vector<int> expected, actual;
+            scalar.findAll(col, target, target, expected);
+            sc.findAll(col, target, target, actual);
+            CHECK(actual == expected);
+            CHECK(sc.count(col, target, target) == static_cast<int>(expected.size()));
         }
 
-        cout << "Invalid menu choice. Try again.\n";
-        cin.clear();
-        cin.ignore(numeric_limits<streamsize>::max(), '\n');
+        CHECK(sc.count(col, 120, 130) == scalar.count(col, 120, 130));
+        CHECK(sc.count(col, 0, 0xFFFF) == 1001);
+        CHECK(sc.count(col, 130, 120) == 0); // empty range
     }
 }
 
-// -------------------- Input Helpers --------------------
-string getNonEmptyLine(const string& prompt)
+TEST_CASE("findAllBpm returns every match; counts cover BPM and energy columns")
 {
-    string value;
-    do
+    TrackManager m(2);
+    CHECK(m.findAllBpm(128).empty()); // edge case: empty library
+
+    m += new LocalTrack("A", 128, HIGH, "a.wav", MixNotes(""));
+    m += new StreamTrack("B", 120, MEDIUM, "Spotify", MixNotes(""));
+    m += new LocalTrack("C", 128, LOW, "c.wav", MixNotes(""));
+    m += new StreamTrack("D", 140, HIGH, "Tidal", MixNotes(""));
+
+    CHECK(m.findAllBpm(128) == vector<int>({ 0, 2 }));
+    CHECK(m.findAllBpm(999).empty());
+    CHECK(m.countBpmEqual(128) == 2);
+    CHECK(m.countBpmInRange(120, 130) == 3);
+    CHECK(m.findAllBpmInRange(125, 145) == vector<int>({ 0, 2, 3 }));
+
+    CHECK(m.findAllEnergy(HIGH) == vector<int>({ 0, 3 }));
+    CHECK(m.countEnergy(LOW) == 1);
+    CHECK(m.countEnergyInRange(MEDIUM, HIGH) == 3);
+
+    m -= 0; // D moves into position 0
+    CHECK(m.findAllBpm(128) == vector<int>({ 2 }));
+    m.sortByBpm(); // B(120), C(128), D(140)
+    CHECK(m.findAllEnergy(HIGH) == vector<int>({ 2 }));
+}
+
+// ==================== Library Engine: columnar TrackStore ====================
+
+TEST_CASE("TrackStore keeps every column aligned through add/remove/permute")
+{
+    TrackStore st(2);
+    LocalTrack* a = new LocalTrack("A", 150, HIGH, "a.wav", MixNotes(""));
+    StreamTrack* b = new StreamTrack("B", 120, LOW, "Spotify", MixNotes(""));
+    LocalTrack* c = new LocalTrack("C", 135, MEDIUM, "c.wav", MixNotes(""));
+    a->setGenre("House");
+    b->setGenre("Techno");
+    c->setGenre("House");
+    c->setKey("Am");
+
+    st.pushBack(a);
+    st.pushBack(b);
+    st.pushBack(c);
+
+    CHECK(st.getSize() == 3);
+    CHECK(st.bpmColumn() == vector<uint16_t>({ 150, 120, 135 }));
+    CHECK(st.typeAt(1) == TAG_STREAM);
+    CHECK(st.typeAt(2) == TAG_LOCAL);
+    CHECK(st.genreColumn()[0] == st.genreColumn()[2]); // same genre -> same id
+    CHECK(Symbol::fromId(st.genreColumn()[1]).str() == "Techno");
+    CHECK(Symbol::fromId(st.keyColumn()[2]).str() == "Am");
+    CHECK(st.keyColumn()[0] == 0); // unknown key -> "" id
+
+    st.permute(vector<int>({ 1, 2, 0 }));
+    CHECK(st.handle(0) == b);
+    CHECK(st.bpmColumn() == vector<uint16_t>({ 120, 135, 150 }));
+    CHECK(st.energyAt(0) == LOW);
+    CHECK(st.titles().name(st.titleColumn()[2]) == "A");
+
+    TrackId idOfB = st.idAt(0);
+    TrackId idOfA = st.idAt(2);
+    st.swapRemove(0); // A (last row) moves into row 0
+    CHECK(st.handle(0) == a);
+    CHECK(st.energyAt(1) == MEDIUM);
+    CHECK(st.rowOf(idOfA) == 0);
+    CHECK(st.rowOf(idOfB) == -1);
+    CHECK_THROWS(st.swapRemove(5));
+
+    delete a;
+    delete b;
+    delete c;
+}
+
+TEST_CASE("TrackManager genre counts and edits run over the dense columns")
+{
+    TrackManager m(2);
+    TrackBase* a = new LocalTrack("A", 128, HIGH, "a.wav", MixNotes(""));
+    TrackBase* b = new StreamTrack("B", 124, MEDIUM, "Spotify", MixNotes(""));
+    a->setGenre("House");
+    b->setGenre("House");
+    m += a;
+    m += b;
+    m += new LocalTrack("C", 140, HIGH, "c.wav", MixNotes(""));
+
+    CHECK(m.countGenre("House") == 2);
+    CHECK(m.countGenre("Trance") == 0);
+    CHECK(m.countHighEnergyRecursive() == 2);
+
+    m.updateGenre(2, "House");
+    CHECK(m.countGenre("House") == 3);
+
+    m.updateBpm(0, 140);
+    CHECK(m[0]->getBpm() == 140);
+    CHECK(m.getBpmAt(0) == 140);
+    CHECK(m.countAtBpm(128) == 0);
+    CHECK(m.countAtBpm(140) == 2);
+
+    m.updateEnergy(1, HIGH);
+    CHECK(m.countHighEnergyRecursive() == 3);
+    CHECK_THROWS(m.updateEnergy(7, LOW));
+}
+
+// ==================== Library Engine: slab pools ====================
+
+TEST_CASE("SlabPool makes one allocation per slab and reuses freed slots")
+{
+    SlabPool<LocalTrack> pool(4);
+    vector<LocalTrack*> live;
+    for (int i = 0; i < 10; i++)
+        live.push_back(pool.create("T" + to_string(i), 120, MEDIUM, "t.wav", MixNotes("")));
+
+    CHECK(pool.getStats().slabAllocations == 3); // 4 + 4 + 2 objects
+    CHECK(pool.getStats().capacity == 12);
+    CHECK(pool.getStats().liveObjects == 10);
+    CHECK(live[9]->getTitle() == "T9");
+
+    pool.destroy(live[3]);
+    LocalTrack* again = pool.create("Again", 128, HIGH, "a.wav", MixNotes(""));
+    CHECK(again == live[3]); // free-list slot reused
+    CHECK(pool.getStats().reusedSlots == 1);
+    CHECK(pool.getStats().slabAllocations == 3);
+    live[3] = again;
+
+    for (LocalTrack* p : live)
+        pool.destroy(p);
+    CHECK(pool.getStats().liveObjects == 0);
+}
+
+TEST_CASE("TrackManager pooled and heap tracks coexist through remove/sort/destroy")
+{
+    TrackManager m(2, 8);
+    for (int i = 0; i < 20; i++)
     {
-        cout << prompt;
-        getline(cin, value);
+        if (i % 2 == 0)
+            m.emplaceLocal("L" + to_string(i), 100 + i, MEDIUM, "l.wav", MixNotes(""));
+        else
+            m.emplaceStream("S" + to_string(i), 100 + i, HIGH, "Spotify", MixNotes(""));
+    }
+    m += new LocalTrack("Heap", 90, LOW, "h.wav", MixNotes("")); // operator+= still adopts new'd tracks
 
-        if (value.empty())
-            cout << "Input cannot be empty. Please try again.\n";
+    CHECK(m.getSize() == 21);
+    CHECK(m.getLocalPoolStats().slabAllocations == 2);  // 10 locals, 8 per slab
+    CHECK(m.getStreamPoolStats().slabAllocations == 2);
+    CHECK(m[1]->getType() == "StreamTrack");
 
-    } while (value.empty());
+    m -= 0;  // pooled local; the heap track (last) moves into position 0
+    m -= 19; // pooled stream
+    CHECK(m.getLocalPoolStats().liveObjects == 9);
 
-    return value;
+    m.emplaceLocal("Reuse", 150, HIGH, "r.wav", MixNotes(""));
+    CHECK(m.getLocalPoolStats().reusedSlots == 1);
+    CHECK(m.getLocalPoolStats().slabAllocations == 2);
+
+    m.sortByBpm();
+    CHECK(m[m.getSize() - 1]->getTitle() == "Reuse");
+    // destructor releases pooled and heap tracks (checked by leak tools)
 }
 
-int getValidatedInt(const string& prompt, int minVal, int maxVal)
+// ==================== Library Engine: string interning ====================
+
+TEST_CASE("Symbol interns equal strings to the same id")
 {
-    int value;
-    while (true)
+    Symbol a("Drum & Bass");
+    Symbol b(string("Drum & Bass"));
+    Symbol c("Garage");
+
+    CHECK(a == b);
+    CHECK(a != c);
+    CHECK(a.getId() == b.getId());
+    CHECK(a.str() == "Drum & Bass");
+    CHECK(Symbol().empty());
+    CHECK(Symbol("").getId() == 0);
+    CHECK(SymbolTable::global().find("never-interned-genre-xyz") == -1);
+
+    ostringstream oss;
+    oss << c;
+    CHECK(oss.str() == "Garage");
+}
+
+TEST_CASE("Track and StreamTrack store interned fields compactly")
+{
+    CHECK(sizeof(Symbol) == 4);
+
+    Track t = makeTrack("A", "House", 120, MEDIUM);
+    CHECK(t.genre.str() == "House");
+    CHECK(t.artist == Symbol("Test"));
+
+    StreamTrack s1("S1", 128, HIGH, "Beatport", MixNotes(""));
+    StreamTrack s2("S2", 130, HIGH, "Beatport", MixNotes(""));
+    CHECK(s1.getPlatformSymbol() == s2.getPlatformSymbol());
+    CHECK(s1.getPlatform() == "Beatport");
+    s2.setPlatform("Tidal");
+    CHECK(s2.getPlatform() == "Tidal");
+}
+
+// ==================== Library Engine: TrackId handles ====================
+
+TEST_CASE("TrackId survives removals and sorting; stale ids are detected")
+{
+    TrackManager m(2);
+    TrackId a = m.add(new LocalTrack("A", 150, HIGH, "a.wav", MixNotes("")));
+    TrackId b = m.emplaceStream("B", 120, MEDIUM, "Spotify", MixNotes(""));
+    TrackId c = m.emplaceLocal("C", 135, LOW, "c.wav", MixNotes(""));
+
+    CHECK(m.at(b)->getTitle() == "B");
+    CHECK(m.idAt(2) == c);
+
+    m.sortByBpm(); // B, C, A
+    CHECK(m.indexOf(a) == 2);
+    CHECK(m.at(a)->getTitle() == "A");
+
+    m.remove(b);
+    CHECK_FALSE(m.contains(b));
+    CHECK(m.find(b) == nullptr);
+    CHECK_THROWS_AS(m.at(b), DJException);
+    CHECK_THROWS_AS(m.remove(b), DJException);
+    CHECK(m.at(c)->getTitle() == "C"); // others unaffected
+    CHECK(m.at(a)->getTitle() == "A");
+
+    // the freed slot is reused with a new generation: the old id stays stale
+    TrackId d = m.emplaceLocal("D", 128, HIGH, "d.wav", MixNotes(""));
+    CHECK(d.slot == b.slot);
+    CHECK(d != b);
+    CHECK(m.find(b) == nullptr);
+    CHECK(m.at(d)->getTitle() == "D");
+
+    CHECK_FALSE(TrackId().isValid());
+    CHECK(m.find(TrackId()) == nullptr);
+    CHECK_THROWS(m.idAt(10));
+}
+
+TEST_CASE("Removal is O(1) swap-with-last and keeps every index consistent")
+{
+    TrackManager m(2);
+    vector<TrackId> ids;
+    for (int i = 0; i < 50; i++)
+        ids.push_back(m.emplaceLocal("T" + to_string(i), BPM_MIN + i, static_cast<EnergyLevel>(1 + i % 3), "t.wav", MixNotes("")));
+
+    for (int i = 0; i < 50; i += 2)
+        m.remove(ids[i]);
+
+    CHECK(m.getSize() == 25);
+    for (int i = 1; i < 50; i += 2)
     {
-        cout << prompt;
+        REQUIRE(m.contains(ids[i]));
+        int row = m.indexOf(ids[i]);
+        CHECK(m[row]->getTitle() == "T" + to_string(i));
+        CHECK(m.getBpmAt(row) == BPM_MIN + i);
+        CHECK(m.idAt(row) == ids[i]);
+        CHECK(m.countAtBpm(BPM_MIN + i) == 1);
+        CHECK(m.countAtBpm(BPM_MIN + i - 1) == 0);
+    }
+}
 
-        if (cin >> value && value >= minVal && value <= maxVal)
-        {
-            cin.ignore(numeric_limits<streamsize>::max(), '\n');
-            return value;
-        }
+// ==================== Library Engine: unified library ====================
 
-        cout << "Invalid number. Enter " << minVal << " to " << maxVal << ".\n";
-        cin.clear();
-        cin.ignore(numeric_limits<streamsize>::max(), '\n');
+TEST_CASE("Weeks 1-4 records live in TrackManager beyond the old 7-track cap")
+{
+    TrackManager m(2);
+    for (int i = 0; i < 20; i++)
+    {
+        Track t = makeTrack("T" + to_string(i), (i % 2 == 0) ? "House" : "Techno", 120 + i, MEDIUM);
+        t.notes = "note " + to_string(i);
+        m.addTrackRecord(t);
     }
+    m.emplaceStream("Stream", 150, HIGH, "Spotify", MixNotes("s"));
+
+    CHECK(m.getSize() == 21);
+    CHECK(countGenreMatches(m, "House") == 10);
+    CHECK(countGenreMatches(m, "Trance") == 0);
+    CHECK(computeAverageBPM(m) == doctest::Approx((20 * 120 + 190 + 150) / 21.0));
+
+    Track back = m.getTrackRecord(3);
+    CHECK(back.title == "T3");
+    CHECK(back.artist.str() == "Test");
+    CHECK(back.genre.str() == "Techno");
+    CHECK(back.key.str() == "Am");
+    CHECK(back.bpm == 123);
+    CHECK(back.notes == "note 3");
+    CHECK(m.notesAt(20) == "s");
+    CHECK_THROWS(m.getTrackRecord(21));
+
+    TrackManager empty(2);
+    CHECK(computeAverageBPM(empty) == doctest::Approx(0.0));
 }
 
-double getValidatedDouble(const string& prompt, double minVal, double maxVal)
+TEST_CASE("Legacy report is written from the shared library")
 {
-    double value;
-    while (true)
+    TrackManager m(2);
+    Track t = makeTrack("love me hate me", "rap", 75, MEDIUM);
+    t.artist = "pig";
+    t.key = "c min";
+    t.notes = "4";
+    m.addTrackRecord(t);
+
+    ostringstream oss;
+    writeLegacyReport(oss, m);
+    string report = oss.str();
+
+    CHECK(report.find("Tracks stored: 1") != string::npos);
+    CHECK(report.find("love me hate me       pig               rap         c min     75  Medium  4") != string::npos);
+    CHECK(report.find("Average BPM: 75.0") != string::npos);
+
+    TrackManager empty(2);
+    ostringstream none;
+    writeLegacyReport(none, empty);
+    CHECK(none.str().find("No tracks saved.") != string::npos);
+}
+
+// ==================== Library Engine: inline variant tracks ====================
+
+TEST_CASE("InlineTrackList matches the pointer-based library")
+{
+    TrackManager m(2);
+    m.emplaceLocal("Local A", 124, HIGH, "a.wav", MixNotes("intro"));
+    m.emplaceStream("Stream B", 128, LOW, "Spotify", MixNotes(""));
+    m.emplaceLocal("Local C", 130, HIGH, "c.wav", MixNotes(""));
+
+    InlineTrackList list = m.toInlineList();
+    REQUIRE(list.getSize() == 3);
+    CHECK(list.sumBpm() == 124 + 128 + 130);
+    CHECK(list.countEnergy(HIGH) == 2);
+    CHECK(list.countEnergy(MEDIUM) == 0);
+
+    // TrackBase adapter
+    CHECK(list[1].getType() == "StreamTrack");
+    list[0].setBpm(125);
+    CHECK(list[0].getBpm() == 125);
+    CHECK(holds_alternative<StreamTrack>(list.variantAt(1)));
+    CHECK_THROWS_AS(list.variantAt(3), out_of_range);
+    CHECK_THROWS_AS(list[-1], out_of_range);
+    list[0].setBpm(124);
+
+    ostringstream viaManager, viaInline;
+    m.printAll(viaManager);
+    list.printAll(viaInline);
+    CHECK(viaManager.str() == viaInline.str());
+
+    ostringstream virt, visited, tagged;
+    for (int i = 0; i < m.getSize(); i++)
     {
-        cout << prompt;
+        virt << *m[i] << "\n";
+        m.toStreamAt(tagged, i);
+        tagged << "\n";
+    }
+    list.toStreamAll(visited);
+    CHECK(virt.str() == visited.str());
+    CHECK(virt.str() == tagged.str());
+}
 
-        if (cin >> value && value >= minVal && value <= maxVal)
-        {
-            cin.ignore(numeric_limits<streamsize>::max(), '\n');
-            return value;
-        }
+TEST_CASE("Statically dispatched print matches the virtual print")
+{
+    StreamTrack s("Song", 140, MEDIUM, "Tidal", MixNotes("drop"));
+    const TrackBase& base = s;
+    ostringstream a, b;
+    base.print(a);
+    s.StreamTrack::print(b);
+    CHECK(a.str() == b.str());
+    CHECK(a.str().find("StreamTrack") != string::npos);
+
+    InlineTrackList empty;
+    ostringstream none;
+    empty.printAll(none);
+    CHECK(none.str() == "No tracks stored yet.\n");
+}
 
-        cout << "Invalid number. Enter " << minVal << " to " << maxVal << ".\n";
-        cin.clear();
-        cin.ignore(numeric_limits<streamsize>::max(), '\n');
+// ==================== Library Engine: energy histogram ====================
+
+TEST_CASE("Energy histogram kernels agree at every SIMD level")
+{
+    vector<uint16_t> col;
+    for (int i = 0; i < 100003; i++)
+        col.push_back(static_cast<uint16_t>(i % 5)); // 0 and 4 are not energies
+
+    EnergyCounts expected;
+    energyHistogramScalar(col.data(), static_cast<int>(col.size()), expected);
+    CHECK(expected.low == 20001);
+    CHECK(expected.medium == 20001);
+    CHECK(expected.high == 20000);
+
+    for (int level = SIMD_SCALAR; level <= SIMD_AVX2; level++)
+    {
+        EnergyCounts got = ColumnScanner::forLevel(static_cast<SimdLevel>(level)).histogram(col);
+        CHECK(got.low == expected.low);
+        CHECK(got.medium == expected.medium);
+        CHECK(got.high == expected.high);
     }
+    CHECK(ColumnScanner::best().histogram(vector<uint16_t>()).total() == 0);
 }
 
-// -------------------- Enum Helpers --------------------
-EnergyLevel getEnergyFromUser()
+TEST_CASE("Energy counts stay O(1) and exact across add/remove/update")
 {
-    cout << "Energy Level:\n";
-    cout << "  1) Low\n";
-    cout << "  2) Medium\n";
-    cout << "  3) High\n";
+    TrackManager m(2);
+    m.emplaceLocal("A", 120, LOW, "a.wav", MixNotes(""));
+    m.emplaceLocal("B", 121, HIGH, "b.wav", MixNotes(""));
+    m.emplaceStream("C", 122, HIGH, "Tidal", MixNotes(""));
+    m += new LocalTrack("D", 123, MEDIUM, "d.wav", MixNotes(""));
+
+    CHECK(m.countEnergy(LOW) == 1);
+    CHECK(m.countEnergy(MEDIUM) == 1);
+    CHECK(m.countEnergy(HIGH) == 2);
+
+    m.removeAt(1);
+    m.updateEnergy(0, HIGH);
+    const EnergyCounts& kept = m.getEnergyCounts();
+    CHECK(kept.low == 0);
+    CHECK(kept.medium == 1);
+    CHECK(kept.high == 2);
+
+    EnergyCounts scanned = m.energyHistogram();
+    CHECK(scanned.low == kept.low);
+    CHECK(scanned.medium == kept.medium);
+    CHECK(scanned.high == kept.high);
+    CHECK(m.countHighEnergyRecursive() == 2);
+}
 
-    int choice = getValidatedInt("Choose energy (1-3): ", 1, 3);
+TEST_CASE("countHighEnergyRecursive handles a 1M-track library without deep recursion")
+{
+    TrackManager m(2);
+    const int N = 1000000;
+    m.reserve(N);
+    for (int i = 0; i < N; i++)
+        m.emplaceLocal("T", BPM_MIN + i % BPM_BUCKETS, (i % 4 == 0) ? HIGH : LOW, "", MixNotes(""));
+
+    CHECK(m.countHighEnergyRecursive() == N / 4);
+    CHECK(m.countEnergy(HIGH) == N / 4);
+    CHECK(m.energyHistogram().low == N - N / 4);
+}
 
-    switch (choice)
+// ==================== Library Engine: aggregates ====================
+
+TEST_CASE("Aggregates track average, min/max, genre and key counts incrementally")
+{
+    TrackManager m(2);
+    Track a = makeTrack("A", "House", 124, LOW);
+    Track b = makeTrack("B", "Techno", 90, HIGH);
+    Track c = makeTrack("C", "House", 174, MEDIUM);
+    c.key = "F#m";
+    m.addTrackRecord(a);
+    m.addTrackRecord(b);
+    m.addTrackRecord(c);
+    m += new LocalTrack("Outlier", 250, HIGH, "o.wav", MixNotes(""));
+
+    CHECK(m.getMinBpm() == 90);
+    CHECK(m.getMaxBpm() == 250);
+    CHECK(m.averageBpm() == doctest::Approx((124 + 90 + 174 + 250) / 4.0));
+    CHECK(m.countGenre("House") == 2);
+    CHECK(m.countKey("Am") == 2);
+    CHECK(m.countKey("F#m") == 1);
+    CHECK(m.countKey("Gm") == 0);
+
+    m.removeAt(3);                  // drop the outlier max
+    CHECK(m.getMaxBpm() == 174);
+    m.removeAt(1);                  // drop the minimum (Techno, 90)
+    CHECK(m.getMinBpm() == 124);
+    CHECK(m.countGenre("Techno") == 0);
+
+    m.updateGenre(0, "Techno");
+    m.updateBpm(1, 60);
+    CHECK(m.countGenre("House") == 1);
+    CHECK(m.countGenre("Techno") == 1);
+    CHECK(m.getMinBpm() == 60);
+    CHECK(m.getMaxBpm() == 124);
+    CHECK(m.getAggregates().getBpmSum() == 184);
+
+    m.removeAt(0);
+    m.removeAt(0);
+    CHECK(m.getAggregates().getCount() == 0);
+    CHECK(m.getMinBpm() == 0);
+    CHECK(m.averageBpm() == doctest::Approx(0.0));
+}
+
+TEST_CASE("Aggregate snapshot is written into the report")
+{
+    TrackManager m(2);
+    m.addTrackRecord(makeTrack("A", "House", 120, HIGH));
+    m.addTrackRecord(makeTrack("B", "House", 130, LOW));
+    m.addTrackRecord(makeTrack("C", "Disco", 110, HIGH));
+
+    AggregateSnapshot snap = m.snapshotAggregates();
+    CHECK(snap.count == 3);
+    REQUIRE(snap.genres.size() == 2);
+    CHECK(snap.genres[0].first == "House");
+    CHECK(snap.genres[0].second == 2);
+    CHECK(snap.energy.high == 2);
+
+    ostringstream oss;
+    writeLegacyReport(oss, m);
+    string report = oss.str();
+    CHECK(report.find("Library stats: 3 tracks, BPM min/avg/max 110 / 120.0 / 130") != string::npos);
+    CHECK(report.find("Energy: Low 1, Medium 0, High 2") != string::npos);
+    CHECK(report.find("Genres: House x2, Disco x1") != string::npos);
+    CHECK(report.find("Keys: Am x3") != string::npos);
+}
+
+// ==================== Library Engine: harmonic keys ====================
+
+TEST_CASE("parseHarmonicKey reads standard, Camelot and Open Key notation")
+{
+    int aMinor = parseHarmonicKey("Am");
+    CHECK(aMinor == 14);
+    CHECK(parseHarmonicKey("8A") == aMinor);
+    CHECK(parseHarmonicKey("8a") == aMinor);
+    CHECK(parseHarmonicKey("1m") == aMinor);
+    CHECK(parseHarmonicKey("a minor") == aMinor);
+    CHECK(parseHarmonicKey("A min") == aMinor);
+
+    CHECK(parseHarmonicKey("C") == parseHarmonicKey("8B"));
+    CHECK(parseHarmonicKey("C major") == parseHarmonicKey("1d"));
+    CHECK(parseHarmonicKey("c min") == parseHarmonicKey("5A"));
+    CHECK(parseHarmonicKey("F#m") == parseHarmonicKey("11A"));
+    CHECK(parseHarmonicKey("Gbm") == parseHarmonicKey("F#m"));
+    CHECK(parseHarmonicKey("Bb") == parseHarmonicKey("6B"));
+    CHECK(parseHarmonicKey("Ebmin") == parseHarmonicKey("2A"));
+    CHECK(parseHarmonicKey("6d") == parseHarmonicKey("B"));
+
+    CHECK(parseHarmonicKey("") == NO_KEY);
+    CHECK(parseHarmonicKey("H") == NO_KEY);
+    CHECK(parseHarmonicKey("13A") == NO_KEY);
+    CHECK(parseHarmonicKey("8X") == NO_KEY);
+    CHECK(parseHarmonicKey("Am7") == NO_KEY);
+
+    for (int id = 0; id < HARMONIC_KEYS; id++)
     {
-    case 1: return LOW;
-    case 2: return MEDIUM;
-    case 3: return HIGH;
-    default: return MEDIUM;
+        CHECK(parseHarmonicKey(keyToCamelot(id)) == id);
+        CHECK(parseHarmonicKey(keyToStandard(id)) == id);
     }
+    CHECK(keyToStandard(aMinor) == "Am");
+    CHECK(keyToCamelot(NO_KEY) == "");
 }
 
-string energyToString(EnergyLevel e)
+TEST_CASE("KEY_COMPAT scores follow the Camelot wheel")
 {
-    if (e == LOW) return "Low";
-    if (e == MEDIUM) return "Medium";
-    return "High";
+    int am = parseHarmonicKey("8A");
+    CHECK(harmonicScore(am, am) == KEY_SCORE_PERFECT);
+    CHECK(harmonicScore(am, parseHarmonicKey("7A")) == KEY_SCORE_COMPATIBLE);
+    CHECK(harmonicScore(am, parseHarmonicKey("8B")) == KEY_SCORE_COMPATIBLE);
+    CHECK(harmonicScore(am, parseHarmonicKey("10A")) == KEY_SCORE_LOOSE);
+    CHECK(harmonicScore(am, parseHarmonicKey("9B")) == KEY_SCORE_LOOSE);
+    CHECK(harmonicScore(am, parseHarmonicKey("2A")) == KEY_SCORE_CLASH);
+    CHECK(harmonicScore(am, NO_KEY) == KEY_SCORE_CLASH);
+    bool symmetric = true;
+    for (int a = 0; a < HARMONIC_KEYS; a++)
+        for (int b = 0; b < HARMONIC_KEYS; b++)
+            symmetric = symmetric && KEY_COMPAT.score[a][b] == KEY_COMPAT.score[b][a];
+    CHECK(symmetric);
+}
+
+TEST_CASE("recommendNext filters by harmonic key with one table lookup")
+{
+    TrackManager m(2);
+    Track a = makeTrack("Same", "House", 126, MEDIUM);     // Am = 8A
+    Track b = makeTrack("Neighbor", "House", 127, MEDIUM);
+    b.key = "9A";
+    Track c = makeTrack("Clash", "House", 128, MEDIUM);
+    c.key = "F";                                           // 7B: loose vs 8A
+    Track d = makeTrack("NoKey", "House", 125, MEDIUM);
+    d.key = "";
+    m.addTrackRecord(a);
+    m.addTrackRecord(b);
+    m.addTrackRecord(c);
+    m.addTrackRecord(d);
+
+    CHECK(m.recommendNext(126, MEDIUM, 5).size() == 4);
+    vector<TrackId> harmonic = m.recommendNext(126, MEDIUM, 5, parseHarmonicKey("Am"));
+    REQUIRE(harmonic.size() == 2);
+    CHECK(m.at(harmonic[0])->getTitle() == "Same");
+    CHECK(m.at(harmonic[1])->getTitle() == "Neighbor");
+    CHECK(m.recommendNext(126, MEDIUM, 5, parseHarmonicKey("8A"), KEY_SCORE_LOOSE).size() == 3);
+
+    CHECK(m.countHarmonicKey("8A") == 1);
+    m.updateKey(1, "a minor");
+    CHECK(m.countHarmonicKey("Am") == 2);
+    CHECK(m.countKey("Am") == 1);
+    CHECK(m.getStore().harmonicKeyColumn()[3] == NO_KEY_PACKED);
 }
 
-// -------------------- Output Helpers (Weeks 1-4) --------------------
-void printLegacyTableHeader(ostream& out)
-{
-    out << left
-        << setw(TITLE_W) << "Title"
-        << setw(ARTIST_W) << "Artist"
-        << setw(GENRE_W) << "Genre"
-        << setw(KEY_W) << "Key"
-        << right << setw(6) << "BPM" << "  "
-        << left << setw(8) << "Energy"
-        << setw(NOTE_W) << "Notes"
-        << "\n";
+// ==================== Library Engine: setlist builder ====================
 
-    out << string(LINE_W, '-') << "\n";
+TEST_CASE("EnergyArc interpolates between control points")
+{
+    EnergyArc rise = EnergyArc::rising();
+    CHECK(rise.target(0, 5) == doctest::Approx(1.0));
+    CHECK(rise.target(2, 5) == doctest::Approx(2.0));
+    CHECK(rise.target(4, 5) == doctest::Approx(3.0));
+    EnergyArc peak = EnergyArc::peak();
+    CHECK(peak.target(2, 5) == doctest::Approx(3.0));
+    CHECK(peak.target(4, 5) == doctest::Approx(2.0));
+    CHECK(EnergyArc::steady(HIGH).target(3, 9) == doctest::Approx(3.0));
 }
 
-void printTrackRow(ostream& out, const Track& t)
+TEST_CASE("TransitionScorer prefers small BPM jumps, compatible keys and the target energy")
 {
-    out << left
-        << setw(TITLE_W) << t.title.substr(0, TITLE_W - 1)
-        << setw(ARTIST_W) << t.artist.substr(0, ARTIST_W - 1)
-        << setw(GENRE_W) << t.genre.substr(0, GENRE_W - 1)
-        << setw(KEY_W) << t.key.substr(0, KEY_W - 1)
-        << right << setw(6) << t.bpm << "  "
-        << left << setw(8) << energyToString(t.energy)
-        << setw(NOTE_W) << t.notes.substr(0, NOTE_W - 1)
-        << "\n";
+    TrackManager m(2);
+    Track a = makeTrack("From", "House", 124, MEDIUM);      // 8A
+    Track near = makeTrack("Near", "House", 125, MEDIUM);   // 8A
+    Track far = makeTrack("Far", "House", 130, MEDIUM);     // 8A
+    Track clash = makeTrack("Clash", "House", 125, MEDIUM);
+    clash.key = "2B";
+    Track high = makeTrack("High", "House", 125, HIGH);
+    m.addTrackRecord(a);
+    m.addTrackRecord(near);
+    m.addTrackRecord(far);
+    m.addTrackRecord(clash);
+    m.addTrackRecord(high);
+
+    TransitionScorer scorer;
+    const TrackStore& st = m.getStore();
+    CHECK(scorer.score(st, 0, 1, MEDIUM) > scorer.score(st, 0, 2, MEDIUM));
+    CHECK(scorer.score(st, 0, 1, MEDIUM) > scorer.score(st, 0, 3, MEDIUM));
+    CHECK(scorer.score(st, 0, 4, HIGH) > scorer.score(st, 0, 1, HIGH));
 }
 
-// -------------------- Main Features (Weeks 1-4) --------------------
-void addTrack(Track library[], int& count)
+TEST_CASE("SetBuilder builds a no-repeat set that follows the energy arc")
 {
-    if (count >= MAX_TRACKS)
-    {
-        cout << "Library is full (" << MAX_TRACKS << " tracks). Cannot add more.\n";
-        return;
-    }
-
-    cout << "\n--- Add Track (" << (count + 1) << "/" << MAX_TRACKS << ") ---\n";
+    TrackManager m(2);
+    TrackId start = m.addTrackRecord(makeTrack("Opener", "House", 120, LOW));
+    for (int i = 0; i < 30; i++)
+        m.addTrackRecord(makeTrack("T" + to_string(i), "House", 118 + i % 8,
+            static_cast<EnergyLevel>(LOW + i % 3)));
+
+    SetBuildOptions options;
+    options.length = 9;
+    options.beamWidth = 50;
+    Setlist set = SetBuilder(m).build(start, options);
+
+    REQUIRE(set.tracks.size() == 9);
+    CHECK(set.tracks[0] == start);
+    for (size_t i = 0; i < set.tracks.size(); i++)
+        for (size_t j = i + 1; j < set.tracks.size(); j++)
+            CHECK(set.tracks[i] != set.tracks[j]);
+    CHECK(m.at(set.tracks[8])->getEnergy() == HIGH);
+    CHECK(m.at(set.tracks[1])->getEnergy() == LOW);
+    for (size_t i = 1; i < set.tracks.size(); i++)
+        CHECK(absValue(m.at(set.tracks[i])->getBpm() - m.at(set.tracks[i - 1])->getBpm()) <= options.maxBpmJump);
+
+    // Same input -> same set (deterministic tie-breaks)
+    Setlist again = SetBuilder(m).build(start, options);
+    CHECK(again.tracks == set.tracks);
+}
 
-    Track t;
-    t.title = getNonEmptyLine("Title: ");
-    t.artist = getNonEmptyLine("Artist: ");
-    t.genre = getNonEmptyLine("Genre: ");
-    t.key = getNonEmptyLine("Key (ex: Am, C, F#m): ");
-    t.bpm = getValidatedInt("BPM (60-200): ", BPM_MIN, BPM_MAX);
-    t.energy = getEnergyFromUser();
-    t.notes = getNonEmptyLine("Notes (mix notes): ");
+TEST_CASE("SetBuilder stops early at a dead end and rejects bad input")
+{
+    TrackManager m(2);
+    TrackId a = m.addTrackRecord(makeTrack("A", "House", 120, LOW));
+    m.addTrackRecord(makeTrack("B", "House", 122, LOW));
+    m.addTrackRecord(makeTrack("Far", "House", 180, LOW));
+
+    SetBuildOptions options;
+    options.length = 5;
+    Setlist set = SetBuilder(m).build(a, options);
+    CHECK(set.tracks.size() == 2);
+
+    options.length = 1;
+    CHECK(SetBuilder(m).build(a, options).tracks.size() == 1);
+    options.length = 0;
+    CHECK_THROWS_AS(SetBuilder(m).build(a, options), DJException);
+
+    options.length = 3;
+    m.remove(a);
+    CHECK_THROWS_AS(SetBuilder(m).build(a, options), DJException);
+}
 
-    library[count] = t;
-    count++;
+// ==================== Library Engine: work-stealing pool + parallel sets ====================
 
-    cout << "Track added!\n";
+TEST_CASE("WorkStealingPool runs every task and rethrows task errors")
+{
+    WorkStealingPool pool(4);
+    CHECK(pool.getThreadCount() == 4);
+
+    atomic<int> sum{ 0 };
+    for (int i = 1; i <= 1000; i++)
+        pool.submit([&sum, i]() { sum += i; });
+    pool.wait();
+    CHECK(sum.load() == 500500);
+
+    // Tasks may submit more tasks (they go to the submitting worker's deque)
+    atomic<int> children{ 0 };
+    for (int i = 0; i < 8; i++)
+        pool.submit([&]() {
+            for (int k = 0; k < 10; k++)
+                pool.submit([&children]() { children++; });
+        });
+    pool.wait();
+    CHECK(children.load() == 80);
+
+    pool.submit([]() { throw DJException("task failed"); });
+    CHECK_THROWS_AS(pool.wait(), DJException);
+    pool.wait(); // error was reported once
 }
 
-void printLibrary(const Track library[], int count)
+TEST_CASE("ParallelSetOptimizer returns top-k distinct sets, best >= single beam")
 {
-    if (count == 0)
+    TrackManager m(2);
+    TrackId start = m.addTrackRecord(makeTrack("Opener", "House", 120, LOW));
+    static const char* const KEYS[4] = { "Am", "8B", "9A", "Dm" };
+    for (int i = 0; i < 60; i++)
     {
-        cout << "No tracks saved yet.\n";
-        return;
+        Track t = makeTrack("T" + to_string(i), "House", 116 + i % 10, static_cast<EnergyLevel>(LOW + i % 3));
+        t.key = KEYS[i % 4];
+        m.addTrackRecord(t);
     }
 
-    cout << "\n==================== LIBRARY (Weeks 1-4) ====================\n";
-    printLegacyTableHeader(cout);
+    SetBuildOptions options;
+    options.length = 8;
+    options.beamWidth = 20;
+    Setlist single = SetBuilder(m).build(start, options);
 
-    for (int i = 0; i < count; i++)
-        printTrackRow(cout, library[i]);
+    WorkStealingPool pool(3);
+    ParallelSetOptions par;
+    par.seeds = 12;
+    par.topK = 4;
+    vector<Setlist> top = ParallelSetOptimizer(m, pool).optimize(start, options, par);
 
-    double avg = computeAverageBPM(library, count);
-    cout << "\nAverage BPM: " << fixed << setprecision(1) << avg << "\n";
+    REQUIRE(top.size() == 4);
+    CHECK(top[0].score >= single.score - 1e-9);
+    for (size_t i = 0; i < top.size(); i++)
+    {
+        CHECK(top[i].tracks.size() == 8);
+        CHECK(top[i].tracks[0] == start);
+        if (i > 0)
+            CHECK(top[i - 1].score >= top[i].score);
+        for (size_t j = i + 1; j < top.size(); j++)
+            CHECK(top[i].tracks != top[j].tracks);
+    }
 
-    string checkGenre = getNonEmptyLine("Enter a genre to count matches: ");
-    int matches = countGenreMatches(library, count, checkGenre);
-    cout << "Tracks in genre \"" << checkGenre << "\": " << matches << "\n";
+    m.remove(start);
+    CHECK_THROWS_AS(ParallelSetOptimizer(m, pool).optimize(start, options, par), DJException);
 }
 
-void recommendNextTracks(const Track library[], int count)
+TEST_CASE("ParallelSetOptimizer: pruning never returns a shorter set")
 {
-    if (count == 0)
+    // keyless tracks: every transition scores < 0, so a cut-off set would
+    // outscore the complete ones if it were ever returned
+    TrackManager m(2);
+    Track opener = makeTrack("Opener", "House", 120, LOW);
+    opener.key = Symbol("");
+    TrackId start = m.addTrackRecord(opener);
+    for (int i = 0; i < 80; i++)
     {
-        cout << "No tracks in library. Add tracks first.\n";
-        return;
+        Track t = makeTrack("K" + to_string(i), "House", 114 + i % 13, static_cast<EnergyLevel>(LOW + i % 3));
+        t.key = Symbol("");
+        m.addTrackRecord(t);
     }
 
-    cout << "\n--- Recommend Next Tracks ---\n";
-    int currentBPM = getValidatedInt("Current BPM you are playing (60-200): ", BPM_MIN, BPM_MAX);
-    EnergyLevel currentEnergy = getEnergyFromUser();
+    SetBuildOptions options;
+    options.length = 16;
+    options.beamWidth = 8;
+    Setlist single = SetBuilder(m).build(start, options);
+    REQUIRE(single.tracks.size() == 16);
+    REQUIRE(single.score < 0);
+
+    WorkStealingPool pool(2);
+    ParallelSetOptions par;
+    par.seeds = 16;
+    par.topK = 5;
+    vector<Setlist> top = ParallelSetOptimizer(m, pool).optimize(start, options, par);
+    REQUIRE(top.size() == 5);
+    for (const Setlist& set : top)
+        CHECK(set.tracks.size() == 16);
+    CHECK(top[0].score >= single.score - 1e-9);
+
+    atomic<double> unreachable{ 0.0 }; // no complete set can score >= 0 here
+    CHECK(SetBuilder(m).buildTop(start, options, 3, &unreachable).empty());
+}
 
-    const int BPM_RANGE = 5;
-    bool found = false;
+TEST_CASE("SetBuilder::buildTop returns several sets best first")
+{
+    TrackManager m(2);
+    TrackId start = m.addTrackRecord(makeTrack("Opener", "House", 120, LOW));
+    for (int i = 0; i < 20; i++)
+        m.addTrackRecord(makeTrack("T" + to_string(i), "House", 119 + i % 4, static_cast<EnergyLevel>(LOW + i % 3)));
+
+    SetBuildOptions options;
+    options.length = 5;
+    vector<Setlist> sets = SetBuilder(m).buildTop(start, options, 3);
+    REQUIRE(sets.size() == 3);
+    CHECK(sets[0].score >= sets[1].score);
+    CHECK(sets[1].score >= sets[2].score);
+    CHECK(sets[0].tracks == SetBuilder(m).build(start, options).tracks);
+
+    atomic<double> impossible{ 1e9 }; // nothing can reach it -> everything pruned, no cut-off sets
+    CHECK(SetBuilder(m).buildTop(start, options, 3, &impossible).empty());
+}
 
-    cout << "\nSuggested tracks (within +/-" << BPM_RANGE
-        << " BPM and energy stays steady or rises):\n";
+// ==================== Library Engine: energy-arc DP planner ====================
 
-    for (int i = 0; i < count; i++)
+// Best score over every no-repeat sequence that follows the curve (tiny libraries only).
+double bruteForcePlanScore(const TrackManager& m, const vector<EnergyLevel>& curve, int maxStep,
+    vector<int>& path, vector<bool>& used, double sofar)
+{
+    int t = static_cast<int>(path.size());
+    if (t == static_cast<int>(curve.size()))
+        return sofar;
+    TransitionScorer scorer(TransitionWeights(), maxStep);
+    double best = -1e300;
+    for (int r = 0; r < m.getSize(); r++)
     {
-        int bpmDiff = absValue(library[i].bpm - currentBPM);
-
-        if (bpmDiff <= BPM_RANGE &&
-            (library[i].energy == currentEnergy || library[i].energy == currentEnergy + 1))
+        if (used[r] || m[r]->getEnergy() != curve[t])
+            continue;
+        double add = 0.0;
+        if (t > 0)
         {
-            found = true;
-            cout << " - " << library[i].title << " by " << library[i].artist
-                << " (" << library[i].bpm << " BPM, " << energyToString(library[i].energy) << ")\n";
+            if (absValue(m[r]->getBpm() - m[path.back()]->getBpm()) > maxStep)
+                continue;
+            add = scorer.score(m.getStore(), path.back(), r, curve[t]);
         }
+        used[r] = true;
+        path.push_back(r);
+        double v = bruteForcePlanScore(m, curve, maxStep, path, used, sofar + add);
+        if (v > best)
+            best = v;
+        path.pop_back();
+        used[r] = false;
     }
-
-    if (!found)
-        cout << "No close matches found. Try adding more tracks.\n";
+    return best;
 }
 
-void saveReportToFile(const Track library[], int count, const string& filename)
+TEST_CASE("EnergyArcPlanner follows the curve with no repeats and matches brute force")
 {
-    ofstream fout(filename.c_str());
-    if (!fout)
+    TrackManager m(2);
+    static const char* const KEYS[5] = { "Am", "9A", "C", "2B", "" };
+    for (int i = 0; i < 12; i++)
     {
-        cout << "Could not open file: " << filename << "\n";
-        return;
+        Track t = makeTrack("T" + to_string(i), "House", 120 + (i * 7) % 9, static_cast<EnergyLevel>(LOW + i % 3));
+        t.key = KEYS[i % 5];
+        m.addTrackRecord(t);
     }
 
-    fout << "==================== DJ SET ARCHITECT REPORT (Weeks 1-4) ====================\n";
-    fout << "Tracks stored: " << count << "\n\n";
+    vector<EnergyLevel> curve = { LOW, LOW, MEDIUM, HIGH, HIGH };
+    EnergyPlanOptions options;
+    options.maxBpmStep = 4;
+    EnergyPlan plan = EnergyArcPlanner(m).plan(curve, options);
 
-    if (count == 0)
+    REQUIRE(plan.tracks.size() == curve.size());
+    for (size_t t = 0; t < curve.size(); t++)
     {
-        fout << "No tracks saved.\n";
-        fout.close();
-        cout << "Report saved to " << filename << "\n";
-        return;
+        CHECK(m.at(plan.tracks[t])->getEnergy() == curve[t]);
+        for (size_t u = t + 1; u < curve.size(); u++)
+            CHECK(plan.tracks[t] != plan.tracks[u]);
+        if (t > 0)
+            CHECK(absValue(m.at(plan.tracks[t])->getBpm() - m.at(plan.tracks[t - 1])->getBpm()) <= 4);
     }
 
-    printLegacyTableHeader(fout);
-    for (int i = 0; i < count; i++)
-        printTrackRow(fout, library[i]);
-
-    double avg = computeAverageBPM(library, count);
-    fout << "\nAverage BPM: " << fixed << setprecision(1) << avg << "\n";
+    vector<int> path;
+    vector<bool> used(m.getSize(), false);
+    CHECK(plan.score == doctest::Approx(bruteForcePlanScore(m, curve, 4, path, used, 0.0)));
 
-    fout.close();
-    cout << "Report saved to " << filename << "\n";
+    // Small libraries with many same-cell tracks (repeats must be repaired)
+    for (unsigned seed = 1; seed <= 6; seed++)
+    {
+        TrackManager small(2);
+        unsigned x = seed;
+        for (int i = 0; i < 10; i++)
+        {
+            x = x * 1103515245u + 12345u;
+            Track t = makeTrack("S" + to_string(i), "House", 124 + (x >> 16) % 4, static_cast<EnergyLevel>(LOW + (x >> 20) % 3));
+            t.key = KEYS[(x >> 24) % 3];
+            small.addTrackRecord(t);
+        }
+        vector<EnergyLevel> c2 = { MEDIUM, MEDIUM, HIGH, HIGH, LOW };
+        EnergyPlan p2 = EnergyArcPlanner(small).plan(c2, options);
+        vector<int> path2;
+        vector<bool> used2(small.getSize(), false);
+        double best = bruteForcePlanScore(small, c2, 4, path2, used2, 0.0);
+        if (best < -1e299)
+            CHECK(p2.tracks.empty());
+        else
+            CHECK(p2.score == doctest::Approx(best));
+    }
 }
 
-// -------------------- Calculations / Derived Values (Weeks 1-4) --------------------
-double computeAverageBPM(const Track library[], int count)
+TEST_CASE("EnergyArcPlanner repairs repeats, honours a start track and reports infeasible curves")
 {
-    if (count == 0) return 0.0;
-
-    int sum = 0;
-    for (int i = 0; i < count; i++)
-        sum += library[i].bpm;
+    TrackManager m(2);
+    // Two identical HIGH tracks share one cell: a 3-HIGH curve must leave it.
+    TrackId a = m.addTrackRecord(makeTrack("A", "House", 128, HIGH));
+    m.addTrackRecord(makeTrack("B", "House", 128, HIGH));
+    m.addTrackRecord(makeTrack("C", "House", 130, HIGH));
+    m.addTrackRecord(makeTrack("D", "House", 126, MEDIUM));
+
+    vector<EnergyLevel> curve = { HIGH, HIGH, HIGH };
+    EnergyPlan plan = EnergyArcPlanner(m).plan(curve);
+    REQUIRE(plan.tracks.size() == 3);
+    CHECK(plan.status == PLAN_FOUND);
+    CHECK(plan.repairs >= 1);
+    CHECK(plan.tracks[0] != plan.tracks[1]);
+    CHECK(plan.tracks[1] != plan.tracks[2]);
+    CHECK(plan.tracks[0] != plan.tracks[2]);
+
+    EnergyPlanOptions options;
+    options.start = m.idAt(3);
+    vector<EnergyLevel> warm = { MEDIUM, HIGH };
+    EnergyPlan started = EnergyArcPlanner(m).plan(warm, options);
+    REQUIRE(started.tracks.size() == 2);
+    CHECK(started.tracks[0] == m.idAt(3));
+
+    vector<EnergyLevel> tooMany = { HIGH, HIGH, HIGH, HIGH };
+    CHECK(EnergyArcPlanner(m).plan(tooMany).tracks.empty());
+    vector<EnergyLevel> noLow = { LOW };
+    CHECK(EnergyArcPlanner(m).plan(noLow).tracks.empty());
+
+    options.maxBpmStep = 1; // 126 -> 128 is too far
+    CHECK(EnergyArcPlanner(m).plan(warm, options).tracks.empty());
+    CHECK(EnergyArcPlanner(m).plan(warm, options).status == PLAN_INFEASIBLE);
+
+    CHECK_THROWS_AS(EnergyArcPlanner(m).plan(vector<EnergyLevel>()), DJException);
+    m.remove(a);
+    options.start = a;
+    CHECK_THROWS_AS(EnergyArcPlanner(m).plan(warm, options), DJException);
+}
 
-    return static_cast<double>(sum) / static_cast<double>(count);
+TEST_CASE("EnergyArcPlanner checks the start track and reports a spent repair budget")
+{
+    TrackManager m(2);
+    m.addTrackRecord(makeTrack("A", "House", 128, HIGH));
+    m.addTrackRecord(makeTrack("B", "House", 128, HIGH));
+    m.addTrackRecord(makeTrack("C", "House", 130, HIGH));
+    TrackId d = m.addTrackRecord(makeTrack("D", "House", 126, MEDIUM));
+
+    // The best path uses the A/B cell three times, so it needs repairs.
+    vector<EnergyLevel> curve = { HIGH, HIGH, HIGH };
+    EnergyPlanOptions options;
+    options.maxRepairs = 0;
+    EnergyPlan spent = EnergyArcPlanner(m).plan(curve, options);
+    CHECK(spent.status == PLAN_BUDGET_EXHAUSTED);
+    CHECK(spent.tracks.empty());
+    options.maxRepairs = 256;
+    EnergyPlan full = EnergyArcPlanner(m).plan(curve, options);
+    CHECK(full.status == PLAN_FOUND);
+    REQUIRE(full.repairs > 5);
+
+    // The budget runs out while a repeat-free branch is already solved and
+    // waiting: it is still returned instead of "exhausted".
+    options.maxRepairs = 5;
+    EnergyPlan cut = EnergyArcPlanner(m).plan(curve, options);
+    CHECK(cut.status == PLAN_FOUND);
+    CHECK(cut.repairs == 5);
+    REQUIRE(cut.tracks.size() == 3);
+    CHECK(cut.tracks[0] != cut.tracks[1]);
+    CHECK(cut.tracks[1] != cut.tracks[2]);
+    CHECK(cut.tracks[0] != cut.tracks[2]);
+    CHECK(cut.score == doctest::Approx(full.score));
+    options.maxRepairs = 256;
+
+    vector<EnergyLevel> badLevel = { HIGH, static_cast<EnergyLevel>(0) };
+    CHECK_THROWS_AS(EnergyArcPlanner(m).plan(badLevel, options), DJException);
+    badLevel[1] = static_cast<EnergyLevel>(HIGH + 1);
+    CHECK_THROWS_AS(EnergyArcPlanner(m).plan(badLevel, options), DJException);
+
+    // A curve no library could satisfy stays infeasible whatever the budget.
+    vector<EnergyLevel> tooMany = { HIGH, HIGH, HIGH, HIGH };
+    CHECK(EnergyArcPlanner(m).plan(tooMany, options).status == PLAN_INFEASIBLE);
+
+    options.start = d; // MEDIUM
+    vector<EnergyLevel> wrongStart = { HIGH, HIGH };
+    EnergyPlan p = EnergyArcPlanner(m).plan(wrongStart, options);
+    CHECK(p.status == PLAN_INFEASIBLE);
+    CHECK(p.tracks.empty());
+
+    vector<EnergyLevel> warm = { MEDIUM, HIGH };
+    CHECK(EnergyArcPlanner(m).plan(warm, options).status == PLAN_FOUND);
+    options.minBpm = 127; // the start track (126) is below the window
+    CHECK(EnergyArcPlanner(m).plan(warm, options).status == PLAN_INFEASIBLE);
+    options.minBpm = BPM_MIN;
+    options.maxBpm = 125; // ... or above it
+    CHECK(EnergyArcPlanner(m).plan(warm, options).status == PLAN_INFEASIBLE);
 }
 
-int countGenreMatches(const Track library[], int count, const string& genre)
+// ==================== Library Engine: neighbor index ====================
+
+// Expected top-K list of row 'from', recomputed from scratch.
+vector<Neighbor> expectedNeighbors(const TrackManager& m, int from, const NeighborOptions& options)
 {
-    int matches = 0;
-    for (int i = 0; i < count; i++)
+    const TrackStore& st = m.getStore();
+    TransitionScorer scorer(options.weights, options.bpmWindow);
+    vector<Neighbor> all;
+    for (int r = 0; r < m.getSize(); r++)
     {
-        if (library[i].genre == genre)
-            matches++;
+        int e = st.energyColumn()[from], next = st.energyColumn()[r];
+        if (r == from || (next != e && next != e + 1)
+            || absValue(static_cast<int>(st.bpmColumn()[r]) - static_cast<int>(st.bpmColumn()[from])) > options.bpmWindow)
+            continue;
+        all.push_back(Neighbor{ st.idAt(r), scorer.score(st, from, r, e + 0.5) });
     }
-    return matches;
+    sort(all.begin(), all.end(), [](const Neighbor& a, const Neighbor& b) {
+        return a.score > b.score || (a.score == b.score && a.id.slot < b.id.slot);
+    });
+    if (static_cast<int>(all.size()) > options.k)
+        all.resize(options.k);
+    return all;
 }
 
-// -------------------- Week 5/6/7 Helper Output --------------------
-void printWeek5TableHeader(ostream& out)
+bool neighborsMatchRebuild(const TrackManager& m, const NeighborOptions& options)
 {
-    out << left
-        << "Idx "
-        << setw(TITLE_W) << "Title"
-        << setw(TYPE_W) << "Type"
-        << right << setw(6) << "BPM" << "  "
-        << left << setw(8) << "Energy"
-        << setw(NOTE_W) << "Notes"
-        << "  Source\n";
-
-    printSeparator(out);
+    for (int r = 0; r < m.getSize(); r++)
+    {
+        const vector<Neighbor>& got = m.neighborsOf(m.idAt(r));
+        vector<Neighbor> want = expectedNeighbors(m, r, options);
+        if (got.size() != want.size())
+            return false;
+        for (size_t i = 0; i < got.size(); i++)
+            if (got[i].id != want[i].id)
+                return false;
+    }
+    return true;
 }
 
-void printSeparator(ostream& out)
+TEST_CASE("NeighborIndex ranks compatible next tracks")
 {
-    out << string(LINE_W, '-') << "\n";
+    TrackManager m(2);
+    m.enableNeighborIndex();
+    TrackId a = m.addTrackRecord(makeTrack("A", "House", 124, MEDIUM));   // Am
+    TrackId same = m.addTrackRecord(makeTrack("Same", "House", 124, MEDIUM));
+    Track farT = makeTrack("Far", "House", 128, HIGH);
+    TrackId far = m.addTrackRecord(farT);
+    m.addTrackRecord(makeTrack("Lower", "House", 125, LOW));             // energy drop
+    m.addTrackRecord(makeTrack("OutOfWindow", "House", 140, MEDIUM));
+
+    const vector<Neighbor>& next = m.neighborsOf(a);
+    REQUIRE(next.size() == 2);
+    CHECK(next[0].id == same);
+    CHECK(next[1].id == far);
+    CHECK(next[0].score > next[1].score);
+
+    m.remove(same);
+    REQUIRE(m.neighborsOf(a).size() == 1);
+    CHECK(m.neighborsOf(a)[0].id == far);
+    CHECK_THROWS_AS(m.neighborsOf(same), DJException);
+
+    m.disableNeighborIndex();
+    CHECK_THROWS_AS(m.neighborsOf(a), DJException);
 }
 
-int safeIndexFromUser(const string& prompt, int size)
+TEST_CASE("NeighborIndex stays equal to a full rebuild across adds, removes and edits")
 {
-    if (size <= 0) return -1;
-    return getValidatedInt(prompt, 0, size - 1);
+    NeighborOptions options;
+    options.k = 3;
+    options.bpmWindow = 4;
+
+    TrackManager m(2);
+    static const char* const KEYS[4] = { "Am", "9A", "C", "2B" };
+    unsigned x = 7;
+    for (int i = 0; i < 40; i++)
+    {
+        x = x * 1103515245u + 12345u;
+        Track t = makeTrack("T" + to_string(i), "House", 118 + (x >> 16) % 12, static_cast<EnergyLevel>(LOW + (x >> 20) % 3));
+        t.key = KEYS[(x >> 24) % 4];
+        m.addTrackRecord(t);
+        if (i == 19)
+            m.enableNeighborIndex(options); // half built in bulk, half incrementally
+    }
+    CHECK(neighborsMatchRebuild(m, options));
+
+    for (int step = 0; step < 30; step++)
+    {
+        x = x * 1103515245u + 12345u;
+        int row = static_cast<int>((x >> 16) % m.getSize());
+        switch (step % 4)
+        {
+        case 0: m.removeAt(row); break;
+        case 1: m.updateBpm(row, 118 + (x >> 20) % 12); break;
+        case 2: m.updateEnergy(row, static_cast<EnergyLevel>(LOW + (x >> 20) % 3)); break;
+        case 3: m.updateKey(row, KEYS[(x >> 20) % 4]); break;
+        }
+    }
+    m.sortByBpm(); // rows move, slots do not
+    CHECK(neighborsMatchRebuild(m, options));
 }
 
-// -------------------- Doctest Unit Tests --------------------
-#ifdef _DEBUG
+// ==================== Library Engine: Tempo Tolerance ====================
 
-Track makeTrack(const string& title, const string& genre, int bpm, EnergyLevel e)
+TEST_CASE("tempoRanges: absolute, percent and half/double windows")
 {
-    Track t;
-    t.title = title;
-    t.artist = "Test";
-    t.genre = genre;
-    t.key = "Am";
-    t.bpm = bpm;
-    t.energy = e;
-    t.notes = "";
-    return t;
+    vector<TempoRange> r = tempoRanges(128, TempoTolerance::bpm(5));
+    REQUIRE(r.size() == 1);
+    CHECK(r[0].lo == 123);
+    CHECK(r[0].hi == 133);
+    CHECK(r[0].ratio == 1.0);
+
+    r = tempoRanges(100, TempoTolerance::percent(10.0));
+    REQUIRE(r.size() == 1);
+    CHECK(r[0].lo == 90);
+    CHECK(r[0].hi == 110);
+
+    TempoTolerance tol = TempoTolerance::bpm(5);
+    tol.halfDouble = true;
+    r = tempoRanges(140, tol);
+    REQUIRE(r.size() == 3);
+    CHECK(r[1].ratio == 2.0);
+    CHECK(r[1].lo == 68); // 135 / 2 = 67.5
+    CHECK(r[1].hi == 72); // 145 / 2 = 72.5
+    CHECK(r[2].ratio == 0.5);
+    CHECK(r[2].lo == 270);
+    CHECK(r[2].hi == 290);
 }
 
-// -------------------- Existing Week 05 tests (keep) --------------------
-TEST_CASE("Average BPM: 0 tracks returns 0.0")
+TEST_CASE("tempoRanges: pitch range limits the window and wide windows never overlap")
 {
-    Track lib[1];
-    CHECK(computeAverageBPM(lib, 0) == doctest::Approx(0.0));
+    TempoTolerance tol = TempoTolerance::bpm(20);
+    tol.pitchRange = 8.0;
+    vector<TempoRange> r = tempoRanges(128, tol);
+    REQUIRE(r.size() == 1);
+    CHECK(r[0].lo == 119); // 128 / 1.08 = 118.5
+    CHECK(r[0].hi == 139); // 128 / 0.92 = 139.1
+
+    r = tempoRanges(128, TempoTolerance::pitchFader(8.0));
+    REQUIRE(r.size() == 1);
+    CHECK(r[0].lo == 119);
+    CHECK(r[0].hi == 139);
+
+    TempoTolerance wide = TempoTolerance::percent(60.0);
+    wide.halfDouble = true;
+    r = tempoRanges(100, wide);
+    for (size_t i = 0; i < r.size(); i++)
+        for (size_t j = i + 1; j < r.size(); j++)
+            CHECK((r[i].hi < r[j].lo || r[j].hi < r[i].lo));
+
+    CHECK(tempoRanges(0, TempoTolerance::bpm(5)).empty());
 }
 
-TEST_CASE("Average BPM: 1 track")
+TEST_CASE("TrackManager::findTempoMatches: half/double time, pitch and outliers")
 {
-    Track lib[1];
-    lib[0] = makeTrack("A", "House", 120, MEDIUM);
-    CHECK(computeAverageBPM(lib, 1) == doctest::Approx(120.0));
+    TrackManager m(2);
+    TrackId straight = m.emplaceLocal("Straight", 140, MEDIUM, "a.wav", MixNotes(""));
+    TrackId half = m.emplaceLocal("Half", 70, MEDIUM, "b.wav", MixNotes(""));
+    TrackId nearHalf = m.emplaceLocal("NearHalf", 72, MEDIUM, "c.wav", MixNotes(""));
+    m.emplaceLocal("Off", 100, MEDIUM, "d.wav", MixNotes(""));
+    TrackId fast = m.emplaceLocal("Fast", 140, MEDIUM, "e.wav", MixNotes(""));
+    m.updateBpm(m.indexOf(fast), 280); // outside 60..200: outlier list
+
+    vector<TempoMatch> plain = m.findTempoMatches(140, TempoTolerance::bpm(3));
+    REQUIRE(plain.size() == 1);
+    CHECK(plain[0].id == straight);
+    CHECK(plain[0].pitchPercent == doctest::Approx(0.0));
+
+    TempoTolerance tol = TempoTolerance::pitchFader(8.0);
+    tol.halfDouble = true;
+    vector<TempoMatch> all = m.findTempoMatches(140, tol);
+    REQUIRE(all.size() == 4);
+    // exact matches first (|pitch| = 0), then the 72 BPM track (-2.8%)
+    CHECK(all[0].id == straight);
+    CHECK(all[0].ratio == 1.0);
+    CHECK(all[1].id == half);
+    CHECK(all[1].ratio == 2.0);
+    CHECK(all[2].id == fast);
+    CHECK(all[2].ratio == 0.5);
+    CHECK(all[3].id == nearHalf);
+    CHECK(all[3].pitchPercent == doctest::Approx(-2.7778).epsilon(0.001));
+
+    // a tight fader leaves the 72 BPM track out
+    tol.pitchRange = 2.0;
+    CHECK(m.findTempoMatches(140, tol).size() == 3);
 }
 
-TEST_CASE("Average BPM: 2 tracks")
+TEST_CASE("TrackManager::findTempoMatches agrees with a linear pass")
 {
-    Track lib[2];
-    lib[0] = makeTrack("A", "House", 120, MEDIUM);
-    lib[1] = makeTrack("B", "House", 140, HIGH);
-    CHECK(computeAverageBPM(lib, 2) == doctest::Approx(130.0));
+    TrackManager m(2);
+    for (int i = 0; i < 400; i++)
+        m.emplaceLocal("T", BPM_MIN + (i * 37) % (BPM_MAX - BPM_MIN + 1), static_cast<EnergyLevel>(i % 3), "t.wav", MixNotes(""));
+
+    TempoTolerance tol = TempoTolerance::percent(4.0);
+    tol.halfDouble = true;
+    tol.pitchRange = 3.0;
+    for (int target = BPM_MIN; target <= BPM_MAX; target += 7)
+    {
+        int expected = 0;
+        for (int i = 0; i < m.getSize(); i++)
+        {
+            int b = m.getBpmAt(i);
+            for (double ratio : { 1.0, 2.0, 0.5 })
+            {
+                double eff = b * ratio;
+                double pitch = tempoPitchPercent(target, b, ratio);
+                if (absValue(eff - target) <= target * 0.04 + 1e-9 && pitch >= -3.0 - 1e-9 && pitch <= 3.0 + 1e-9)
+                {
+                    expected++;
+                    break;
+                }
+            }
+        }
+        CHECK(static_cast<int>(m.findTempoMatches(target, tol).size()) == expected);
+    }
 }
 
-TEST_CASE("Average BPM: 3 tracks")
+TEST_CASE("TrackManager::recommendByTempo keeps the energy and key rules")
 {
-    Track lib[3];
-    lib[0] = makeTrack("A", "House", 100, LOW);
-    lib[1] = makeTrack("B", "Techno", 110, MEDIUM);
-    lib[2] = makeTrack("C", "Techno", 130, HIGH);
-    CHECK(computeAverageBPM(lib, 3) == doctest::Approx(113.3333333));
+    TrackManager m(2);
+    TrackId ok = m.emplaceLocal("Ok", 64, MEDIUM, "a.wav", MixNotes(""));
+    m.emplaceLocal("TooCalm", 64, LOW, "b.wav", MixNotes(""));
+    TrackId clash = m.emplaceLocal("Clash", 128, HIGH, "c.wav", MixNotes(""));
+    m.updateKey(m.indexOf(ok), "Am");
+    m.updateKey(m.indexOf(clash), "F#");
+
+    TempoTolerance tol = TempoTolerance::bpm(2);
+    tol.halfDouble = true;
+    vector<TempoMatch> picks = m.recommendByTempo(128, MEDIUM, tol);
+    REQUIRE(picks.size() == 2);
+    CHECK(picks[0].id == clash); // ratio 1, no pitch change
+    CHECK(picks[1].id == ok);
+    CHECK(picks[1].ratio == 2.0);
+
+    picks = m.recommendByTempo(128, MEDIUM, tol, parseHarmonicKey("Am"));
+    REQUIRE(picks.size() == 1);
+    CHECK(picks[0].id == ok);
+
+    // the fixed-window API is unchanged
+    CHECK(m.recommendNext(128, MEDIUM, 2).size() == 1);
 }
 
-TEST_CASE("Energy enum prints correct strings")
+// ==================== Library Engine: Scored Recommendations ====================
+
+TEST_CASE("TrackManager::topRecommendations ranks by the combined score")
 {
-    CHECK(energyToString(LOW) == "Low");
-    CHECK(energyToString(MEDIUM) == "Medium");
-    CHECK(energyToString(HIGH) == "High");
+    TrackManager m(2);
+    TrackId exact = m.emplaceLocal("Exact", 128, MEDIUM, "a.wav", MixNotes(""));
+    TrackId near = m.emplaceLocal("Near", 130, MEDIUM, "b.wav", MixNotes(""));
+    TrackId clash = m.emplaceLocal("Clash", 128, MEDIUM, "c.wav", MixNotes(""));
+    TrackId far = m.emplaceLocal("Far", 145, MEDIUM, "d.wav", MixNotes(""));
+    m.emplaceLocal("TooFar", 160, MEDIUM, "e.wav", MixNotes(""));
+    m.updateKey(m.indexOf(exact), "Am");
+    m.updateKey(m.indexOf(near), "C");
+    m.updateKey(m.indexOf(clash), "D#m");
+    m.updateKey(m.indexOf(far), "Am");
+
+    RecommendQuery q;
+    q.bpm = 128;
+    q.energy = MEDIUM;
+    q.key = parseHarmonicKey("Am");
+    q.k = 10;
+    vector<ScoredTrack> ranked = m.topRecommendations(q);
+    REQUIRE(ranked.size() == 4); // 160 BPM is past maxBpmDistance
+    CHECK(ranked[0].id == exact);
+    CHECK(ranked[0].bpmDistance == 0);
+    CHECK(ranked[0].keyScore == KEY_SCORE_PERFECT);
+    CHECK(ranked[1].id == near);
+    CHECK(ranked[1].keyScore == KEY_SCORE_COMPATIBLE); // relative major
+    CHECK(ranked[2].id == clash);
+    CHECK(ranked[2].keyScore == KEY_SCORE_CLASH);
+    CHECK(ranked[3].id == far);
+    for (size_t i = 1; i < ranked.size(); i++)
+        CHECK(ranked[i - 1].score >= ranked[i].score);
+
+    q.k = 2;
+    ranked = m.topRecommendations(q);
+    REQUIRE(ranked.size() == 2);
+    CHECK(ranked[1].id == near);
+
+    q.exclude = exact;
+    CHECK(m.topRecommendations(q)[0].id == near);
+
+    q.k = 0;
+    CHECK(m.topRecommendations(q).empty());
 }
 
-TEST_CASE("Genre matches: 0 matches")
+TEST_CASE("TrackManager::topRecommendations: energy delta and genre affinity")
 {
-    Track lib[2];
-    lib[0] = makeTrack("A", "House", 120, MEDIUM);
-    lib[1] = makeTrack("B", "Techno", 130, HIGH);
-
-    CHECK(countGenreMatches(lib, 2, "Trance") == 0);
+    TrackManager m(2);
+    TrackId rise = m.emplaceLocal("Rise", 126, HIGH, "a.wav", MixNotes(""));
+    TrackId drop = m.emplaceLocal("Drop", 126, LOW, "b.wav", MixNotes(""));
+    m.updateGenre(m.indexOf(drop), "Techno");
+
+    RecommendQuery q;
+    q.bpm = 126;
+    q.energy = MEDIUM;
+    vector<ScoredTrack> ranked = m.topRecommendations(q);
+    REQUIRE(ranked.size() == 2);
+    CHECK(ranked[0].id == rise); // steady or up beats a drop
+    CHECK(ranked[0].energyDelta == 1);
+    CHECK(ranked[1].energyDelta == -1);
+    CHECK_FALSE(ranked[1].genreMatch);
+
+    q.genre = "Techno";
+    q.weights.genre = 2.0;
+    ranked = m.topRecommendations(q);
+    CHECK(ranked[0].id == drop);
+    CHECK(ranked[0].genreMatch);
+
+    q.genre = "No Such Genre";
+    CHECK(m.topRecommendations(q)[0].id == rise);
+
+    TrackId stale = rise;
+    m.removeAt(m.indexOf(rise));
+    CHECK_THROWS_AS(m.scoreRecommendation(q, stale), DJException);
 }
 
-TEST_CASE("Genre matches: some matches")
+TEST_CASE("TrackManager::topRecommendations equals a full sort of every score")
 {
-    Track lib[3];
-    lib[0] = makeTrack("A", "House", 120, MEDIUM);
-    lib[1] = makeTrack("B", "House", 125, HIGH);
-    lib[2] = makeTrack("C", "Techno", 130, HIGH);
+    TrackManager m(2);
+    const char* genres[] = { "House", "Techno", "Trance" };
+    unsigned int x = 12345u;
+    auto next = [&x](int n) { x = x * 1103515245u + 12345u; return static_cast<int>((x >> 16) % static_cast<unsigned int>(n)); };
+    for (int i = 0; i < 600; i++)
+    {
+        m.emplaceLocal("T", BPM_MIN + next(BPM_MAX - BPM_MIN + 1), static_cast<EnergyLevel>(next(3)), "t.wav", MixNotes(""));
+        m.updateKey(i, keyToCamelot(next(HARMONIC_KEYS)));
+        m.updateGenre(i, genres[next(3)]);
+    }
+    m.updateBpm(5, 230); // outliers are ranked too
+    m.updateBpm(6, 40);
 
-    CHECK(countGenreMatches(lib, 3, "House") == 2);
+    for (int round = 0; round < 30; round++)
+    {
+        RecommendQuery q;
+        q.bpm = BPM_MIN + next(BPM_MAX - BPM_MIN + 1);
+        q.energy = static_cast<EnergyLevel>(next(3));
+        q.key = (round % 4 == 0) ? NO_KEY : next(HARMONIC_KEYS);
+        q.genre = genres[next(3)];
+        q.k = 1 + next(12);
+        q.maxBpmDistance = 10 + next(40);
+
+        vector<ScoredTrack> expected;
+        for (int i = 0; i < m.getSize(); i++)
+            if (absValue(m.getBpmAt(i) - q.bpm) <= q.maxBpmDistance)
+                expected.push_back(m.scoreRecommendation(q, m.idAt(i)));
+        sort(expected.begin(), expected.end(), scoredBefore);
+        if (static_cast<int>(expected.size()) > q.k)
+            expected.resize(static_cast<size_t>(q.k));
+
+        vector<ScoredTrack> got = m.topRecommendations(q);
+        REQUIRE(got.size() == expected.size());
+        for (size_t i = 0; i < got.size(); i++)
+        {
+            CHECK(got[i].id == expected[i].id);
+            CHECK(got[i].score == doctest::Approx(expected[i].score));
+        }
+    }
 }
 
-TEST_CASE("Genre matches: all matches")
+TEST_CASE("TrackManager::topRecommendations: negative weights scan the whole window")
 {
-    Track lib[3];
-    lib[0] = makeTrack("A", "House", 120, MEDIUM);
-    lib[1] = makeTrack("B", "House", 125, HIGH);
-    lib[2] = makeTrack("C", "House", 130, LOW);
+    TrackManager m(2);
+    for (int i = 0; i < 40; i++)
+    {
+        m.emplaceLocal("T", 100 + i, static_cast<EnergyLevel>(LOW + i % 3), "t.wav", MixNotes(""));
+        m.updateKey(i, keyToCamelot((i * 5) % HARMONIC_KEYS));
+        m.updateGenre(i, (i % 2 == 0) ? "House" : "Techno");
+    }
 
-    CHECK(countGenreMatches(lib, 3, "House") == 3);
+    for (int round = 0; round < 4; round++)
+    {
+        RecommendQuery q;
+        q.bpm = 110;
+        q.energy = MEDIUM;
+        q.key = parseHarmonicKey("8A");
+        q.genre = "House";
+        q.k = 3;
+        q.maxBpmDistance = 25;
+        if (round == 0) q.weights.bpm = -1.0; // farther is better
+        if (round == 1) q.weights.key = -2.0;
+        if (round == 2) q.weights.energy = -3.0;
+        if (round == 3) q.weights.genre = -5.0;
+
+        vector<ScoredTrack> expected;
+        for (int i = 0; i < m.getSize(); i++)
+            if (absValue(m.getBpmAt(i) - q.bpm) <= q.maxBpmDistance)
+                expected.push_back(m.scoreRecommendation(q, m.idAt(i)));
+        sort(expected.begin(), expected.end(), scoredBefore);
+        expected.resize(static_cast<size_t>(q.k));
+
+        vector<ScoredTrack> got = m.topRecommendations(q);
+        REQUIRE(got.size() == expected.size());
+        for (size_t i = 0; i < got.size(); i++)
+            CHECK(got[i].id == expected[i].id);
+    }
 }
 
-TEST_CASE("TrackBase is abstract: test base behavior via derived")
-{
-    LocalTrack t("Test", 128, HIGH, "x.wav", MixNotes("n"));
-    CHECK(t.getTitle() == "Test");
-    CHECK(t.getBpm() == 128);
-    CHECK(t.getEnergy() == HIGH);
-    CHECK(t.getType() == "LocalTrack");
-}
+// ==================== Library Engine: Binary Snapshot ====================
 
-TEST_CASE("Polymorphism: base pointer calls derived override (StreamTrack)")
+TEST_CASE("Binary snapshot: columns and lazy strings read in place")
 {
-    TrackBase* p = new StreamTrack("S", 140, HIGH, "Apple Music", MixNotes("hi"));
-    CHECK(p->getType() == "StreamTrack");
-
-    ostringstream oss;
-    p->print(oss);
-    string out = oss.str();
-
-    CHECK(out.find("StreamTrack") != string::npos);
-    CHECK(out.find("Apple Music") != string::npos);
-
-    delete p;
-}
+    const char* PATH = "test_snapshot_view.djsnap";
+    TrackManager m(2);
+    m.emplaceLocal("Opener", 122, LOW, "music/opener.wav", MixNotes("long intro"));
+    TrackId stream = m.emplaceStream("Peak", 128, HIGH, "Beatport", MixNotes(""));
+    m.updateKey(m.indexOf(stream), "Am");
+    m.updateGenre(m.indexOf(stream), "Techno");
+    m.emplaceLocal("Odd", 250, MEDIUM, "odd.wav", MixNotes("")); // unvalidated BPM kept exactly
+    m.saveSnapshot(PATH, 42);
 
-// -------------------- Week 06 tests (still valid) --------------------
-TEST_CASE("operator==: equal LocalTrack objects")
-{
-    LocalTrack a("Song", 128, HIGH, "song.wav", MixNotes("x"));
-    LocalTrack b("Song", 100, LOW, "song.wav", MixNotes("different notes"));
-    CHECK(a == b);
+    {
+        SnapshotView view(PATH);
+        REQUIRE(view.getSize() == 3);
+        CHECK(view.getLsn() == 42);
+        CHECK(view.getVersion() == SNAPSHOT_VERSION);
+        CHECK(view.bpmColumn()[0] == 122);
+        CHECK(view.bpmAt(2) == 250);
+        CHECK(view.energyAt(1) == HIGH);
+        CHECK(view.typeAt(0) == TAG_LOCAL);
+        CHECK(view.typeAt(1) == TAG_STREAM);
+        CHECK(view.harmonicKeyAt(1) == parseHarmonicKey("Am"));
+        CHECK(view.harmonicKeyAt(0) == NO_KEY);
+        CHECK(view.titleAt(1) == "Peak");
+        CHECK(view.genreAt(1) == "Techno");
+        CHECK(view.locationAt(0) == "music/opener.wav");
+        CHECK(view.locationAt(1) == "Beatport");
+        CHECK(view.notesAt(0) == "long intro");
+        CHECK(view.artistAt(0) == "");
+        // equal strings are stored once ("" for artist, notes, ...)
+        CHECK(view.stringIdAt(SNAP_ARTIST, 0) == view.stringIdAt(SNAP_NOTES, 1));
+        CHECK_THROWS_AS(view.bpmAt(3), out_of_range);
+        CHECK_THROWS_AS(view.stringById(static_cast<uint32_t>(view.getStringCount())), DJException);
+    }
+    remove(PATH);
 }
 
-TEST_CASE("operator==: not equal LocalTrack objects")
+TEST_CASE("Binary snapshot: loadSnapshot rebuilds the library")
 {
-    LocalTrack a("Song", 128, HIGH, "song.wav", MixNotes("x"));
-    LocalTrack b("Song", 128, HIGH, "other.wav", MixNotes("x"));
-    CHECK((a == b) == false);
-}
+    const char* PATH = "test_snapshot_load.djsnap";
+    TrackManager m(2);
+    Track t;
+    t.title = "Record";
+    t.artist = Symbol("Nina");
+    t.genre = Symbol("House");
+    t.key = Symbol("8A");
+    t.bpm = 124;
+    t.energy = MEDIUM;
+    t.notes = "drop at 1:30";
+    m.addTrackRecord(t);
+    m.emplaceStream("Streamed", 126, HIGH, "Spotify", MixNotes("vocal"));
+    m.emplaceLocal("Calm", 100, LOW, "calm.flac", MixNotes(""));
+    m.saveSnapshot(PATH);
+
+    TrackManager copy(2);
+    CHECK(copy.loadSnapshot(PATH) == 3);
+    REQUIRE(copy.getSize() == 3);
+    for (int i = 0; i < 3; i++)
+    {
+        Track a = m.getTrackRecord(i);
+        Track b = copy.getTrackRecord(i);
+        CHECK(a.title == b.title);
+        CHECK(a.artist == b.artist);
+        CHECK(a.genre == b.genre);
+        CHECK(a.key == b.key);
+        CHECK(a.bpm == b.bpm);
+        CHECK(a.energy == b.energy);
+        CHECK(a.notes == b.notes);
+        CHECK(m[i]->getType() == copy[i]->getType());
+        CHECK(m.locationAt(i) == copy.locationAt(i));
+    }
+    CHECK(copy.countGenre("House") == 1);
+    CHECK(copy.countHarmonicKey("Am") == 1);
+    CHECK(copy.averageBpm() == doctest::Approx(m.averageBpm()));
+    CHECK(copy.recommendNext(125, MEDIUM, 2).size() == 2);
 
-TEST_CASE("operator<<: outputs derived LocalTrack one-line summary")
-{
-    LocalTrack t("LocalName", 124, MEDIUM, "track.wav", MixNotes("n"));
-    ostringstream oss;
-    oss << t;
-    string s = oss.str();
-    CHECK(s.find("LocalTrack") != string::npos);
-    CHECK(s.find("LocalName") != string::npos);
-    CHECK(s.find("Path=track.wav") != string::npos);
+    // an empty library round-trips too
+    TrackManager empty(2);
+    empty.saveSnapshot(PATH);
+    CHECK(SnapshotView(PATH).getSize() == 0);
+    CHECK(empty.loadSnapshot(PATH) == 0);
+    remove(PATH);
 }
 
-TEST_CASE("operator<<: outputs derived StreamTrack one-line summary")
+TEST_CASE("Binary snapshot: bad files are rejected")
 {
-    StreamTrack t("StreamName", 140, HIGH, "Spotify", MixNotes("n"));
-    ostringstream oss;
-    oss << t;
-    string s = oss.str();
-    CHECK(s.find("StreamTrack") != string::npos);
-    CHECK(s.find("StreamName") != string::npos);
-    CHECK(s.find("Platform=Spotify") != string::npos);
+    const char* PATH = "test_snapshot_bad.djsnap";
+    CHECK_THROWS_AS(SnapshotView view("no_such_file.djsnap"), DJException);
+
+    TrackManager m(2);
+    m.emplaceLocal("A", 120, MEDIUM, "a.wav", MixNotes(""));
+    m.saveSnapshot(PATH);
+    string bytes;
+    {
+        ifstream in(PATH, ios::binary);
+        bytes.assign(istreambuf_iterator<char>(in), istreambuf_iterator<char>());
+    }
+    auto writeBytes = [&](const string& data) {
+        ofstream out(PATH, ios::binary | ios::trunc);
+        out.write(data.data(), static_cast<streamsize>(data.size()));
+    };
+
+    writeBytes(bytes.substr(0, bytes.size() - 1)); // truncated
+    CHECK_THROWS_AS(SnapshotView view(PATH), DJException);
+
+    string badMagic = bytes;
+    badMagic[0] = 'X';
+    writeBytes(badMagic);
+    CHECK_THROWS_AS(SnapshotView view(PATH), DJException);
+
+    string badVersion = bytes;
+    badVersion[offsetof(SnapshotHeader, version)] = 9;
+    writeBytes(badVersion);
+    CHECK_THROWS_AS(SnapshotView view(PATH), DJException);
+
+    writeBytes("");
+    CHECK_THROWS_AS(SnapshotView view(PATH), DJException);
+
+    // a broken row fails the load instead of building a bad track
+    SnapshotHeader h;
+    memcpy(&h, bytes.data(), sizeof(h));
+    string badEnergy = bytes;
+    badEnergy[static_cast<size_t>(h.energyOffset)] = 7;
+    writeBytes(badEnergy);
+    TrackManager target(2);
+    CHECK_THROWS_AS(target.loadSnapshot(PATH), DJException);
+    CHECK(target.getSize() == 0);
+
+    badEnergy[static_cast<size_t>(h.energyOffset)] = 0; // below LOW is just as bad
+    writeBytes(badEnergy);
+    CHECK_THROWS_AS(target.loadSnapshot(PATH), DJException);
+    CHECK(target.getSize() == 0);
+    remove(PATH);
 }
 
-// -------------------- Week 07 doctest updates (THROWS) --------------------
+// ==================== Library Engine: CSV/TSV Import ====================
 
-// TrackManager operator[]: valid index returns correct pointer
-TEST_CASE("Week07 operator[]: valid index returns correct item pointer")
+TEST_CASE("TrackImporter: CSV rows become local and stream tracks")
 {
+    WorkStealingPool workers(2);
     TrackManager m(2);
-    m += new LocalTrack("A", 120, MEDIUM, "a.wav", MixNotes(""));
-
-    TrackBase* p = m[0];
-    CHECK(p != nullptr);
-    CHECK(p->getType() == "LocalTrack");
-    CHECK(p->getTitle() == "A");
+    string csv =
+        "Title,Artist,Genre,Key,BPM,Energy,Notes,Path,Platform\r\n"
+        "Opener,Nina,House,8A,122,Low,\"cue 1, cue 2\",music/opener.wav,\r\n"
+        "\"The \"\"Big\"\" One\",DJ X,Techno,Am,127.6,high,,,Beatport\r\n"
+        "Plain , , ,,100,2,,,\r\n";
+    ImportReport report = TrackImporter(m, workers).importText(csv);
+    CHECK(report.rows == 3);
+    CHECK(report.imported == 3);
+    CHECK(report.rejectedCount == 0);
+    REQUIRE(m.getSize() == 3);
+
+    Track a = m.getTrackRecord(0);
+    CHECK(a.title == "Opener");
+    CHECK(a.artist.str() == "Nina");
+    CHECK(a.key.str() == "8A");
+    CHECK(a.energy == LOW);
+    CHECK(a.notes == "cue 1, cue 2");
+    CHECK(m[0]->getType() == "LocalTrack");
+    CHECK(m.locationAt(0) == "music/opener.wav");
+
+    Track b = m.getTrackRecord(1);
+    CHECK(b.title == "The \"Big\" One");
+    CHECK(b.bpm == 128); // 127.6 rounds
+    CHECK(b.energy == HIGH);
+    CHECK(m[1]->getType() == "StreamTrack");
+    CHECK(m.locationAt(1) == "Beatport");
+    CHECK(m.countHarmonicKey("8A") == 2); // Am == 8A
+
+    Track c = m.getTrackRecord(2);
+    CHECK(c.title == "Plain");
+    CHECK(c.artist.str() == "");
+    CHECK(c.energy == MEDIUM);
 }
 
-// TrackManager operator[]: invalid index throws
-TEST_CASE("Week07 operator[]: invalid index throws")
+TEST_CASE("TrackImporter: bad rows are rejected with their line numbers")
 {
+    WorkStealingPool workers(2);
     TrackManager m(2);
-    m += new LocalTrack("A", 120, MEDIUM, "a.wav", MixNotes(""));
+    string csv =
+        "title,bpm,energy\n"
+        "Good,120,1\n"
+        "\n"
+        "TooFast,250,1\n"
+        "Words,fast,1\n"
+        ",120,1\n"
+        "Short,120\n"
+        "\"Broken,120,1\n"
+        "Loud,120,max\n"
+        "Last,200,3";
+    ImportOptions options;
+    options.chunkBytes = 64; // many small chunks: line numbers must still add up
+    ImportReport report = TrackImporter(m, workers).importText(csv, options);
+    CHECK(report.rows == 8);
+    CHECK(report.imported == 2);
+    CHECK(report.rejectedCount == 6);
+    REQUIRE(report.rejected.size() == 6);
+    CHECK(report.rejected[0].line == 4);
+    CHECK(report.rejected[0].reason == "BPM 250 is outside 60-200");
+    CHECK(report.rejected[1].line == 5);
+    CHECK(report.rejected[2].reason == "missing title");
+    CHECK(report.rejected[3].reason == "expected 3 fields, found 2");
+    CHECK(report.rejected[4].reason == "broken quotes");
+    CHECK(report.rejected[5].line == 9);
+    CHECK(report.rejected[5].text == "Loud,120,max");
+    CHECK(m.getSize() == 2);
+    CHECK(m[1]->getTitle() == "Last");
+
+    ostringstream out;
+    report.writeTo(out);
+    CHECK(out.str().find("Imported 2 of 8 row(s), 6 rejected") == 0);
+    CHECK(out.str().find("line 4: BPM 250") != string::npos);
+
+    options.maxRejectedKept = 2;
+    TrackManager m2(2);
+    report = TrackImporter(m2, workers).importText(csv, options);
+    CHECK(report.rejectedCount == 6);
+    CHECK(report.rejected.size() == 2);
+}
 
-    CHECK_THROWS(m[99]);
-    CHECK_THROWS(m[-1]);
+TEST_CASE("TrackImporter: TSV, byte order mark and header checks")
+{
+    WorkStealingPool workers(1);
+    TrackManager m(2);
+    string tsv = "\xEF\xBB\xBF" "bpm\tname\tcomment\tunused\n126\tTabbed\tsay \"hi\", twice\tx\n";
+    ImportReport report = TrackImporter(m, workers).importText(tsv);
+    CHECK(report.imported == 1);
+    CHECK(m[0]->getTitle() == "Tabbed");
+    CHECK(m.notesAt(0) == "say \"hi\", twice");
+
+    CHECK_THROWS_AS(TrackImporter(m, workers).importText("title,artist\nA,B\n"), DJException);
+    CHECK_THROWS_AS(TrackImporter(m, workers).importText(""), DJException);
+    CHECK_THROWS_AS(TrackImporter(m, workers).importFile("no_such_file.csv"), DJException);
 }
 
-// operator+= add increases size / stores correct pointer
-TEST_CASE("operator+= add increases size and stores correct pointer")
+TEST_CASE("TrackImporter: a large file keeps file order across chunks and threads")
 {
+    const char* PATH = "test_import.csv";
+    const int N = 3000;
+    {
+        ofstream out(PATH, ios::binary);
+        out << "title,bpm,energy,platform\n";
+        for (int i = 0; i < N; i++)
+            out << "T" << i << "," << (BPM_MIN + i % 150) << "," << (1 + i % 3) << "," << (i % 2 ? "Tidal" : "") << "\n";
+    }
+    WorkStealingPool workers(3);
     TrackManager m(2);
-    CHECK(m.getSize() == 0);
+    ImportOptions options;
+    options.chunkBytes = 256;
+    ImportReport report = TrackImporter(m, workers).importFile(PATH, options);
+    remove(PATH);
+
+    int expectedRejects = 0;
+    for (int i = 0; i < N; i++)
+        if (BPM_MIN + i % 150 > BPM_MAX) expectedRejects++;
+    CHECK(report.rows == N);
+    CHECK(report.rejectedCount == expectedRejects);
+    REQUIRE(m.getSize() == N - expectedRejects);
+    int row = 0;
+    bool ordered = true;
+    for (int i = 0; i < N; i++)
+    {
+        if (BPM_MIN + i % 150 > BPM_MAX) continue;
+        ordered = ordered && m[row]->getTitle() == "T" + to_string(i);
+        row++;
+    }
+    CHECK(ordered);
+    CHECK(report.rejected[0].line == 1 + 142); // first BPM past the range (i = 141)
+}
 
-    m += new StreamTrack("B", 125, HIGH, "Spotify", MixNotes(""));
-    CHECK(m.getSize() == 1);
-    CHECK(m[0] != nullptr);
-    CHECK(m[0]->getType() == "StreamTrack");
+// ==================== Library Engine: DJ Software XML Import ====================
+
+static void writeTestFile(const char* path, const string& text)
+{
+    ofstream out(path, ios::binary);
+    out << text;
 }
 
-// operator-= valid removal deletes and shifts
-TEST_CASE("Week07 operator-= valid removal shifts properly")
+TEST_CASE("XmlLibraryImporter: Rekordbox collection tracks, playlists ignored")
 {
-    TrackManager m(2);
-    m += new LocalTrack("A", 120, MEDIUM, "a.wav", MixNotes(""));
-    m += new StreamTrack("B", 125, HIGH, "Spotify", MixNotes(""));
-    m += new LocalTrack("C", 130, HIGH, "c.wav", MixNotes(""));
+    const char* PATH = "test_rekordbox.xml";
+    writeTestFile(PATH,
+        "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+        "<DJ_PLAYLISTS Version=\"1.0.0\">\n"
+        "  <PRODUCT Name=\"rekordbox\" Version=\"6.7.4\" Company=\"AlphaTheta\"/>\n"
+        "  <!-- <COLLECTION><TRACK Name=\"Commented out\" AverageBpm=\"120\"/></COLLECTION> -->\n"
+        "  <COLLECTION Entries=\"4\">\n"
+        "    <TRACK TrackID=\"1\" Name=\"Rise &amp; Shine\" Artist=\"Nina\" Genre=\"House\" Kind=\"WAV File\"\n"
+        "           AverageBpm=\"124.00\" Tonality=\"Am\" Comments=\"a &lt;b&gt; c &#233; &#x41;\" Rating=\"255\"\n"
+        "           Location=\"file://localhost/C:/Music/Rise%20Shine.wav\">\n"
+        "      <TEMPO Inizio=\"0.025\" Bpm=\"124.00\" Metro=\"4/4\" Battito=\"1\"/>\n"
+        "      <POSITION_MARK Name=\"\" Type=\"0\" Start=\"0.025\" Num=\"0\"/>\n"
+        "    </TRACK>\n"
+        "    <TRACK TrackID=\"2\" Name='Arrow -> Down' Artist=\"DJ X\" AverageBpm=\"99.6\" Rating=\"0\" Colour=\"0x0000FF\"\n"
+        "           Location=\"file://localhost/Users/dj/Music/arrow.mp3\"/>\n"
+        "    <TRACK TrackID=\"3\" Name=\"Unanalyzed\" AverageBpm=\"0.00\"/>\n"
+        "    <TRACK TrackID=\"4\" Name=\"Warm\" AverageBpm=\"128\" Colour=\"0xFFA500\"><![CDATA[ <TRACK Name=\"x\"/> ]]></TRACK>\n"
+        "  </COLLECTION>\n"
+        "  <PLAYLISTS>\n"
+        "    <NODE Type=\"0\" Name=\"ROOT\" Count=\"1\">\n"
+        "      <NODE Name=\"Set\" Type=\"1\" KeyType=\"0\" Entries=\"1\"><TRACK Key=\"1\"/></NODE>\n"
+        "    </NODE>\n"
+        "  </PLAYLISTS>\n"
+        "</DJ_PLAYLISTS>\n");
 
-    CHECK(m.getSize() == 3);
+    TrackManager m(2);
+    XmlLibraryImporter importer(m);
+    ImportReport report = importer.importFile(PATH);
+    remove(PATH);
+
+    CHECK(importer.getFormat() == XML_REKORDBOX);
+    CHECK(report.rows == 4);
+    CHECK(report.imported == 3);
+    REQUIRE(report.rejected.size() == 1);
+    CHECK(report.rejected[0].line == 14);
+    CHECK(report.rejected[0].text == "Unanalyzed");
+    REQUIRE(m.getSize() == 3);
+
+    Track a = m.getTrackRecord(0);
+    CHECK(a.title == "Rise & Shine");
+    CHECK(a.artist.str() == "Nina");
+    CHECK(a.genre.str() == "House");
+    CHECK(a.key.str() == "Am");
+    CHECK(a.bpm == 124);
+    CHECK(a.energy == HIGH); // 5 stars
+    CHECK(a.notes == "a <b> c \xC3\xA9 A");
+    CHECK(m[0]->getType() == "LocalTrack");
+    CHECK(m.locationAt(0) == "C:/Music/Rise Shine.wav");
+
+    Track b = m.getTrackRecord(1);
+    CHECK(b.title == "Arrow -> Down");
+    CHECK(b.bpm == 100);
+    CHECK(b.energy == LOW); // blue
+    CHECK(m.locationAt(1) == "/Users/dj/Music/arrow.mp3");
+
+    CHECK(m[2]->getTitle() == "Warm");
+    CHECK(m.getTrackRecord(2).energy == HIGH); // orange
+}
 
-    m -= 1; // remove middle; should shift "C" to index 1
-    CHECK(m.getSize() == 2);
+TEST_CASE("XmlLibraryImporter: Traktor NML entries with child elements")
+{
+    const char* PATH = "test_traktor.nml";
+    writeTestFile(PATH,
+        "<?xml version=\"1.0\" encoding=\"UTF-8\" standalone=\"no\" ?>\n"
+        "<NML VERSION=\"19\"><HEAD COMPANY=\"www.native-instruments.com\" PROGRAM=\"Traktor\"></HEAD>\n"
+        "<MUSICFOLDERS></MUSICFOLDERS>\n"
+        "<COLLECTION ENTRIES=\"3\">\n"
+        "<ENTRY MODIFIED_DATE=\"2024/1/2\" TITLE=\"Deep Tool\" ARTIST=\"Rico\">\n"
+        "<LOCATION DIR=\"/:Music/:Techno/:\" FILE=\"deep tool.mp3\" VOLUME=\"D:\" VOLUMEID=\"abc\"></LOCATION>\n"
+        "<INFO BITRATE=\"320000\" GENRE=\"Techno\" COMMENT=\"peak &quot;time&quot;\" RANKING=\"153\" COLOR=\"1\"></INFO>\n"
+        "<TEMPO BPM=\"131.998\" BPM_QUALITY=\"100.000000\"></TEMPO>\n"
+        "<MUSICAL_KEY VALUE=\"21\"></MUSICAL_KEY>\n"
+        "</ENTRY>\n"
+        "<ENTRY TITLE=\"Mac Path\" ARTIST=\"\">\n"
+        "<LOCATION DIR=\"/:Users/:dj/:\" FILE=\"m.aiff\" VOLUME=\"Macintosh HD\"></LOCATION>\n"
+        "<INFO KEY=\"8A\" COLOR=\"5\"></INFO>\n"
+        "<TEMPO BPM=\"90\"></TEMPO>\n"
+        "<MUSICAL_KEY VALUE=\"3\"></MUSICAL_KEY>\n"
+        "</ENTRY>\n"
+        "<ENTRY TITLE=\"No Tempo\"><INFO RANKING=\"255\"></INFO></ENTRY>\n"
+        "</COLLECTION>\n"
+        "<PLAYLISTS><NODE TYPE=\"FOLDER\" NAME=\"$ROOT\"><SUBNODES COUNT=\"1\"><NODE TYPE=\"PLAYLIST\" NAME=\"Set\">\n"
+        "<PLAYLIST ENTRIES=\"1\" TYPE=\"LIST\"><ENTRY><PRIMARYKEY TYPE=\"TRACK\" KEY=\"D:/:Music/:Techno/:deep tool.mp3\"></PRIMARYKEY></ENTRY>\n"
+        "</PLAYLIST></NODE></SUBNODES></NODE></PLAYLISTS>\n"
+        "</NML>\n");
 
-    CHECK(m[0]->getTitle() == "A");
-    CHECK(m[1]->getTitle() == "C");
+    TrackManager m(2);
+    XmlLibraryImporter importer(m);
+    ImportReport report = importer.importFile(PATH);
+    remove(PATH);
+
+    CHECK(importer.getFormat() == XML_TRAKTOR);
+    CHECK(report.rows == 3);
+    CHECK(report.imported == 2);
+    REQUIRE(report.rejected.size() == 1);
+    CHECK(report.rejected[0].line == 17);
+    CHECK(report.rejected[0].reason == "no BPM (track not analyzed)");
+    REQUIRE(m.getSize() == 2);
+
+    Track a = m.getTrackRecord(0);
+    CHECK(a.title == "Deep Tool");
+    CHECK(a.bpm == 132);
+    CHECK(a.genre.str() == "Techno");
+    CHECK(a.notes == "peak \"time\"");
+    CHECK(a.key.str() == "Am"); // 21 = A minor
+    CHECK(a.energy == MEDIUM); // 3 stars beat the red colour
+    CHECK(m.locationAt(0) == "D:/Music/Techno/deep tool.mp3");
+
+    Track b = m.getTrackRecord(1);
+    CHECK(b.key.str() == "8A"); // INFO KEY wins over MUSICAL_KEY
+    CHECK(b.energy == LOW); // blue
+    CHECK(m.locationAt(1) == "/Users/dj/m.aiff");
 }
 
-// operator-= invalid removal throws
-TEST_CASE("Week07 operator-= invalid removal throws")
+TEST_CASE("XmlLibraryImporter: oversized elements, buffer refills and errors")
 {
+    const char* PATH = "test_big.xml";
+    const int N = 2000;
+    string notes(100000, 'n'); // one tag longer than the read buffer
+    {
+        ofstream out(PATH, ios::binary);
+        out << "<DJ_PLAYLISTS><COLLECTION>\n";
+        out << "<TRACK Name=\"Long\" AverageBpm=\"120\" Comments=\"" << notes << "\"/>\n";
+        for (int i = 0; i < N; i++)
+            out << "<TRACK Name=\"T" << i << "\" AverageBpm=\"" << (BPM_MIN + i % 140) << "\" Rating=\"" << (i % 6) * 51 << "\"/>\n";
+        out << "</COLLECTION></DJ_PLAYLISTS>";
+    }
     TrackManager m(2);
-    m += new LocalTrack("A", 120, MEDIUM, "a.wav", MixNotes(""));
-    CHECK_THROWS(m -= 5);
-    CHECK_THROWS(m -= -1);
+    ImportReport report = XmlLibraryImporter(m).importFile(PATH);
+    remove(PATH);
+    CHECK(report.imported == N + 1);
+    REQUIRE(m.getSize() == N + 1);
+    CHECK(m.notesAt(0) == notes);
+    bool ordered = true;
+    for (int i = 0; i < N; i++)
+        ordered = ordered && m[i + 1]->getTitle() == "T" + to_string(i) && m[i + 1]->getBpm() == BPM_MIN + i % 140;
+    CHECK(ordered);
+
+    CHECK(energyFromTags(0, -1) == MEDIUM);
+    CHECK(energyFromTags(2, 0xFF0000) == LOW);
+    CHECK(energyFromTags(0, 0x00FF00) == MEDIUM);
+    CHECK(energyFromTags(0, 0x808080) == MEDIUM);
+    CHECK(fileUrlToPath("file:///home/dj/a%2Bb.flac") == "/home/dj/a+b.flac");
+
+    TrackManager e(2);
+    writeTestFile(PATH, "<iTunes><dict/></iTunes>");
+    CHECK_THROWS_AS(XmlLibraryImporter(e).importFile(PATH), DJException);
+    writeTestFile(PATH, "<NML><COLLECTION><ENTRY TITLE=\"cut");
+    CHECK_THROWS_AS(XmlLibraryImporter(e).importFile(PATH), DJException);
+    // cut off between elements: every tag is whole, but the file ends early
+    writeTestFile(PATH, "<NML><COLLECTION><ENTRY TITLE=\"x\"><TEMPO BPM=\"120\"></TEMPO>");
+    CHECK_THROWS_AS(XmlLibraryImporter(e).importFile(PATH), DJException);
+    writeTestFile(PATH, "<DJ_PLAYLISTS><COLLECTION>\n<TRACK Name=\"Kept\" AverageBpm=\"120\"/>\n");
+    CHECK_THROWS_AS(XmlLibraryImporter(e).importFile(PATH), DJException);
+    REQUIRE(e.getSize() == 1); // tracks before the cut stay imported
+    e.removeAt(0);
+    writeTestFile(PATH, "<DJ_PLAYLISTS><COLLECTION></COLLECTION></DJ_PLAYLISTS>");
+    CHECK(XmlLibraryImporter(e).importFile(PATH).rows == 0); // complete, just empty
+    remove(PATH);
+    CHECK_THROWS_AS(XmlLibraryImporter(e).importFile("no_such_file.xml"), DJException);
+    CHECK(e.getSize() == 0);
 }
 
-// Function template tests
-TEST_CASE("Function template absValue works for int")
+// ==================== Library Engine: Write-Ahead Log ====================
+
+static bool sameLibrary(const TrackManager& a, const TrackManager& b)
 {
-    CHECK(absValue(-10) == 10);
-    CHECK(absValue(5) == 5);
+    if (a.getSize() != b.getSize())
+        return false;
+    for (int i = 0; i < a.getSize(); i++)
+    {
+        Track x = a.getTrackRecord(i);
+        Track y = b.getTrackRecord(i);
+        if (x.title != y.title || x.artist.str() != y.artist.str() || x.genre.str() != y.genre.str()
+            || x.key.str() != y.key.str() || x.bpm != y.bpm || x.energy != y.energy || x.notes != y.notes
+            || a[i]->getType() != b[i]->getType() || a.locationAt(i) != b.locationAt(i))
+            return false;
+    }
+    return true;
 }
 
-TEST_CASE("Function template absValue works for double")
+static void editLibrary(TrackManager& m, int first)
 {
-    CHECK(absValue(-2.5) == doctest::Approx(2.5));
-    CHECK(absValue(3.25) == doctest::Approx(3.25));
+    for (int i = 0; i < 6; i++)
+        m.emplaceLocal("Local " + to_string(first + i), 120 + i, LOW, "music/l" + to_string(i) + ".wav", MixNotes("cue " + to_string(i)));
+    m.emplaceStream("Stream " + to_string(first), 128, HIGH, "Tidal", MixNotes("stream notes"));
+    Track t;
+    t.title = "Record " + to_string(first);
+    t.artist = Symbol("Nina");
+    t.key = Symbol("8A");
+    t.bpm = 99;
+    m.addTrackRecord(t, TAG_LOCAL, "C:/Music/r.wav");
+    m.removeAt(1);             // swap-remove: the last row moves to 1
+    m.updateBpm(0, 131);
+    m.updateEnergy(2, HIGH);
+    m.updateKey(3, "Am");
+    m.updateGenre(4, "Techno");
+    m.sortByBpm();
+    m -= 0;
 }
 
-// DynamicArray now throws on invalid access/removal (Week07)
-TEST_CASE("Week07 DynamicArray<int>: store/remove/resizing still works")
+TEST_CASE("OperationLog: replaying the log rebuilds the same library")
 {
-    DynamicArray<int> a(2);
-    CHECK(a.getSize() == 0);
-    CHECK(a.getCapacity() == 2);
+    const char* LOG = "test_wal.djlog";
+    remove(LOG);
+    TrackManager live(2);
+    {
+        OperationLog log(LOG);
+        live.attachLog(&log);
+        editLibrary(live, 0);
+        live.sortBpmsBubble();
+        live.attachLog(nullptr);
+        CHECK(log.getLastLsn() == 16);
+        CHECK(log.getDurableLsn() < log.getLastLsn()); // still in the commit group
+    } // closing syncs
+
+    TrackManager replayed(2);
+    RecoveryReport report = recoverLibrary(replayed, "no_such_snapshot.djsnap", LOG);
+    CHECK(report.replayed == 16);
+    CHECK(report.lastLsn == 16);
+    CHECK_FALSE(report.tornTail);
+    CHECK(sameLibrary(live, replayed));
+    CHECK(replayed.countHarmonicKey("8A") == live.countHarmonicKey("8A"));
+
+    // reopening continues the LSNs
+    {
+        OperationLog log(LOG);
+        CHECK(log.getLastLsn() == 16);
+        live.attachLog(&log);
+        live.updateBpm(0, 140);
+        live.attachLog(nullptr);
+        CHECK(log.getLastLsn() == 17);
+    }
+    TrackManager again(2);
+    CHECK(recoverLibrary(again, "no_such_snapshot.djsnap", LOG).replayed == 17);
+    CHECK(sameLibrary(live, again));
+    remove(LOG);
+}
 
-    a.pushBack(10);
-    a.pushBack(20);
-    a.pushBack(30); // resize
-    CHECK(a.getSize() == 3);
-    CHECK(a.getCapacity() >= 3);
+TEST_CASE("OperationLog: CRC32 and torn or corrupt tails")
+{
+    CHECK(crc32Update(0, "123456789", 9) == 0xCBF43926u);
+    CHECK(crc32Update(crc32Update(0, "1234", 4), "56789", 5) == 0xCBF43926u);
 
-    CHECK(a.at(0) == 10);
-    CHECK(a.at(1) == 20);
-    CHECK(a.at(2) == 30);
+    const char* LOG = "test_wal.djlog";
+    remove(LOG);
+    TrackManager live(2);
+    {
+        OperationLog log(LOG);
+        live.attachLog(&log);
+        editLibrary(live, 0);
+        live.attachLog(nullptr);
+    }
+    uint64_t fullSize = 0;
+    {
+        ifstream in(LOG, ios::binary | ios::ate);
+        fullSize = static_cast<uint64_t>(in.tellg());
+    }
 
-    a.removeAt(1);
-    CHECK(a.getSize() == 2);
-    CHECK(a.at(0) == 10);
-    CHECK(a.at(1) == 30);
+    // a half-written record at the end (crash during a write): a whole record
+    // header announcing 48 payload bytes, of which only 7 reached the disk
+    uint32_t payload = 48;
+    uint32_t crc = 0x12345678u;
+    uint64_t nextLsn = 16;
+    string partial;
+    partial.append(reinterpret_cast<const char*>(&payload), 4);
+    partial.append(reinterpret_cast<const char*>(&crc), 4);
+    partial.append(reinterpret_cast<const char*>(&nextLsn), 8);
+    partial.push_back(static_cast<char>(LOG_ADD));
+    partial.append("garbage", 7);
+    REQUIRE(partial.size() == WAL_RECORD_HEADER + 7);
+    {
+        ofstream out(LOG, ios::binary | ios::app);
+        out.write(partial.data(), static_cast<streamsize>(partial.size()));
+    }
+    {
+        ifstream in(LOG, ios::binary | ios::ate);
+        CHECK(static_cast<uint64_t>(in.tellg()) == fullSize + partial.size());
+    }
+    TrackManager a(2);
+    RecoveryReport report = recoverLibrary(a, "no_such_snapshot.djsnap", LOG);
+    CHECK(report.tornTail);
+    CHECK(report.replayed == 15);
+    CHECK(sameLibrary(live, a));
+
+    // the full payload is there but the checksum does not match
+    {
+        string wrongCrc = partial.substr(0, WAL_RECORD_HEADER) + string(payload, 'x');
+        ofstream out("test_wal_crc.djlog", ios::binary);
+        ifstream in(LOG, ios::binary);
+        string good((istreambuf_iterator<char>(in)), istreambuf_iterator<char>());
+        good.resize(static_cast<size_t>(fullSize));
+        out.write(good.data(), static_cast<streamsize>(good.size()));
+        out.write(wrongCrc.data(), static_cast<streamsize>(wrongCrc.size()));
+    }
+    TrackManager crcCheck(2);
+    report = recoverLibrary(crcCheck, "no_such_snapshot.djsnap", "test_wal_crc.djlog");
+    CHECK(report.tornTail);
+    CHECK(report.replayed == 15);
+    CHECK(sameLibrary(live, crcCheck));
+    remove("test_wal_crc.djlog");
+
+    // opening the log cuts the tail off and appends after the last good record
+    {
+        OperationLog log(LOG);
+        CHECK(log.getLastLsn() == 15);
+        CHECK(log.getBytes() == fullSize);
+        a.attachLog(&log);
+        a.updateEnergy(0, LOW);
+        a.attachLog(nullptr);
+    }
+    TrackManager b(2);
+    report = recoverLibrary(b, "no_such_snapshot.djsnap", LOG);
+    CHECK_FALSE(report.tornTail);
+    CHECK(report.replayed == 16);
+    CHECK(sameLibrary(a, b));
+
+    // a flipped byte inside the last record fails its CRC
+    {
+        fstream io(LOG, ios::binary | ios::in | ios::out);
+        io.seekp(-1, ios::end);
+        io.put('\x7F');
+    }
+    TrackManager c(2);
+    report = recoverLibrary(c, "no_such_snapshot.djsnap", LOG);
+    CHECK(report.tornTail);
+    CHECK(report.replayed == 15);
+    CHECK(sameLibrary(live, c));
+
+    writeTestFile(LOG, "not a log at all");
+    CHECK_THROWS_AS(OperationLog log(LOG), DJException);
+    remove(LOG);
 }
 
-TEST_CASE("Week07 DynamicArray throws on invalid access/removal")
+TEST_CASE("OperationLog: group commit shares one fsync between records")
 {
-    DynamicArray<int> a(2);
-    a.pushBack(1);
+    const char* LOG = "test_wal.djlog";
+    remove(LOG);
+    LogOptions grouped;
+    grouped.groupCommitBytes = 1 << 20;
+    grouped.groupCommitMs = 60000;
+    {
+        OperationLog log(LOG, 0, grouped);
+        TrackManager m(2);
+        m.attachLog(&log);
+        for (int i = 0; i < 200; i++)
+            m.emplaceLocal("T" + to_string(i), 120, MEDIUM, "", MixNotes(""));
+        CHECK(log.getSyncCount() == 0);
+        CHECK(log.getDurableLsn() == 0);
+        log.sync();
+        CHECK(log.getSyncCount() == 1);
+        CHECK(log.getDurableLsn() == 200);
+        log.sync(); // nothing pending
+        CHECK(log.getSyncCount() == 1);
+        m.attachLog(nullptr);
+    }
 
-    CHECK_THROWS(a.at(5));
-    CHECK_THROWS(a.at(-1));
-    CHECK_THROWS(a.removeAt(2));
-    CHECK_THROWS(a.removeAt(-1));
+    LogOptions small;
+    small.groupCommitBytes = 1000;
+    small.groupCommitMs = 60000;
+    {
+        OperationLog log(LOG, 0, small);
+        CHECK(log.getLastLsn() == 200);
+        TrackManager m(2);
+        m.attachLog(&log);
+        for (int i = 0; i < 100; i++)
+            m.emplaceStream("S" + to_string(i), 125, HIGH, "Beatport", MixNotes(""));
+        CHECK(log.getSyncCount() > 1);
+        CHECK(log.getSyncCount() < 20);
+        m.attachLog(nullptr);
+    }
+
+    LogOptions each;
+    each.groupCommitBytes = 0;
+    {
+        OperationLog log(LOG, 0, each);
+        LogRecord r;
+        r.op = LOG_SORT_BPM;
+        log.append(r);
+        log.append(r);
+        CHECK(log.getSyncCount() == 2);
+        CHECK(r.lsn == 302);
+    }
+    remove(LOG);
 }
 
-TEST_CASE("Week07 DynamicArray<TrackBase*> basic works and throws on invalid")
+TEST_CASE("LogCompactor: snapshot + log recover while edits continue")
 {
-    DynamicArray<TrackBase*> a(2);
-    TrackBase* p1 = new LocalTrack("A", 120, MEDIUM, "a.wav", MixNotes(""));
-    TrackBase* p2 = new StreamTrack("B", 125, HIGH, "Spotify", MixNotes(""));
+    const char* LOG = "test_wal.djlog";
+    const char* SNAP = "test_wal.djsnap";
+    remove(LOG);
+    remove(SNAP);
+    TrackManager live(2);
+    {
+        OperationLog log(LOG);
+        live.attachLog(&log);
+        editLibrary(live, 0);
+        uint64_t bytesBefore = log.getBytes();
+
+        LogCompactor compactor;
+        CHECK(compactor.start(live, log, SNAP));
+        CHECK_FALSE(compactor.start(live, log, SNAP)); // one at a time
+        editLibrary(live, 100);                        // logged while the snapshot is written
+        CHECK(compactor.finish(log, true));
+        CHECK_FALSE(compactor.isRunning());
+        CHECK(log.getBytes() < bytesBefore + 100);     // only the 15 newer records are left
+
+        TrackManager mid(2);
+        RecoveryReport report = recoverLibrary(mid, SNAP, LOG);
+        CHECK(report.snapshotLsn == 15);
+        CHECK(report.snapshotTracks == 6);
+        CHECK(report.replayed == 15);
+        CHECK(report.skipped == 0);
+        CHECK(sameLibrary(live, mid));
+
+        compactor.compactNow(live, log, SNAP);
+        live.updateBpm(0, 77);
+        live.attachLog(nullptr);
+    }
 
-    a.pushBack(p1);
-    a.pushBack(p2);
+    TrackManager recovered(2);
+    RecoveryReport report = recoverLibrary(recovered, SNAP, LOG);
+    CHECK(report.snapshotLsn == 30);
+    CHECK(report.replayed == 1);
+    CHECK(report.lastLsn == 31);
+    CHECK(sameLibrary(live, recovered));
 
-    CHECK(a.getSize() == 2);
-    CHECK(a.at(0)->getType() == "LocalTrack");
-    CHECK(a.at(1)->getType() == "StreamTrack");
-    CHECK_THROWS(a.at(99));
-    CHECK_THROWS(a.removeAt(99));
+    // crash after the snapshot was renamed but before the log was trimmed:
+    // the covered records are skipped, not applied twice
+    {
+        OperationLog log(LOG, report.lastLsn);
+        live.attachLog(&log);
+        live.updateGenre(1, "Trance");
+        live.saveSnapshot(SNAP, log.getLastLsn());
+        live.removeAt(0);
+        live.attachLog(nullptr);
+    }
+    TrackManager afterCrash(2);
+    report = recoverLibrary(afterCrash, SNAP, LOG);
+    CHECK(report.skipped == 2);
+    CHECK(report.replayed == 1);
+    CHECK(sameLibrary(live, afterCrash));
 
-    // Clean up (template does not own pointed-to objects)
-    delete p1;
-    delete p2;
+    // a record that does not fit the library is an error, not a silent skip
+    TrackManager empty(2);
+    CHECK_THROWS_AS(recoverLibrary(empty, "no_such_snapshot.djsnap", LOG), DJException);
+    remove(LOG);
+    remove(SNAP);
 }
 
-// Week 08 tests
+// ==================== Library Engine: Fixed-Width Table Writer ====================
 
-TEST_CASE("Week08 recursive countHighEnergyRecursive: counts HIGH tracks correctly")
+// The pre-TableWriter formatting, cell by cell through iostream manipulators.
+static void referenceWeek5Table(ostream& out, const TrackManager& m)
 {
-    TrackManager m(2);
-    m += new LocalTrack("A", 120, LOW, "a.wav", MixNotes(""));
-    m += new StreamTrack("B", 125, HIGH, "Spotify", MixNotes(""));
-    m += new LocalTrack("C", 130, HIGH, "c.wav", MixNotes(""));
-    m += new StreamTrack("D", 128, MEDIUM, "Apple Music", MixNotes(""));
-
-    CHECK(m.countHighEnergyRecursive() == 2);
+    out << left
+        << "Idx "
+        << setw(TITLE_W) << "Title"
+        << setw(TYPE_W) << "Type"
+        << right << setw(6) << "BPM" << "  "
+        << left << setw(8) << "Energy"
+        << setw(NOTE_W) << "Notes"
+        << "  Source\n";
+    out << string(LINE_W, '-') << "\n";
+    for (int i = 0; i < m.getSize(); i++)
+    {
+        out << setw(4) << i << " ";
+        m.printRow(out, i); // LocalTrack/StreamTrack::print(ostream&) still use setw
+        out << "\n";
+    }
+    out << string(LINE_W, '-') << "\n";
 }
 
-TEST_CASE("Week08 recursive countHighEnergyRecursive: no HIGH tracks returns 0")
+static void referenceTrackRow(ostream& out, const Track& t)
 {
-    TrackManager m(2);
-    m += new LocalTrack("A", 120, LOW, "a.wav", MixNotes(""));
-    m += new StreamTrack("B", 125, MEDIUM, "Spotify", MixNotes(""));
-
-    CHECK(m.countHighEnergyRecursive() == 0);
+    out << left
+        << setw(TITLE_W) << t.title.substr(0, TITLE_W - 1)
+        << setw(ARTIST_W) << t.artist.str().substr(0, ARTIST_W - 1)
+        << setw(GENRE_W) << t.genre.str().substr(0, GENRE_W - 1)
+        << setw(KEY_W) << t.key.str().substr(0, KEY_W - 1)
+        << right << setw(6) << t.bpm << "  "
+        << left << setw(8) << energyToString(t.energy)
+        << setw(NOTE_W) << t.notes.substr(0, NOTE_W - 1)
+        << "\n";
 }
 
-TEST_CASE("Week08 recursive countHighEnergyRecursive: empty manager returns 0")
+static void referenceLegacyReport(ostream& out, const TrackManager& m)
 {
-    TrackManager m(2);
-    CHECK(m.countHighEnergyRecursive() == 0);
+    out << "==================== DJ SET ARCHITECT REPORT (Weeks 1-4) ====================\n";
+    out << "Tracks stored: " << m.getSize() << "\n\n";
+    out << left
+        << setw(TITLE_W) << "Title"
+        << setw(ARTIST_W) << "Artist"
+        << setw(GENRE_W) << "Genre"
+        << setw(KEY_W) << "Key"
+        << right << setw(6) << "BPM" << "  "
+        << left << setw(8) << "Energy"
+        << setw(NOTE_W) << "Notes"
+        << "\n";
+    out << string(LINE_W, '-') << "\n";
+    for (int i = 0; i < m.getSize(); i++)
+        referenceTrackRow(out, m.getTrackRecord(i));
+    out << "\nAverage BPM: " << fixed << setprecision(1) << m.averageBpm() << "\n";
+    m.snapshotAggregates().writeTo(out);
 }
 
-// ==================== Week 09 Tests: vector, sequential search, sort, binary search ====================
-
-// Test 1: vector .push_back() grows bpmList; .at() retrieves correct values
-TEST_CASE("Week09 vector: push_back stores BPMs and .at() retrieves them")
+static void fillReportLibrary(TrackManager& m)
 {
-    TrackManager m(2);
-    CHECK(m.getBpmCount() == 0); // empty vector (edge case)
-
-    m += new LocalTrack("A", 120, MEDIUM, "a.wav", MixNotes(""));
-    m += new StreamTrack("B", 135, HIGH, "Spotify", MixNotes(""));
-
-    CHECK(m.getBpmCount() == 2);    // .size() via getBpmCount()
-    CHECK(m.getBpmAt(0) == 120);    // .at(0)
-    CHECK(m.getBpmAt(1) == 135);    // .at(1)
+    m.emplaceLocal("Short", 124, LOW, "music/a.wav", MixNotes(""));
+    m.emplaceLocal(string(21, 't'), 60, MEDIUM, "", MixNotes(string(19, 'n')));
+    m.emplaceLocal(string(22, 'u'), 200, HIGH, "C:/a/very/long/path/that/goes/past/the/line.wav", MixNotes(string(20, 'm')));
+    m.emplaceStream("A title that is far too long for its column", 99, HIGH, "Beatport",
+        MixNotes("notes that are also much longer than twenty characters"));
+    m.emplaceStream("", 65535, LOW, "", MixNotes("x"));
+    m.add(new LocalTrack("Zero", 0, MEDIUM, "zero.wav", MixNotes("")));
+    Track t;
+    t.title = "Legacy";
+    t.artist = Symbol("An Artist With A Long Name");
+    t.genre = Symbol("Progressive House");
+    t.key = Symbol("F#m/Gb");
+    t.bpm = 128;
+    t.energy = HIGH;
+    t.notes = "mix out on the second breakdown";
+    m.addTrackRecord(t, TAG_STREAM, "Spotify");
+    for (int i = 0; i < 20; i++)
+        m.emplaceLocal("Row " + to_string(i), BPM_MIN + i * 7, static_cast<EnergyLevel>(1 + i % 3), "r.wav", MixNotes(i % 2 ? "cue" : ""));
 }
 
-// Test 2: sequential search — found returns index; not found or empty returns -1
-TEST_CASE("Week09 sequentialSearchBpm: found returns index, not found or empty returns -1")
+TEST_CASE("TableWriter: cells match setw/left/right")
 {
-    TrackManager empty(2);
-    CHECK(empty.sequentialSearchBpm(128) == -1); // edge case: empty vector
-
-    TrackManager m(2);
-    m += new LocalTrack("A", 120, MEDIUM, "a.wav", MixNotes(""));
-    m += new StreamTrack("B", 135, HIGH, "Spotify", MixNotes(""));
-
-    CHECK(m.sequentialSearchBpm(135) == 1);  // found
-    CHECK(m.sequentialSearchBpm(999) == -1); // not found
+    ostringstream viaWriter;
+    {
+        TableWriter w(viaWriter, 8); // tiny blocks: several writes
+        w.left("ab", 5).right("cd", 4).left(42, 4).right(-7, 4).right(1234567, 3)
+            .left("longer than width", 4).left("", 3).right("", 2).text("|").endLine();
+        w.left(TableWriter::cut("abcdef", 4), 4).left(TableWriter::cut("ab", 4), 4).repeat('-', 3).endLine();
+    }
+    ostringstream viaStream;
+    viaStream << left << setw(5) << "ab" << right << setw(4) << "cd" << left << setw(4) << 42
+              << right << setw(4) << -7 << setw(3) << 1234567 << left << setw(4) << "longer than width"
+              << setw(3) << "" << right << setw(2) << "" << "|\n"
+              << left << setw(4) << string("abcdef").substr(0, 3) << setw(4) << string("ab").substr(0, 3) << "---\n";
+    CHECK(viaWriter.str() == viaStream.str());
+
+    ostringstream later;
+    {
+        TableWriter w(later);
+        w.text("buffered").endLine();
+        CHECK(later.str().empty()); // nothing written before a block fills or flush()
+        w.flush();
+        CHECK(later.str() == "buffered\n");
+    }
 }
 
-// Test 3: bubble sort — out-of-order BPMs sorted ascending
-TEST_CASE("Week09 sortBpmsBubble: sorts BPM values into ascending order")
+TEST_CASE("TableWriter: printAll, printTrackRow and reports are byte-identical")
 {
     TrackManager m(2);
-    m += new LocalTrack("A", 150, HIGH, "a.wav", MixNotes(""));
-    m += new StreamTrack("B", 120, MEDIUM, "Spotify", MixNotes(""));
-    m += new LocalTrack("C", 135, HIGH, "c.wav", MixNotes(""));
+    fillReportLibrary(m);
 
-    m.sortBpmsBubble();
+    ostringstream table, reference;
+    m.printAll(table);
+    referenceWeek5Table(reference, m);
+    CHECK(table.str() == reference.str());
 
-    CHECK(m.getBpmAt(0) == 120);
-    CHECK(m.getBpmAt(1) == 135);
-    CHECK(m.getBpmAt(2) == 150);
-}
+    InlineTrackList list = m.toInlineList();
+    ostringstream inlineTable;
+    list.printAll(inlineTable);
+    CHECK(inlineTable.str() == reference.str());
 
-// Test 4: binary search — requires sort first; finds element or returns -1
-TEST_CASE("Week09 binarySearchBpm: finds element after sort; returns -1 if not found or empty")
-{
-    TrackManager empty(2);
-    CHECK(empty.binarySearchBpm(128) == -1); // edge case: empty vector
+    for (int i = 0; i < m.getSize(); i++)
+    {
+        ostringstream row, referenceRow;
+        Track t = m.getTrackRecord(i);
+        {
+            TableWriter w(row);
+            printTrackRow(w, t.title, t.artist.str(), t.genre.str(), t.key.str(), t.bpm, t.energy, t.notes);
+        }
+        referenceTrackRow(referenceRow, t);
+        CHECK(row.str() == referenceRow.str());
+    }
 
-    TrackManager m(2);
-    m += new LocalTrack("A", 150, HIGH, "a.wav", MixNotes(""));
-    m += new StreamTrack("B", 120, MEDIUM, "Spotify", MixNotes(""));
-    m += new LocalTrack("C", 135, HIGH, "c.wav", MixNotes(""));
+    ostringstream legacy, legacyReference;
+    writeLegacyReport(legacy, m);
+    referenceLegacyReport(legacyReference, m);
+    CHECK(legacy.str() == legacyReference.str());
 
-    m.sortBpmsBubble(); // must sort before binary search — [120, 135, 150]
-    CHECK(m.binarySearchBpm(135) == 1);  // found at index 1
-    CHECK(m.binarySearchBpm(999) == -1); // not found
+    const char* PATH = "test_report.txt";
+    saveReportToFile(m, PATH);
+    {
+        ifstream in(PATH, ios::binary);
+        ostringstream file;
+        file << in.rdbuf();
+        ostringstream expected;
+        referenceLegacyReport(expected, m);
+        CHECK(file.str() == expected.str());
+    }
+    m.saveReport(PATH);
+    {
+        ifstream in(PATH, ios::binary);
+        ostringstream file;
+        file << in.rdbuf();
+        ostringstream expected;
+        expected << "==================== DJ SET ARCHITECT REPORT (Week 7) ====================\n"
+                 << "Tracks stored: " << m.getSize() << "\n\n";
+        referenceWeek5Table(expected, m);
+        expected << "\n";
+        m.snapshotAggregates().writeTo(expected);
+        CHECK(file.str() == expected.str());
+    }
+    remove(PATH);
+
+    TrackManager empty(2);
+    ostringstream none;
+    empty.printAll(none);
+    CHECK(none.str() == "No tracks stored yet.\n");
 }
 
 #endif
\ No newline at end of file